@@ -27,6 +27,7 @@
 #endif
 
 #if defined(CONF_FAMILY_UNIX)
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/utsname.h>
@@ -91,7 +92,16 @@
 #include <emscripten/emscripten.h>
 #endif
 
-static NETSTATS network_stats = {0};
+// updated by the network threads of the server as well as the main thread
+static struct
+{
+	std::atomic<uint64_t> sent_packets;
+	std::atomic<uint64_t> sent_bytes;
+	std::atomic<uint64_t> recv_packets;
+	std::atomic<uint64_t> recv_bytes;
+	std::atomic<uint64_t> send_calls;
+	std::atomic<uint64_t> recv_calls;
+} network_stats;
 
 #define VLEN 128
 #define PACKETSIZE 1400
@@ -113,6 +123,25 @@ void net_buffer_init(NETSOCKET_BUFFER *buffer);
 void net_buffer_reinit(NETSOCKET_BUFFER *buffer);
 void net_buffer_simple(NETSOCKET_BUFFER *buffer, char **buf, int *size);
 
+#ifdef CONF_PLATFORM_LINUX
+// outgoing datagrams of one address family, sent with a single sendmmsg
+typedef struct
+{
+	int num;
+	struct mmsghdr msgs[VLEN];
+	struct iovec iovecs[VLEN];
+	char bufs[VLEN][PACKETSIZE];
+	sockaddr_storage sockaddrs[VLEN];
+} NETSOCKET_SEND_QUEUE;
+
+enum
+{
+	SEND_QUEUE_IPV4 = 0,
+	SEND_QUEUE_IPV6,
+	NUM_SEND_QUEUES,
+};
+#endif
+
 struct NETSOCKET_INTERNAL
 {
 	int type;
@@ -122,6 +151,11 @@ struct NETSOCKET_INTERNAL
 	int web_ipv6sock;
 
 	NETSOCKET_BUFFER buffer;
+
+#ifdef CONF_PLATFORM_LINUX
+	bool batching;
+	NETSOCKET_SEND_QUEUE *send_queues;
+#endif
 };
 static NETSOCKET_INTERNAL invalid_socket = {NETTYPE_INVALID, -1, -1, -1, -1};
 
@@ -442,6 +476,39 @@ int io_error(IOHANDLE io)
 	return ferror((FILE *)io);
 }
 
+const void *io_map(IOHANDLE io, size_t size)
+{
+	if(size == 0)
+	{
+		return nullptr;
+	}
+#if defined(CONF_FAMILY_WINDOWS)
+	HANDLE mapping = CreateFileMappingW((HANDLE)_get_osfhandle(_fileno((FILE *)io)), nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mapping == nullptr)
+	{
+		return nullptr;
+	}
+	// the view keeps the mapping alive
+	const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+	CloseHandle(mapping);
+	return data;
+#elif defined(CONF_PLATFORM_EMSCRIPTEN)
+	return nullptr;
+#else
+	void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno((FILE *)io), 0);
+	return data == MAP_FAILED ? nullptr : data;
+#endif
+}
+
+void io_unmap(const void *data, size_t size)
+{
+#if defined(CONF_FAMILY_WINDOWS)
+	UnmapViewOfFile(data);
+#elif !defined(CONF_PLATFORM_EMSCRIPTEN)
+	munmap(const_cast<void *>(data), size);
+#endif
+}
+
 IOHANDLE io_stdin()
 {
 	return stdin;
@@ -1579,6 +1646,9 @@ static void priv_net_close_all_sockets(NETSOCKET sock)
 	}
 #endif
 
+#if defined(CONF_PLATFORM_LINUX)
+	free(sock->send_queues);
+#endif
 	free(sock);
 }
 
@@ -1781,8 +1851,108 @@ NETSOCKET net_udp_create(NETADDR bindaddr)
 	return sock;
 }
 
+#if defined(CONF_PLATFORM_LINUX)
+static void priv_net_udp_flush_queue(NETSOCKET sock, int queue_index)
+{
+	NETSOCKET_SEND_QUEUE *queue = &sock->send_queues[queue_index];
+	const int socket = queue_index == SEND_QUEUE_IPV4 ? sock->ipv4sock : sock->ipv6sock;
+	int sent = 0;
+	while(sent < queue->num)
+	{
+		const int result = sendmmsg(socket, &queue->msgs[sent], queue->num - sent, 0);
+		network_stats.send_calls++;
+		if(result <= 0)
+		{
+			// drop the datagram that failed, like a failed sendto would, but report it at most once per second
+			static std::atomic<int64_t> s_last_error_log = 0;
+			const std::string error = net_error_message();
+			const int64_t now = time_get();
+			int64_t last_error_log = s_last_error_log.load();
+			if(now - last_error_log >= time_freq() && s_last_error_log.compare_exchange_strong(last_error_log, now))
+			{
+				log_error("net", "sendmmsg error, dropping datagram (%s)", error.c_str());
+			}
+			sent++;
+			continue;
+		}
+		sent += result;
+	}
+	queue->num = 0;
+}
+
+static int priv_net_udp_queue(NETSOCKET sock, int queue_index, const void *sa, socklen_t sa_len, const void *data, int size)
+{
+	NETSOCKET_SEND_QUEUE *queue = &sock->send_queues[queue_index];
+	if(queue->num == VLEN)
+		priv_net_udp_flush_queue(sock, queue_index);
+
+	const int i = queue->num++;
+	mem_copy(queue->bufs[i], data, size);
+	mem_copy(&queue->sockaddrs[i], sa, sa_len);
+	queue->iovecs[i].iov_len = size;
+	queue->msgs[i].msg_hdr.msg_namelen = sa_len;
+
+	network_stats.sent_bytes += size;
+	network_stats.sent_packets++;
+	return size;
+}
+#endif
+
+void net_udp_begin_batch(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(!sock->send_queues)
+	{
+		sock->send_queues = (NETSOCKET_SEND_QUEUE *)malloc(sizeof(NETSOCKET_SEND_QUEUE) * NUM_SEND_QUEUES);
+		for(int q = 0; q < NUM_SEND_QUEUES; q++)
+		{
+			NETSOCKET_SEND_QUEUE *queue = &sock->send_queues[q];
+			queue->num = 0;
+			mem_zero(queue->msgs, sizeof(queue->msgs));
+			for(int i = 0; i < VLEN; ++i)
+			{
+				queue->iovecs[i].iov_base = queue->bufs[i];
+				queue->msgs[i].msg_hdr.msg_iov = &queue->iovecs[i];
+				queue->msgs[i].msg_hdr.msg_iovlen = 1;
+				queue->msgs[i].msg_hdr.msg_name = &queue->sockaddrs[i];
+			}
+		}
+	}
+	sock->batching = true;
+#endif
+}
+
+void net_udp_end_batch(NETSOCKET sock)
+{
+#if defined(CONF_PLATFORM_LINUX)
+	if(!sock->batching)
+		return;
+	sock->batching = false;
+	for(int q = 0; q < NUM_SEND_QUEUES; q++)
+		priv_net_udp_flush_queue(sock, q);
+#endif
+}
+
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size)
 {
+#if defined(CONF_PLATFORM_LINUX)
+	if(sock->batching && size <= PACKETSIZE)
+	{
+		if(addr->type == NETTYPE_IPV4 && sock->ipv4sock >= 0)
+		{
+			sockaddr_in sa;
+			netaddr_to_sockaddr_in(addr, &sa);
+			return priv_net_udp_queue(sock, SEND_QUEUE_IPV4, &sa, sizeof(sa), data, size);
+		}
+		if(addr->type == NETTYPE_IPV6 && sock->ipv6sock >= 0)
+		{
+			sockaddr_in6 sa;
+			netaddr_to_sockaddr_in6(addr, &sa);
+			return priv_net_udp_queue(sock, SEND_QUEUE_IPV6, &sa, sizeof(sa), data, size);
+		}
+	}
+#endif
+
 	int d = -1;
 
 	if(addr->type & NETTYPE_IPV4)
@@ -1803,6 +1973,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 			}
 
 			d = sendto(sock->ipv4sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			network_stats.send_calls++;
 		}
 		else
 		{
@@ -1851,6 +2022,7 @@ int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size
 			}
 
 			d = sendto(sock->ipv6sock, (const char *)data, size, 0, (sockaddr *)&sa, sizeof(sa));
+			network_stats.send_calls++;
 		}
 		else
 		{
@@ -1940,6 +2112,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		{
 			net_buffer_reinit(&sock->buffer);
 			sock->buffer.size = recvmmsg(sock->ipv4sock, sock->buffer.msgs, VLEN, 0, NULL);
+			network_stats.recv_calls++;
 			sock->buffer.pos = 0;
 		}
 	}
@@ -1950,6 +2123,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		{
 			net_buffer_reinit(&sock->buffer);
 			sock->buffer.size = recvmmsg(sock->ipv6sock, sock->buffer.msgs, VLEN, 0, NULL);
+			network_stats.recv_calls++;
 			sock->buffer.pos = 0;
 		}
 	}
@@ -1969,6 +2143,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		sockaddr_storage recv_addr;
 		socklen_t fromlen = sizeof(recv_addr);
 		bytes = recvfrom(sock->ipv4sock, sock->buffer.buf, sizeof(sock->buffer.buf), 0, (sockaddr *)&recv_addr, &fromlen);
+		network_stats.recv_calls++;
 		*data = (unsigned char *)sock->buffer.buf;
 		if(bytes > 0)
 		{
@@ -1983,6 +2158,7 @@ int net_udp_recv(NETSOCKET sock, NETADDR *addr, unsigned char **data)
 		sockaddr_storage recv_addr;
 		socklen_t fromlen = sizeof(recv_addr);
 		bytes = recvfrom(sock->ipv6sock, sock->buffer.buf, sizeof(sock->buffer.buf), 0, (sockaddr *)&recv_addr, &fromlen);
+		network_stats.recv_calls++;
 		*data = (unsigned char *)sock->buffer.buf;
 		if(bytes > 0)
 		{
@@ -3182,7 +3358,12 @@ int str_time_float(float secs, int format, char *buffer, int buffer_size)
 
 void net_stats(NETSTATS *stats_inout)
 {
-	*stats_inout = network_stats;
+	stats_inout->sent_packets = network_stats.sent_packets.load();
+	stats_inout->sent_bytes = network_stats.sent_bytes.load();
+	stats_inout->recv_packets = network_stats.recv_packets.load();
+	stats_inout->recv_bytes = network_stats.recv_bytes.load();
+	stats_inout->send_calls = network_stats.send_calls.load();
+	stats_inout->recv_calls = network_stats.recv_calls.load();
 }
 
 int str_utf8_comp_nocase(const char *a, const char *b)
@@ -432,6 +432,31 @@ int io_sync(IOHANDLE io);
  */
 int io_error(IOHANDLE io);
 
+/**
+ * Maps the beginning of a file into memory for reading.
+ *
+ * @ingroup File-IO
+ *
+ * @param io Handle to the file.
+ * @param size Number of bytes to map, must not be larger than the file.
+ *
+ * @return Pointer to the mapped memory, or `nullptr` on failure or if the platform does not support it.
+ *
+ * @remark The memory must be unmapped with @link io_unmap @endlink before the file is closed.
+ * @remark Reading the memory after the file was truncated by another process may crash on some platforms.
+ */
+const void *io_map(IOHANDLE io, size_t size);
+
+/**
+ * Unmaps memory that was mapped with @link io_map @endlink.
+ *
+ * @ingroup File-IO
+ *
+ * @param data Pointer to the mapped memory.
+ * @param size Number of bytes that were mapped.
+ */
+void io_unmap(const void *data, size_t size);
+
 /**
  * Returns a handle for the standard input.
  *
@@ -1028,6 +1053,28 @@ NETSOCKET net_udp_create(NETADDR bindaddr);
  */
 int net_udp_send(NETSOCKET sock, const NETADDR *addr, const void *data, int size);
 
+/**
+ * Starts queueing packets sent over an UDP socket instead of sending them immediately.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ *
+ * @remark The queued packets are sent with as few system calls as possible by @link net_udp_end_batch @endlink.
+ * @remark Only has an effect on Linux, elsewhere packets are always sent immediately.
+ * @remark Broadcasts and websocket packets are never queued.
+ */
+void net_udp_begin_batch(NETSOCKET sock);
+
+/**
+ * Sends all packets queued since @link net_udp_begin_batch @endlink and stops queueing.
+ *
+ * @ingroup Network-UDP
+ *
+ * @param sock Socket to use.
+ */
+void net_udp_end_batch(NETSOCKET sock);
+
 /**
  * Receives a packet over an UDP socket.
  *
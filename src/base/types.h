@@ -94,6 +94,8 @@ typedef struct NETSTATS
 	uint64_t sent_bytes;
 	uint64_t recv_packets;
 	uint64_t recv_bytes;
+	uint64_t send_calls;
+	uint64_t recv_calls;
 } NETSTATS;
 
 #if defined(CONF_FAMILY_WINDOWS)
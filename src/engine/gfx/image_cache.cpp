@@ -0,0 +1,152 @@
+#include "image_cache.h"
+
+#include <base/system.h>
+
+#include <engine/storage.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+static constexpr char IMAGE_CACHE_MAGIC[4] = {'I', 'M', 'G', 'C'};
+
+// The entries are only read on the machine that wrote them, so the values are stored in native byte order
+class CImageCacheHeader
+{
+public:
+	char m_aMagic[sizeof(IMAGE_CACHE_MAGIC)];
+	int32_t m_Version;
+	uint32_t m_NumImages;
+	uint32_t m_ExtraSize;
+};
+
+class CImageCacheImageHeader
+{
+public:
+	uint32_t m_Width;
+	uint32_t m_Height;
+	int32_t m_Format;
+};
+
+CImageCache::CImageCache(IStorage *pStorage, const char *pFolder, int Version) :
+	m_pStorage(pStorage),
+	m_Version(Version)
+{
+	str_copy(m_aFolder, pFolder);
+}
+
+void CImageCache::EntryPath(const SHA256_DIGEST &Sha256, char *pBuffer, size_t BufferSize) const
+{
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+	str_format(pBuffer, BufferSize, "%s/%s_%d.raw", m_aFolder, aSha256, m_Version);
+}
+
+bool CImageCache::Load(const SHA256_DIGEST &Sha256, CImageInfo *pImages, size_t NumImages, void *pExtra, size_t ExtraSize) const
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	EntryPath(Sha256, aPath, sizeof(aPath));
+	if(!m_pStorage->FileExists(aPath, IStorage::TYPE_SAVE))
+		return false;
+
+	void *pFileData;
+	unsigned FileSize;
+	if(!m_pStorage->ReadFile(aPath, IStorage::TYPE_SAVE, &pFileData, &FileSize))
+		return false;
+
+	const uint8_t *pData = static_cast<const uint8_t *>(pFileData);
+	size_t Offset = 0;
+	const auto &&Read = [&](void *pDest, size_t Size) {
+		if(Size > FileSize - Offset)
+			return false;
+		if(Size == 0)
+			return true;
+		mem_copy(pDest, pData + Offset, Size);
+		Offset += Size;
+		return true;
+	};
+
+	// Validate the whole entry before allocating any images, a write may have been interrupted
+	bool Valid = false;
+	CImageCacheHeader Header;
+	std::vector<CImageCacheImageHeader> vImageHeaders(NumImages);
+	if(Read(&Header, sizeof(Header)) &&
+		mem_comp(Header.m_aMagic, IMAGE_CACHE_MAGIC, sizeof(IMAGE_CACHE_MAGIC)) == 0 &&
+		Header.m_Version == m_Version &&
+		Header.m_NumImages == NumImages &&
+		Header.m_ExtraSize == ExtraSize &&
+		Read(vImageHeaders.data(), NumImages * sizeof(CImageCacheImageHeader)) &&
+		Read(pExtra, ExtraSize))
+	{
+		size_t DataSize = 0;
+		Valid = true;
+		for(const CImageCacheImageHeader &ImageHeader : vImageHeaders)
+		{
+			if(ImageHeader.m_Format != CImageInfo::FORMAT_RGB && ImageHeader.m_Format != CImageInfo::FORMAT_RGBA &&
+				ImageHeader.m_Format != CImageInfo::FORMAT_R && ImageHeader.m_Format != CImageInfo::FORMAT_RA)
+			{
+				Valid = false;
+				break;
+			}
+			DataSize += (size_t)ImageHeader.m_Width * ImageHeader.m_Height * CImageInfo::PixelSize((CImageInfo::EImageFormat)ImageHeader.m_Format);
+		}
+		Valid = Valid && DataSize == FileSize - Offset;
+	}
+
+	if(Valid)
+	{
+		for(size_t i = 0; i < NumImages; i++)
+		{
+			CImageInfo &Image = pImages[i];
+			Image.m_Width = vImageHeaders[i].m_Width;
+			Image.m_Height = vImageHeaders[i].m_Height;
+			Image.m_Format = (CImageInfo::EImageFormat)vImageHeaders[i].m_Format;
+			Image.m_pData = static_cast<uint8_t *>(malloc(Image.DataSize()));
+			Read(Image.m_pData, Image.DataSize());
+		}
+	}
+	free(pFileData);
+	return Valid;
+}
+
+bool CImageCache::Save(const SHA256_DIGEST &Sha256, const CImageInfo *pImages, size_t NumImages, const void *pExtra, size_t ExtraSize) const
+{
+	char aPath[IO_MAX_PATH_LENGTH];
+	EntryPath(Sha256, aPath, sizeof(aPath));
+
+	// Write to a temporary file first, so loading never sees a partial entry written by another thread
+	static std::atomic<int> s_NextTemporary = 0;
+	char aTemporaryPath[IO_MAX_PATH_LENGTH];
+	str_format(aTemporaryPath, sizeof(aTemporaryPath), "%s.%d.%d.tmp", aPath, pid(), s_NextTemporary.fetch_add(1));
+
+	IOHANDLE File = m_pStorage->OpenFile(aTemporaryPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	if(!File)
+		return false;
+
+	CImageCacheHeader Header;
+	mem_copy(Header.m_aMagic, IMAGE_CACHE_MAGIC, sizeof(IMAGE_CACHE_MAGIC));
+	Header.m_Version = m_Version;
+	Header.m_NumImages = NumImages;
+	Header.m_ExtraSize = ExtraSize;
+	bool Success = io_write(File, &Header, sizeof(Header)) == sizeof(Header);
+	for(size_t i = 0; i < NumImages && Success; i++)
+	{
+		CImageCacheImageHeader ImageHeader;
+		ImageHeader.m_Width = pImages[i].m_Width;
+		ImageHeader.m_Height = pImages[i].m_Height;
+		ImageHeader.m_Format = pImages[i].m_Format;
+		Success = io_write(File, &ImageHeader, sizeof(ImageHeader)) == sizeof(ImageHeader);
+	}
+	Success = Success && io_write(File, pExtra, ExtraSize) == ExtraSize;
+	for(size_t i = 0; i < NumImages && Success; i++)
+	{
+		Success = io_write(File, pImages[i].m_pData, pImages[i].DataSize()) == pImages[i].DataSize();
+	}
+	Success = io_close(File) == 0 && Success;
+
+	if(Success)
+		Success = m_pStorage->RenameFile(aTemporaryPath, aPath, IStorage::TYPE_SAVE);
+	if(!Success)
+		m_pStorage->RemoveFile(aTemporaryPath, IStorage::TYPE_SAVE);
+	return Success;
+}
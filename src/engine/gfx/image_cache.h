@@ -0,0 +1,59 @@
+#ifndef ENGINE_GFX_IMAGE_CACHE_H
+#define ENGINE_GFX_IMAGE_CACHE_H
+
+#include <base/hash.h>
+#include <base/types.h>
+
+#include <engine/image.h>
+
+#include <cstddef>
+
+class IStorage;
+
+/**
+ * Keeps processed images in a folder of the user directory, so they do not
+ * have to be decoded and processed again when the source file did not change.
+ *
+ * Entries are keyed by the SHA256 of the source file and the version of the
+ * processing. They are stored as raw pixel data that is read with a single
+ * file read. The functions can be called from any thread.
+ */
+class CImageCache
+{
+public:
+	/**
+	 * @param pStorage The storage to read and write the entries with.
+	 * @param pFolder Folder in the user directory, which must exist.
+	 * @param Version Version of the processing, must be increased whenever the processed images change.
+	 */
+	CImageCache(IStorage *pStorage, const char *pFolder, int Version);
+
+	/**
+	 * Loads the images of an entry.
+	 *
+	 * @param Sha256 Hash of the source file.
+	 * @param pImages Receives the images, which have to be freed by the caller.
+	 * @param NumImages Number of images the entry must have.
+	 * @param pExtra Receives additional data stored with the images.
+	 * @param ExtraSize Size of the additional data the entry must have.
+	 *
+	 * @return `true` on success, `false` if there is no valid entry.
+	 */
+	bool Load(const SHA256_DIGEST &Sha256, CImageInfo *pImages, size_t NumImages, void *pExtra, size_t ExtraSize) const;
+
+	/**
+	 * Stores the images of an entry, replacing an existing entry.
+	 *
+	 * @return `true` on success, `false` if the entry could not be written.
+	 */
+	bool Save(const SHA256_DIGEST &Sha256, const CImageInfo *pImages, size_t NumImages, const void *pExtra, size_t ExtraSize) const;
+
+private:
+	IStorage *m_pStorage;
+	char m_aFolder[IO_MAX_PATH_LENGTH];
+	int m_Version;
+
+	void EntryPath(const SHA256_DIGEST &Sha256, char *pBuffer, size_t BufferSize) const;
+};
+
+#endif // ENGINE_GFX_IMAGE_CACHE_H
@@ -8,6 +8,8 @@
 #include <base/hash.h>
 #include <base/types.h>
 
+#include <vector>
+
 enum
 {
 	MAX_MAP_LENGTH = 128
@@ -22,6 +24,7 @@ public:
 	virtual void *GetDataSwapped(int Index) = 0;
 	virtual const char *GetDataString(int Index) = 0;
 	virtual void UnloadData(int Index) = 0;
+	virtual void LoadData(const std::vector<int> &vIndices) = 0; // loads the data in parallel and waits for it, access it with GetData
 	virtual int NumData() const = 0;
 
 	virtual int GetItemSize(int Index) = 0;
@@ -22,6 +22,7 @@
 #include <type_traits>
 
 struct CAntibotRoundData;
+class CTickProfiler;
 
 // When recording a demo on the server, the ClientId -1 is used
 enum
@@ -246,6 +247,13 @@ public:
 
 	virtual void SnapSetStaticsize(int ItemType, int Size) = 0;
 
+	// items snapped between these calls go into a shared layer instead of the current snapshot
+	virtual void SnapBeginShared() = 0;
+	virtual void SnapEndShared() = 0;
+	virtual int SnapNumShared() const = 0;
+	// copies items of the shared layer into the current snapshot, returns false if the snapshot is full
+	virtual bool SnapCopyShared(int FirstItem, int NumItems) = 0;
+
 	enum
 	{
 		RCON_CID_SERV = -1,
@@ -295,6 +303,8 @@ public:
 	virtual const char *GetMapName() const = 0;
 
 	virtual bool IsSixup(int ClientId) const = 0;
+
+	virtual CTickProfiler *TickProfiler() = 0;
 };
 
 class IGameServer : public IInterface
@@ -253,6 +253,7 @@ CServer::CServer()
 	m_aCurrentMap[0] = '\0';
 	m_pCurrentMapName = m_aCurrentMap;
 	m_aMapDownloadUrl[0] = '\0';
+	m_aTickProfilerCsvFile[0] = '\0';
 
 	m_RconClientId = IServer::RCON_CID_SERV;
 	m_RconAuthLevel = AUTHED_ADMIN;
@@ -971,6 +972,31 @@ void CServer::SendMsgRaw(int ClientId, const void *pData, int Size, int Flags)
 	m_NetServer.Send(&Packet);
 }
 
+class CSnapshotDeltaJob : public IJob
+{
+	CServer *m_pServer;
+	int m_ClientId;
+	CSnapshotDelta *m_pSnapshotDelta;
+	CServer::CSnapshotBuffers *m_pBuffers;
+	SEMAPHORE *m_pDone;
+
+	void Run() override
+	{
+		m_pServer->CreateSnapshotDelta(m_ClientId, m_pSnapshotDelta, m_pBuffers);
+		sphore_signal(m_pDone);
+	}
+
+public:
+	CSnapshotDeltaJob(CServer *pServer, int ClientId, CSnapshotDelta *pSnapshotDelta, CServer::CSnapshotBuffers *pBuffers, SEMAPHORE *pDone) :
+		m_pServer(pServer),
+		m_ClientId(ClientId),
+		m_pSnapshotDelta(pSnapshotDelta),
+		m_pBuffers(pBuffers),
+		m_pDone(pDone)
+	{
+	}
+};
+
 void CServer::DoSnapshot()
 {
 	bool IsGlobalSnap = Config()->m_SvHighBandwidth || (m_CurrentGameTick % 2) == 0;
@@ -979,11 +1005,15 @@ void CServer::DoSnapshot()
 	{
 		// create snapshot for demo recording
 		char aData[CSnapshot::MAX_SIZE];
+		int SnapshotSize;
 
 		// build snap and possibly add some messages
-		m_SnapshotBuilder.Init();
-		GameServer()->OnSnap(-1, IsGlobalSnap);
-		int SnapshotSize = m_SnapshotBuilder.Finish(aData);
+		{
+			CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_SNAP);
+			m_SnapshotBuilder.Init();
+			GameServer()->OnSnap(-1, IsGlobalSnap);
+			SnapshotSize = m_SnapshotBuilder.Finish(aData);
+		}
 
 		// write snapshot
 		if(m_aDemoRecorder[RECORDER_MANUAL].IsRecording())
@@ -992,6 +1022,10 @@ void CServer::DoSnapshot()
 			m_aDemoRecorder[RECORDER_AUTO].RecordSnapshot(Tick(), aData, SnapshotSize);
 	}
 
+	const bool ParallelSnapshots = m_SnapshotThreads > 0;
+	int aSnapshotClients[MAX_CLIENTS];
+	int NumSnapshotClients = 0;
+
 	// create snapshots for all clients
 	for(int i = 0; i < MaxClients(); i++)
 	{
@@ -1012,104 +1046,177 @@ void CServer::DoSnapshot()
 			continue;
 
 		{
-			m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
+			CSnapshotBuffers *pBuffers = &m_vSnapshotBuffers[ParallelSnapshots ? i : 0];
+			{
+				CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_SNAP);
+				m_SnapshotBuilder.Init(m_aClients[i].m_Sixup);
 
-			// only snap events on global ticks
-			GameServer()->OnSnap(i, IsGlobalSnap);
+				// only snap events on global ticks
+				GameServer()->OnSnap(i, IsGlobalSnap);
 
-			// finish snapshot
-			char aData[CSnapshot::MAX_SIZE];
-			CSnapshot *pData = (CSnapshot *)aData; // Fix compiler warning for strict-aliasing
-			int SnapshotSize = m_SnapshotBuilder.Finish(pData);
+				// finish snapshot
+				pBuffers->m_DataSize = m_SnapshotBuilder.Finish(pBuffers->m_aData);
+			}
 
-			if(m_aDemoRecorder[i].IsRecording())
+			if(ParallelSnapshots)
 			{
-				// write snapshot
-				m_aDemoRecorder[i].RecordSnapshot(Tick(), aData, SnapshotSize);
+				// the delta is created by a worker while the game snaps the next clients
+				m_SnapshotJobPool.Add(std::make_shared<CSnapshotDeltaJob>(this, i, m_apSnapshotDeltas[m_aClients[i].m_Sixup].get(), pBuffers, &m_SnapshotJobsDone));
+				aSnapshotClients[NumSnapshotClients++] = i;
 			}
+			else
+			{
+				m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
+				m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
+				CreateSnapshotDelta(i, &m_SnapshotDelta, pBuffers);
+				SendSnapshot(i, pBuffers);
+			}
+		}
+	}
 
-			int Crc = pData->Crc();
+	// wait until the deltas of all clients are done, then send them on the main thread
+	for(int i = 0; i < NumSnapshotClients; i++)
+	{
+		sphore_wait(&m_SnapshotJobsDone);
+	}
+	for(int i = 0; i < NumSnapshotClients; i++)
+	{
+		SendSnapshot(aSnapshotClients[i], &m_vSnapshotBuffers[aSnapshotClients[i]]);
+	}
 
-			// remove old snapshots
-			// keep 3 seconds worth of snapshots
-			m_aClients[i].m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
+	if(IsGlobalSnap)
+	{
+		GameServer()->OnPostGlobalSnap();
+	}
+}
 
-			// save the snapshot
-			m_aClients[i].m_Snapshots.Add(m_CurrentGameTick, time_get(), SnapshotSize, pData, 0, nullptr);
+void CServer::CreateSnapshotDelta(int ClientId, CSnapshotDelta *pSnapshotDelta, CSnapshotBuffers *pBuffers)
+{
+	CClient &Client = m_aClients[ClientId];
+	const CSnapshot *pData = (CSnapshot *)pBuffers->m_aData;
+	pBuffers->m_Crc = pData->Crc();
 
-			// find snapshot that we can perform delta against
-			int DeltaTick = -1;
-			const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
-			{
-				int DeltashotSize = m_aClients[i].m_Snapshots.Get(m_aClients[i].m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr);
-				if(DeltashotSize >= 0)
-					DeltaTick = m_aClients[i].m_LastAckedSnapshot;
-				else
-				{
-					// no acked package found, force client to recover rate
-					if(m_aClients[i].m_SnapRate == CClient::SNAPRATE_FULL)
-						m_aClients[i].m_SnapRate = CClient::SNAPRATE_RECOVER;
-				}
-			}
+	// remove old snapshots
+	// keep 3 seconds worth of snapshots
+	Client.m_Snapshots.PurgeUntil(m_CurrentGameTick - TickSpeed() * 3);
 
-			// create delta
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, m_aClients[i].m_Sixup);
-			m_SnapshotDelta.SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, m_aClients[i].m_Sixup);
-			char aDeltaData[CSnapshot::MAX_SIZE];
-			int DeltaSize = m_SnapshotDelta.CreateDelta(pDeltashot, pData, aDeltaData);
+	// save the snapshot
+	Client.m_Snapshots.Add(m_CurrentGameTick, time_get(), pBuffers->m_DataSize, pData, 0, nullptr);
 
-			if(DeltaSize)
-			{
-				// compress it
-				const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+	// find snapshot that we can perform delta against
+	pBuffers->m_DeltaTick = -1;
+	const CSnapshot *pDeltashot = CSnapshot::EmptySnapshot();
+	const CSnapshotItemTable *pDeltashotTable = nullptr;
+	{
+		// the acked snapshot is usually the base for several deltas, so its item table is kept
+		int DeltashotSize = Client.m_Snapshots.Get(Client.m_LastAckedSnapshot, nullptr, &pDeltashot, nullptr, &pDeltashotTable);
+		if(DeltashotSize >= 0)
+			pBuffers->m_DeltaTick = Client.m_LastAckedSnapshot;
+	}
 
-				char aCompData[CSnapshot::MAX_SIZE];
-				SnapshotSize = CVariableInt::Compress(aDeltaData, DeltaSize, aCompData, sizeof(aCompData));
-				int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+	// create delta
+	{
+		CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_SNAP_DELTA);
+		pBuffers->m_DeltaSize = pSnapshotDelta->CreateDelta(pDeltashot, pData, pBuffers->m_aDeltaData, pDeltashotTable);
+	}
 
-				for(int n = 0, Left = SnapshotSize; Left > 0; n++)
-				{
-					int Chunk = Left < MaxSize ? Left : MaxSize;
-					Left -= Chunk;
+	// compress it
+	pBuffers->m_CompSize = 0;
+	if(pBuffers->m_DeltaSize)
+	{
+		CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_SNAP_COMPRESS);
+		pBuffers->m_CompSize = CVariableInt::Compress(pBuffers->m_aDeltaData, pBuffers->m_DeltaSize, pBuffers->m_aCompData, sizeof(pBuffers->m_aCompData));
+	}
+}
 
-					if(NumPackets == 1)
-					{
-						CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-					else
-					{
-						CMsgPacker Msg(NETMSG_SNAP, true);
-						Msg.AddInt(m_CurrentGameTick);
-						Msg.AddInt(m_CurrentGameTick - DeltaTick);
-						Msg.AddInt(NumPackets);
-						Msg.AddInt(n);
-						Msg.AddInt(Crc);
-						Msg.AddInt(Chunk);
-						Msg.AddRaw(&aCompData[n * MaxSize], Chunk);
-						SendMsg(&Msg, MSGFLAG_FLUSH, i);
-					}
-				}
+void CServer::SendSnapshot(int ClientId, const CSnapshotBuffers *pBuffers)
+{
+	CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_NET_SEND);
+
+	// no acked package found, force client to recover rate. This is done here
+	// because the delta may have been created by a worker while the main thread reads the snap rate.
+	if(pBuffers->m_DeltaTick < 0 && m_aClients[ClientId].m_SnapRate == CClient::SNAPRATE_FULL)
+		m_aClients[ClientId].m_SnapRate = CClient::SNAPRATE_RECOVER;
+
+	if(m_aDemoRecorder[ClientId].IsRecording())
+	{
+		// write snapshot
+		m_aDemoRecorder[ClientId].RecordSnapshot(Tick(), pBuffers->m_aData, pBuffers->m_DataSize);
+	}
+
+	if(pBuffers->m_DeltaSize)
+	{
+		const int MaxSize = MAX_SNAPSHOT_PACKSIZE;
+		const int SnapshotSize = pBuffers->m_CompSize;
+		int NumPackets = (SnapshotSize + MaxSize - 1) / MaxSize;
+
+		for(int n = 0, Left = SnapshotSize; Left > 0; n++)
+		{
+			int Chunk = Left < MaxSize ? Left : MaxSize;
+			Left -= Chunk;
+
+			if(NumPackets == 1)
+			{
+				CMsgPacker Msg(NETMSG_SNAPSINGLE, true);
+				Msg.AddInt(m_CurrentGameTick);
+				Msg.AddInt(m_CurrentGameTick - pBuffers->m_DeltaTick);
+				Msg.AddInt(pBuffers->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pBuffers->m_aCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
 			}
 			else
 			{
-				CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+				CMsgPacker Msg(NETMSG_SNAP, true);
 				Msg.AddInt(m_CurrentGameTick);
-				Msg.AddInt(m_CurrentGameTick - DeltaTick);
-				SendMsg(&Msg, MSGFLAG_FLUSH, i);
+				Msg.AddInt(m_CurrentGameTick - pBuffers->m_DeltaTick);
+				Msg.AddInt(NumPackets);
+				Msg.AddInt(n);
+				Msg.AddInt(pBuffers->m_Crc);
+				Msg.AddInt(Chunk);
+				Msg.AddRaw(&pBuffers->m_aCompData[n * MaxSize], Chunk);
+				SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
 			}
 		}
 	}
+	else
+	{
+		CMsgPacker Msg(NETMSG_SNAPEMPTY, true);
+		Msg.AddInt(m_CurrentGameTick);
+		Msg.AddInt(m_CurrentGameTick - pBuffers->m_DeltaTick);
+		SendMsg(&Msg, MSGFLAG_FLUSH, ClientId);
+	}
+}
 
-	if(IsGlobalSnap)
+void CServer::InitSnapshotThreads()
+{
+	m_SnapshotThreads = Config()->m_SvSnapshotThreads;
+	if(m_SnapshotThreads <= 0)
 	{
-		GameServer()->OnPostGlobalSnap();
+		m_vSnapshotBuffers.resize(1);
+		return;
+	}
+
+	m_vSnapshotBuffers.resize(MAX_CLIENTS);
+	for(int Sixup = 0; Sixup < 2; Sixup++)
+	{
+		m_apSnapshotDeltas[Sixup] = std::make_unique<CSnapshotDelta>(m_SnapshotDelta);
+		m_apSnapshotDeltas[Sixup]->SetStaticsize(protocol7::NETEVENTTYPE_SOUNDWORLD, Sixup);
+		m_apSnapshotDeltas[Sixup]->SetStaticsize(protocol7::NETEVENTTYPE_DAMAGE, Sixup);
 	}
+	sphore_init(&m_SnapshotJobsDone);
+	m_SnapshotJobPool.Init(m_SnapshotThreads);
+	log_info("server", "creating snapshot deltas with %d threads", m_SnapshotThreads);
+}
+
+void CServer::ShutdownSnapshotThreads()
+{
+	if(m_SnapshotThreads <= 0)
+		return;
+
+	m_SnapshotJobPool.Shutdown();
+	sphore_destroy(&m_SnapshotJobsDone);
+	m_SnapshotThreads = 0;
 }
 
 int CServer::ClientRejoinCallback(int ClientId, void *pUser)
@@ -2732,9 +2839,14 @@ void CServer::UpdateServerInfo(bool Resend)
 
 void CServer::PumpNetwork(bool PacketWaiting)
 {
+	CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_NET_RECV);
 	CNetChunk Packet;
 	SECURITY_TOKEN ResponseToken;
 
+	// answer everything received in this pump with as few system calls as possible
+	if(Config()->m_SvNetBatch)
+		m_NetServer.BeginBatch();
+
 	m_NetServer.Update();
 
 	if(PacketWaiting)
@@ -2827,6 +2939,8 @@ void CServer::PumpNetwork(bool PacketWaiting)
 		}
 	}
 
+	m_NetServer.EndBatch();
+
 	m_ServerBan.Update();
 	m_Econ.Update();
 }
@@ -3072,6 +3186,9 @@ int CServer::Run()
 	if(Port == 0)
 		log_info("server", "using port %d", BindAddr.port);
 
+	if(Config()->m_SvNetThread)
+		m_NetServer.StartIoThread();
+
 #if defined(CONF_UPNP)
 	m_UPnP.Open(BindAddr);
 #endif
@@ -3097,6 +3214,7 @@ int CServer::Run()
 
 	Antibot()->Init();
 	GameServer()->OnInit(nullptr);
+	InitSnapshotThreads();
 	if(ErrorShutdown())
 	{
 		m_RunServer = STOPPING;
@@ -3263,7 +3381,10 @@ int CServer::Run()
 						GameServer()->OnClientPredictedInput(c, nullptr);
 				}
 
-				GameServer()->OnTick();
+				{
+					CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_GAME_TICK);
+					GameServer()->OnTick();
+				}
 				if(ErrorShutdown())
 				{
 					break;
@@ -3273,12 +3394,24 @@ int CServer::Run()
 			// snap game
 			if(NewTicks)
 			{
+				// send the snapshot burst of all clients together
+				if(Config()->m_SvNetBatch)
+					m_NetServer.BeginBatch();
+
 				DoSnapshot();
 
 				const int CommandSendingClientId = Tick() % MAX_CLIENTS;
 				UpdateClientRconCommands(CommandSendingClientId);
 				UpdateClientMaplistEntries(CommandSendingClientId);
 
+				{
+					CProfileScope Profile(&m_TickProfiler, CTickProfiler::SECTION_NET_SEND);
+					m_NetServer.EndBatch();
+				}
+
+				m_TickProfiler.EndTick(Tick());
+				UpdateTickProfiler();
+
 				m_Fifo.Update();
 
 #if defined(CONF_PLATFORM_ANDROID)
@@ -3389,14 +3522,14 @@ int CServer::Run()
 				!m_aDemoRecorder[RECORDER_MANUAL].IsRecording() &&
 				!m_aDemoRecorder[RECORDER_AUTO].IsRecording())
 			{
-				PacketWaiting = net_socket_read_wait(m_NetServer.Socket(), 1s);
+				PacketWaiting = m_NetServer.WaitForPackets(1s);
 			}
 			else
 			{
 				set_new_tick();
 				LastTime = time_get();
 				const auto MicrosecondsToWait = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(TickStartTime(m_CurrentGameTick + 1) - LastTime)) + 1us;
-				PacketWaiting = MicrosecondsToWait > 0us ? net_socket_read_wait(m_NetServer.Socket(), MicrosecondsToWait) : true;
+				PacketWaiting = MicrosecondsToWait > 0us ? m_NetServer.WaitForPackets(MicrosecondsToWait) : true;
 			}
 			if(IsInterrupted())
 			{
@@ -3425,6 +3558,7 @@ int CServer::Run()
 	m_Econ.Shutdown();
 	m_Fifo.Shutdown();
 	Engine()->ShutdownJobs();
+	ShutdownSnapshotThreads();
 
 	GameServer()->OnShutdown(nullptr);
 	m_pMap->Unload();
@@ -3501,6 +3635,67 @@ void CServer::ConStatus(IConsole::IResult *pResult, void *pUser)
 	}
 }
 
+void CServer::ConNetStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	NETSTATS Stats;
+	net_stats(&Stats);
+
+	char aBuf[256];
+	str_format(aBuf, sizeof(aBuf), "sent: packets=%" PRIu64 " bytes=%" PRIu64 " calls=%" PRIu64 " batching=%s",
+		Stats.sent_packets, Stats.sent_bytes, Stats.send_calls, pThis->Config()->m_SvNetBatch ? "yes" : "no");
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	str_format(aBuf, sizeof(aBuf), "recv: packets=%" PRIu64 " bytes=%" PRIu64 " calls=%" PRIu64,
+		Stats.recv_packets, Stats.recv_bytes, Stats.recv_calls);
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	str_format(aBuf, sizeof(aBuf), "network thread: dropped=%" PRIu64, pThis->m_NetServer.NumDroppedPackets());
+	pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+}
+
+void CServer::ConProfileStats(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	if(!pThis->m_TickProfiler.Enabled())
+	{
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", "profiler is disabled, enable it with sv_profile 1");
+		return;
+	}
+
+	char aBuf[256];
+	for(int i = 0; i < CTickProfiler::NUM_SECTIONS; i++)
+	{
+		const CTickProfiler::CStats Stats = pThis->m_TickProfiler.Stats(i);
+		str_format(aBuf, sizeof(aBuf), "%s: p50=%.3fms p99=%.3fms max=%.3fms ticks=%d",
+			CTickProfiler::SectionName(i), Stats.m_MedianNs / 1000000.0, Stats.m_P99Ns / 1000000.0, Stats.m_MaxNs / 1000000.0, Stats.m_NumSamples);
+		pThis->Console()->Print(IConsole::OUTPUT_LEVEL_STANDARD, "server", aBuf);
+	}
+}
+
+void CServer::ConProfileReset(IConsole::IResult *pResult, void *pUser)
+{
+	CServer *pThis = static_cast<CServer *>(pUser);
+	pThis->m_TickProfiler.Reset();
+}
+
+void CServer::UpdateTickProfiler()
+{
+	m_TickProfiler.SetEnabled(Config()->m_SvProfile);
+
+	const char *pCsvFile = m_TickProfiler.Enabled() ? Config()->m_SvProfileCsv : "";
+	if(str_comp(m_aTickProfilerCsvFile, pCsvFile) == 0)
+		return;
+	str_copy(m_aTickProfilerCsvFile, pCsvFile);
+
+	IOHANDLE File = nullptr;
+	if(m_aTickProfilerCsvFile[0] != '\0')
+	{
+		File = Storage()->OpenFile(m_aTickProfilerCsvFile, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+		if(!File)
+			log_error("server", "failed to open profiler file '%s'", m_aTickProfilerCsvFile);
+	}
+	m_TickProfiler.SetCsvFile(File);
+}
+
 static int GetAuthLevel(const char *pLevel)
 {
 	int Level = -1;
@@ -4302,6 +4497,9 @@ void CServer::RegisterCommands()
 	// register console commands
 	Console()->Register("kick", "i[id] ?r[reason]", CFGFLAG_SERVER, ConKick, this, "Kick player with specified id for any reason");
 	Console()->Register("status", "?r[name]", CFGFLAG_SERVER, ConStatus, this, "List players containing name or all players");
+	Console()->Register("net_stats", "", CFGFLAG_SERVER, ConNetStats, this, "Show the network packet and system call counters");
+	Console()->Register("profile_stats", "", CFGFLAG_SERVER, ConProfileStats, this, "Show the median and 99th percentile time of the parts of the server tick, see sv_profile");
+	Console()->Register("profile_reset", "", CFGFLAG_SERVER, ConProfileReset, this, "Reset the times collected by the tick profiler");
 	Console()->Register("shutdown", "?r[reason]", CFGFLAG_SERVER, ConShutdown, this, "Shut down");
 	Console()->Register("logout", "", CFGFLAG_SERVER, ConLogout, this, "Logout of rcon");
 	Console()->Register("show_ips", "?i[show]", CFGFLAG_SERVER, ConShowIps, this, "Show IP addresses in rcon commands (1 = on, 0 = off)");
@@ -4372,12 +4570,42 @@ void CServer::SnapFreeId(int Id)
 void *CServer::SnapNewItem(int Type, int Id, int Size)
 {
 	dbg_assert(Id >= -1 && Id <= 0xffff, "incorrect id");
-	return Id < 0 ? nullptr : m_SnapshotBuilder.NewItem(Type, Id, Size);
+	if(Id < 0)
+		return nullptr;
+	return m_SnappingShared ? m_SharedSnapshotBuilder.NewItem(Type, Id, Size) : m_SnapshotBuilder.NewItem(Type, Id, Size);
 }
 
 void CServer::SnapSetStaticsize(int ItemType, int Size)
 {
 	m_SnapshotDelta.SetStaticsize(ItemType, Size);
+	for(auto &pSnapshotDelta : m_apSnapshotDeltas)
+	{
+		if(pSnapshotDelta)
+			pSnapshotDelta->SetStaticsize(ItemType, Size);
+	}
+}
+
+void CServer::SnapBeginShared()
+{
+	dbg_assert(!m_SnappingShared, "already snapping shared items");
+	m_SharedSnapshotBuilder.Init();
+	m_SnappingShared = true;
+}
+
+void CServer::SnapEndShared()
+{
+	dbg_assert(m_SnappingShared, "not snapping shared items");
+	m_SnappingShared = false;
+}
+
+int CServer::SnapNumShared() const
+{
+	return m_SharedSnapshotBuilder.NumItems();
+}
+
+bool CServer::SnapCopyShared(int FirstItem, int NumItems)
+{
+	return m_SnapshotBuilder.CopyItems(&m_SharedSnapshotBuilder, FirstItem, NumItems);
 }
 
 CServer *CreateServer() { return new CServer(); }
@@ -16,8 +16,10 @@
 #include <engine/shared/econ.h>
 #include <engine/shared/fifo.h>
 #include <engine/shared/http.h>
+#include <engine/shared/jobs.h>
 #include <engine/shared/netban.h>
 #include <engine/shared/network.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocol.h>
 #include <engine/shared/snapshot.h>
 #include <engine/shared/uuid_manager.h>
@@ -214,12 +216,38 @@ public:
 
 	CSnapshotDelta m_SnapshotDelta;
 	CSnapshotBuilder m_SnapshotBuilder;
+	CSnapshotBuilder m_SharedSnapshotBuilder;
+	bool m_SnappingShared = false;
+
+	// finished snapshot of a client and the scratch buffers to create the delta in
+	class CSnapshotBuffers
+	{
+	public:
+		char m_aData[CSnapshot::MAX_SIZE];
+		int m_DataSize;
+		char m_aDeltaData[CSnapshot::MAX_SIZE];
+		int m_DeltaSize;
+		char m_aCompData[CSnapshot::MAX_SIZE];
+		int m_CompSize;
+		int m_DeltaTick;
+		int m_Crc;
+	};
+	// one entry per client when snapshot deltas are created in parallel, a single shared one otherwise
+	std::vector<CSnapshotBuffers> m_vSnapshotBuffers;
+	// parallel snapshot delta creation, see sv_snapshot_threads
+	int m_SnapshotThreads = 0;
+	CJobPool m_SnapshotJobPool;
+	SEMAPHORE m_SnapshotJobsDone;
+	std::unique_ptr<CSnapshotDelta> m_apSnapshotDeltas[2]; // indexed by sixup
 	CSnapIdPool m_IdPool;
 	CNetServer m_NetServer;
 	CEcon m_Econ;
 	CFifo m_Fifo;
 	CServerBan m_ServerBan;
 	CHttp m_Http;
+	// see sv_profile
+	CTickProfiler m_TickProfiler;
+	char m_aTickProfilerCsvFile[IO_MAX_PATH_LENGTH];
 
 	IEngineMap *m_pMap;
 
@@ -336,6 +364,11 @@ public:
 	int SendMsg(CMsgPacker *pMsg, int Flags, int ClientId) override;
 
 	void DoSnapshot();
+	void CreateSnapshotDelta(int ClientId, CSnapshotDelta *pSnapshotDelta, CSnapshotBuffers *pBuffers);
+	void SendSnapshot(int ClientId, const CSnapshotBuffers *pBuffers);
+	void InitSnapshotThreads();
+	void ShutdownSnapshotThreads();
+	void UpdateTickProfiler();
 
 	static int NewClientCallback(int ClientId, void *pUser, bool Sixup);
 	static int NewClientNoAuthCallback(int ClientId, void *pUser);
@@ -431,6 +464,9 @@ public:
 
 	static void ConKick(IConsole::IResult *pResult, void *pUser);
 	static void ConStatus(IConsole::IResult *pResult, void *pUser);
+	static void ConNetStats(IConsole::IResult *pResult, void *pUser);
+	static void ConProfileStats(IConsole::IResult *pResult, void *pUser);
+	static void ConProfileReset(IConsole::IResult *pResult, void *pUser);
 	static void ConShutdown(IConsole::IResult *pResult, void *pUser);
 	static void ConRecord(IConsole::IResult *pResult, void *pUser);
 	static void ConStopRecord(IConsole::IResult *pResult, void *pUser);
@@ -483,6 +519,10 @@ public:
 	void SnapFreeId(int Id) override;
 	void *SnapNewItem(int Type, int Id, int Size) override;
 	void SnapSetStaticsize(int ItemType, int Size) override;
+	void SnapBeginShared() override;
+	void SnapEndShared() override;
+	int SnapNumShared() const override;
+	bool SnapCopyShared(int FirstItem, int NumItems) override;
 
 	// DDRace
 
@@ -524,6 +564,8 @@ public:
 
 	bool IsSixup(int ClientId) const override { return ClientId != SERVER_DEMO_CLIENT && m_aClients[ClientId].m_Sixup; }
 
+	CTickProfiler *TickProfiler() override { return &m_TickProfiler; }
+
 	void SetLoggers(std::shared_ptr<ILogger> &&pFileLogger, std::shared_ptr<ILogger> &&pStdoutLogger);
 
 #ifdef CONF_FAMILY_UNIX
@@ -458,6 +458,12 @@ MACRO_CONFIG_STR(SvMap, sv_map, 128, "Sunny Side Up", CFGFLAG_SERVER, "Map to us
 MACRO_CONFIG_INT(SvMaxClients, sv_max_clients, SERVER_MAX_CLIENTS, 1, SERVER_MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients that are allowed on a server")
 MACRO_CONFIG_INT(SvMaxClientsPerIp, sv_max_clients_per_ip, 4, 1, SERVER_MAX_CLIENTS, CFGFLAG_SERVER, "Maximum number of clients with the same IP that can connect to the server")
 MACRO_CONFIG_INT(SvHighBandwidth, sv_high_bandwidth, 0, 0, 1, CFGFLAG_SERVER, "Use high bandwidth mode. Doubles the bandwidth required for the server. LAN use only")
+MACRO_CONFIG_INT(SvSharedSnapshot, sv_shared_snapshot, 1, 0, 1, CFGFLAG_SERVER, "Snap map entities like doors and pickups once per tick and copy them into the snapshots of all DDNet clients")
+MACRO_CONFIG_INT(SvSnapshotThreads, sv_snapshot_threads, 0, 0, 64, CFGFLAG_SERVER, "Number of worker threads to create the snapshot deltas of the clients with, 0 to create them on the main thread (only works in initial config)")
+MACRO_CONFIG_INT(SvNetBatch, sv_net_batch, 1, 0, 1, CFGFLAG_SERVER, "Queue the packets sent during a tick and send them with as few system calls as possible (Linux only)")
+MACRO_CONFIG_INT(SvNetThread, sv_net_thread, 0, 0, 1, CFGFLAG_SERVER, "Receive packets on a separate network thread, which drops floods before they reach the game loop (only works in initial config)")
+MACRO_CONFIG_INT(SvProfile, sv_profile, 0, 0, 1, CFGFLAG_SERVER, "Measure the time spent in the parts of the server tick, see profile_stats")
+MACRO_CONFIG_STR(SvProfileCsv, sv_profile_csv, IO_MAX_PATH_LENGTH, "", CFGFLAG_SERVER, "File to write the profiled times of every tick to while sv_profile is enabled (empty for none)")
 MACRO_CONFIG_INT(SvPreInput, sv_preinput, 1, 0, 1, CFGFLAG_SERVER, "Sends client inputs to other clients before their correct tick. Increases the bandwidth required for the server")
 MACRO_CONFIG_STR(SvRegister, sv_register, 16, "1", CFGFLAG_SERVER, "Register server with master server for public listing, can also accept a comma-separated list of protocols to register on, like 'ipv4,ipv6'")
 MACRO_CONFIG_STR(SvRegisterExtra, sv_register_extra, 256, "", CFGFLAG_SERVER, "Extra headers to send to the register endpoint, comma-separated 'Header: Value' pairs")
@@ -17,6 +17,7 @@
 #include <engine/storage.h>
 
 #include <algorithm>
+#include <cctype>
 #include <iterator> // std::size
 #include <new>
 
@@ -689,9 +690,45 @@ int CConsole::PossibleCommands(const char *pStr, int FlagMask, bool Temp, FPossi
 	return Index;
 }
 
+unsigned CConsole::NameHash(const char *pName)
+{
+	// like str_quickhash, but matches the names str_comp_nocase considers equal
+	unsigned Hash = 5381;
+	for(; *pName; pName++)
+		Hash = ((Hash << 5) + Hash) + std::tolower((unsigned char)*pName);
+	return Hash;
+}
+
+void CConsole::AddToIndex(CCommand *pCommand)
+{
+	// keep the bucket in the order of the command list
+	size_t Position = 0;
+	for(const CCommand *p = m_pFirstCommand; p != pCommand; p = p->Next())
+	{
+		if(p->m_NameHash == pCommand->m_NameHash)
+			Position++;
+	}
+	std::vector<CCommand *> &vpBucket = m_CommandIndex[pCommand->m_NameHash];
+	vpBucket.insert(vpBucket.begin() + Position, pCommand);
+}
+
+void CConsole::RemoveFromIndex(CCommand *pCommand)
+{
+	auto It = m_CommandIndex.find(pCommand->m_NameHash);
+	if(It == m_CommandIndex.end())
+		return;
+	std::erase(It->second, pCommand);
+	if(It->second.empty())
+		m_CommandIndex.erase(It);
+}
+
 CConsole::CCommand *CConsole::FindCommand(const char *pName, int FlagMask)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(NameHash(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask)
 		{
@@ -962,12 +999,17 @@ void CConsole::ParseArguments(int NumArgs, const char **ppArguments)
 
 void CConsole::AddCommandSorted(CCommand *pCommand)
 {
+	pCommand->m_NameHash = NameHash(pCommand->m_pName);
 	if(!m_pFirstCommand || str_comp(pCommand->m_pName, m_pFirstCommand->m_pName) <= 0)
 	{
 		if(m_pFirstCommand && m_pFirstCommand->Next())
 			pCommand->SetNext(m_pFirstCommand);
 		else
+		{
+			if(m_pFirstCommand)
+				RemoveFromIndex(m_pFirstCommand);
 			pCommand->SetNext(nullptr);
+		}
 		m_pFirstCommand = pCommand;
 	}
 	else
@@ -982,6 +1024,7 @@ void CConsole::AddCommandSorted(CCommand *pCommand)
 			}
 		}
 	}
+	AddToIndex(pCommand);
 }
 
 void CConsole::Register(const char *pName, const char *pParams,
@@ -1072,6 +1115,7 @@ void CConsole::DeregisterTemp(const char *pName)
 	// add to recycle list
 	if(pRemoved)
 	{
+		RemoveFromIndex(pRemoved);
 		pRemoved->SetNext(m_pRecycleList);
 		m_pRecycleList = pRemoved;
 	}
@@ -1095,6 +1139,10 @@ void CConsole::DeregisterTempAll()
 		}
 	}
 
+	for(auto &[Hash, vpBucket] : m_CommandIndex)
+		std::erase_if(vpBucket, [](const CCommand *pCommand) { return pCommand->m_Temp; });
+	std::erase_if(m_CommandIndex, [](const auto &Bucket) { return Bucket.second.empty(); });
+
 	m_TempCommands.Reset();
 	m_pRecycleList = nullptr;
 }
@@ -1145,7 +1193,11 @@ void CConsole::StoreCommands(bool Store)
 
 const IConsole::ICommandInfo *CConsole::GetCommandInfo(const char *pName, int FlagMask, bool Temp)
 {
-	for(CCommand *pCommand = m_pFirstCommand; pCommand; pCommand = pCommand->Next())
+	auto It = m_CommandIndex.find(NameHash(pName));
+	if(It == m_CommandIndex.end())
+		return nullptr;
+
+	for(CCommand *pCommand : It->second)
 	{
 		if(pCommand->m_Flags & FlagMask && pCommand->m_Temp == Temp)
 		{
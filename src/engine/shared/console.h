@@ -9,6 +9,7 @@
 #include <engine/storage.h>
 
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 class CConsole : public IConsole
@@ -28,6 +29,7 @@ class CConsole : public IConsole
 		void SetNext(CCommand *pNext) { m_pNext = pNext; }
 		int m_Flags;
 		bool m_Temp;
+		unsigned m_NameHash;
 		FCommandCallback m_pfnCallback;
 		void *m_pUserData;
 
@@ -156,6 +158,12 @@ class CConsole : public IConsole
 	};
 	std::vector<CExecutionQueueEntry> m_vExecutionQueue;
 
+	// case insensitive index of the command list by name hash, the buckets are in list order
+	std::unordered_map<unsigned, std::vector<CCommand *>> m_CommandIndex;
+	static unsigned NameHash(const char *pName);
+	void AddToIndex(CCommand *pCommand);
+	void RemoveFromIndex(CCommand *pCommand);
+
 	void AddCommandSorted(CCommand *pCommand);
 	CCommand *FindCommand(const char *pName, int FlagMask);
 
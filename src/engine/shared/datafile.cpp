@@ -10,12 +10,17 @@
 #include <base/math.h>
 #include <base/system.h>
 
+#include <engine/engine.h>
+#include <engine/shared/jobs.h>
 #include <engine/storage.h>
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
+#include <thread>
 #include <unordered_set>
 
 static constexpr int MAX_ITEM_TYPE = 0xFFFF;
@@ -129,6 +134,7 @@ class CDatafile
 {
 public:
 	IOHANDLE m_File;
+	const unsigned char *m_pMapping; // only set when the file was opened mapped
 	unsigned m_FileSize;
 	SHA256_DIGEST m_Sha256;
 	unsigned m_Crc;
@@ -213,28 +219,33 @@ public:
 				return nullptr;
 			}
 
-			// read the compressed data
-			void *pCompressedData = malloc(DataSize);
-			if(pCompressedData == nullptr)
+			// read the compressed data, mapped files are inflated directly from the mapping
+			void *pCompressedData = nullptr;
+			if(m_pMapping == nullptr)
 			{
-				log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
-			}
-			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
-			{
-				ActualDataSize = io_read(m_File, pCompressedData, DataSize);
-			}
-			if(DataSize != ActualDataSize)
-			{
-				log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
-				free(pCompressedData);
-				m_ppDataPtrs[Index] = nullptr;
-				m_pDataSizes[Index] = -1;
-				return nullptr;
+				pCompressedData = malloc(DataSize);
+				if(pCompressedData == nullptr)
+				{
+					log_error("datafile", "out of memory. could not allocate memory for compressed data. index=%d size=%d", Index, DataSize);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
+				unsigned ActualDataSize = 0;
+				if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+				{
+					ActualDataSize = io_read(m_File, pCompressedData, DataSize);
+				}
+				if(DataSize != ActualDataSize)
+				{
+					log_error("datafile", "truncation error. could not read all compressed data. index=%d wanted=%d got=%d", Index, DataSize, ActualDataSize);
+					free(pCompressedData);
+					m_ppDataPtrs[Index] = nullptr;
+					m_pDataSizes[Index] = -1;
+					return nullptr;
+				}
 			}
+			const void *pSource = m_pMapping == nullptr ? pCompressedData : m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index];
 
 			// decompress the data
 			m_ppDataPtrs[Index] = static_cast<char *>(malloc(OriginalUncompressedSize));
@@ -246,7 +257,7 @@ public:
 				return nullptr;
 			}
 			unsigned long UncompressedSize = OriginalUncompressedSize;
-			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, static_cast<Bytef *>(pCompressedData), DataSize);
+			const int Result = uncompress(static_cast<Bytef *>(m_ppDataPtrs[Index]), &UncompressedSize, static_cast<const Bytef *>(pSource), DataSize);
 			free(pCompressedData);
 			if(Result != Z_OK || UncompressedSize != OriginalUncompressedSize)
 			{
@@ -269,7 +280,12 @@ public:
 				return nullptr;
 			}
 			unsigned ActualDataSize = 0;
-			if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
+			if(m_pMapping != nullptr)
+			{
+				mem_copy(m_ppDataPtrs[Index], m_pMapping + m_DataStartOffset + m_Info.m_pDataOffsets[Index], DataSize);
+				ActualDataSize = DataSize;
+			}
+			else if(io_seek(m_File, m_DataStartOffset + m_Info.m_pDataOffsets[Index], IOSEEK_START) == 0)
 			{
 				ActualDataSize = io_read(m_File, m_ppDataPtrs[Index], DataSize);
 			}
@@ -430,6 +446,64 @@ public:
 	}
 };
 
+// Shared by the caller and the jobs of CDataFileReader::LoadData, each index is loaded by exactly one thread
+class CDatafileLoad
+{
+public:
+	CDatafile *m_pDataFile;
+	std::vector<int> m_vIndices;
+	bool m_Swap;
+	std::atomic<size_t> m_Next = 0;
+	std::atomic<size_t> m_Done = 0;
+	SEMAPHORE m_Finished;
+
+	CDatafileLoad(CDatafile *pDataFile, std::vector<int> &&vIndices, bool Swap) :
+		m_pDataFile(pDataFile),
+		m_vIndices(std::move(vIndices)),
+		m_Swap(Swap)
+	{
+		sphore_init(&m_Finished);
+	}
+
+	~CDatafileLoad()
+	{
+		sphore_destroy(&m_Finished);
+	}
+
+	void Run()
+	{
+		while(true)
+		{
+			const size_t Next = m_Next.fetch_add(1);
+			if(Next >= m_vIndices.size())
+			{
+				return;
+			}
+			m_pDataFile->GetData(m_vIndices[Next], m_Swap);
+			if(m_Done.fetch_add(1) + 1 == m_vIndices.size())
+			{
+				sphore_signal(&m_Finished);
+			}
+		}
+	}
+};
+
+class CDatafileLoadJob : public IJob
+{
+	std::shared_ptr<CDatafileLoad> m_pLoad;
+
+	void Run() override
+	{
+		m_pLoad->Run();
+	}
+
+public:
+	CDatafileLoadJob(std::shared_ptr<CDatafileLoad> pLoad) :
+		m_pLoad(std::move(pLoad))
+	{
+	}
+};
+
 CDataFileReader::~CDataFileReader()
 {
 	Close();
@@ -442,7 +516,7 @@ CDataFileReader &CDataFileReader::operator=(CDataFileReader &&Other)
 	return *this;
 }
 
-bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType)
+bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped)
 {
 	dbg_assert(m_pDataFile == nullptr, "File already open");
 
@@ -455,10 +529,52 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		return false;
 	}
 
-	// determine size and hashes of the file and store them
+	// map the file if requested, falls back to reading it if mapping is not possible
+	const unsigned char *pMapping = nullptr;
 	int64_t FileSize = 0;
+	if(Mapped)
+	{
+		FileSize = io_length(File);
+		if(FileSize > 0 && FileSize <= std::numeric_limits<unsigned>::max())
+		{
+			pMapping = static_cast<const unsigned char *>(io_map(File, FileSize));
+		}
+		if(pMapping == nullptr)
+		{
+			log_debug("datafile", "could not map file, reading it instead. datafile='%s'", pFilename);
+			FileSize = 0;
+		}
+	}
+	const auto &&CloseFile = [&]() {
+		if(pMapping != nullptr)
+		{
+			io_unmap(pMapping, FileSize);
+		}
+		io_close(File);
+	};
+
+	// read from the mapping or the file at the current position
+	int64_t ReadOffset = 0;
+	const auto &&ReadFile = [&](void *pData, int64_t Size) -> int64_t {
+		if(pMapping == nullptr)
+		{
+			return io_read(File, pData, Size);
+		}
+		Size = minimum(Size, FileSize - ReadOffset);
+		mem_copy(pData, pMapping + ReadOffset, Size);
+		ReadOffset += Size;
+		return Size;
+	};
+
+	// determine size and hashes of the file and store them
 	unsigned Crc = 0;
 	SHA256_DIGEST Sha256;
+	if(pMapping != nullptr)
+	{
+		Crc = crc32(Crc, pMapping, FileSize);
+		Sha256 = sha256(pMapping, FileSize);
+	}
+	else
 	{
 		SHA256_CTX Sha256Ctxt;
 		sha256_init(&Sha256Ctxt);
@@ -475,7 +591,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Sha256 = sha256_finish(&Sha256Ctxt);
 		if(io_seek(File, 0, IOSEEK_START) != 0)
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "could not seek to start after calculating hashes");
 			return false;
 		}
@@ -483,9 +599,9 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	// read header
 	CDatafileHeader Header;
-	if(io_read(File, &Header, sizeof(Header)) != sizeof(Header))
+	if(ReadFile(&Header, sizeof(Header)) != sizeof(Header))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "could not read file header. file truncated or not a datafile.");
 		return false;
 	}
@@ -494,7 +610,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	if((Header.m_aId[0] != 'A' || Header.m_aId[1] != 'T' || Header.m_aId[2] != 'A' || Header.m_aId[3] != 'D') &&
 		(Header.m_aId[0] != 'D' || Header.m_aId[1] != 'A' || Header.m_aId[2] != 'T' || Header.m_aId[3] != 'A'))
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "wrong header magic. magic=%x%x%x%x", Header.m_aId[0], Header.m_aId[1], Header.m_aId[2], Header.m_aId[3]);
 		return false;
 	}
@@ -504,7 +620,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	// check header version
 	if(Header.m_Version != 3 && Header.m_Version != 4)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "unsupported header version. version=%d", Header.m_Version);
 		return false;
 	}
@@ -518,7 +634,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		Header.m_ItemSize % sizeof(int) != 0 ||
 		Header.m_DataSize < 0)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header information. num_types=%d num_items=%d num_data=%d item_size=%d data_size=%d",
 			Header.m_NumItemTypes, Header.m_NumItems, Header.m_NumRawData, Header.m_ItemSize, Header.m_DataSize);
 		return false;
@@ -544,7 +660,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if((int64_t)sizeof(Header) + Size + (int64_t)Header.m_DataSize != FileSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "invalid header data size or truncated file. data_size=%d file_size=%" PRId64, Header.m_DataSize, FileSize);
 		return false;
 	}
@@ -559,7 +675,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header size or truncated file. size=%" PRId64 " actual=%" PRId64, HeaderFileSize, FileSize);
 			return false;
 		}
@@ -576,7 +692,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 		}
 		else
 		{
-			io_close(File);
+			CloseFile();
 			log_error("datafile", "invalid header swaplen or truncated file. swaplen=%" PRId64 " actual=%" PRId64, HeaderSwaplen, FileSizeSwaplen);
 			return false;
 		}
@@ -589,7 +705,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	AllocSize += (int64_t)Header.m_NumRawData * sizeof(int); // add space for data sizes
 	if(AllocSize > MaxAllocSize)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "file too large. alloc_size=%" PRId64 " max=%" PRId64, AllocSize, MaxAllocSize);
 		return false;
 	}
@@ -597,7 +713,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	CDatafile *pTmpDataFile = static_cast<CDatafile *>(malloc(AllocSize));
 	if(pTmpDataFile == nullptr)
 	{
-		io_close(File);
+		CloseFile();
 		log_error("datafile", "out of memory. could not allocate memory for datafile. alloc_size=%" PRId64, AllocSize);
 		return false;
 	}
@@ -607,6 +723,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	pTmpDataFile->m_pDataSizes = (int *)(pTmpDataFile->m_ppDataPtrs + Header.m_NumRawData);
 	pTmpDataFile->m_pData = (char *)(pTmpDataFile->m_pDataSizes + Header.m_NumRawData);
 	pTmpDataFile->m_File = File;
+	pTmpDataFile->m_pMapping = pMapping;
 	pTmpDataFile->m_FileSize = FileSize;
 	pTmpDataFile->m_Sha256 = Sha256;
 	pTmpDataFile->m_Crc = Crc;
@@ -616,12 +733,12 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 	mem_zero(pTmpDataFile->m_pDataSizes, Header.m_NumRawData * sizeof(int));
 
 	// read types, offsets, sizes and item data
-	const unsigned ReadSize = io_read(pTmpDataFile->m_File, pTmpDataFile->m_pData, Size);
-	if((int64_t)ReadSize != Size)
+	const int64_t ReadSize = ReadFile(pTmpDataFile->m_pData, Size);
+	if(ReadSize != Size)
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
-		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%d", Size, ReadSize);
+		log_error("datafile", "truncation error. could not read all item data. wanted=%" PRId64 " got=%" PRId64, Size, ReadSize);
 		return false;
 	}
 
@@ -647,7 +764,7 @@ bool CDataFileReader::Open(class IStorage *pStorage, const char *pFilename, int
 
 	if(!pTmpDataFile->Validate())
 	{
-		io_close(pTmpDataFile->m_File);
+		CloseFile();
 		free(pTmpDataFile);
 		return false;
 	}
@@ -670,6 +787,10 @@ void CDataFileReader::Close()
 		free(m_pDataFile->m_ppDataPtrs[i]);
 	}
 
+	if(m_pDataFile->m_pMapping != nullptr)
+	{
+		io_unmap(m_pDataFile->m_pMapping, m_pDataFile->m_FileSize);
+	}
 	io_close(m_pDataFile->m_File);
 	free(m_pDataFile);
 	m_pDataFile = nullptr;
@@ -753,6 +874,43 @@ void CDataFileReader::UnloadData(int Index)
 	m_pDataFile->m_pDataSizes[Index] = 0;
 }
 
+void CDataFileReader::LoadData(IEngine *pEngine, std::vector<int> vIndices, bool Swap)
+{
+	dbg_assert(m_pDataFile != nullptr, "File not open");
+
+	// skip invalid and already loaded data, and make sure no index is loaded twice at the same time
+	std::sort(vIndices.begin(), vIndices.end());
+	vIndices.erase(std::unique(vIndices.begin(), vIndices.end()), vIndices.end());
+	std::erase_if(vIndices, [&](int Index) {
+		return Index < 0 || Index >= m_pDataFile->m_Header.m_NumRawData || m_pDataFile->m_ppDataPtrs[Index] != nullptr || m_pDataFile->m_pDataSizes[Index] < 0;
+	});
+	if(vIndices.empty())
+	{
+		return;
+	}
+
+	// reading from the file handle is not thread-safe, only the mapping can be shared
+	if(pEngine == nullptr || m_pDataFile->m_pMapping == nullptr || vIndices.size() == 1)
+	{
+		for(int Index : vIndices)
+		{
+			m_pDataFile->GetData(Index, Swap);
+		}
+		return;
+	}
+
+	// the calling thread helps, so the jobs are only an upper bound of additional threads
+	const size_t NumJobs = minimum<size_t>(vIndices.size(), std::max(std::thread::hardware_concurrency(), 1u)) - 1;
+	std::shared_ptr<CDatafileLoad> pLoad = std::make_shared<CDatafileLoad>(m_pDataFile, std::move(vIndices), Swap);
+	for(size_t i = 0; i < NumJobs; i++)
+	{
+		pEngine->AddJob(std::make_shared<CDatafileLoadJob>(pLoad));
+	}
+	pLoad->Run();
+	// jobs that start after this only find the queue empty and do not access the datafile
+	sphore_wait(&pLoad->m_Finished);
+}
+
 int CDataFileReader::NumData() const
 {
 	dbg_assert(m_pDataFile != nullptr, "File not open");
@@ -31,7 +31,9 @@ public:
 	~CDataFileReader();
 	CDataFileReader &operator=(CDataFileReader &&Other);
 
-	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType);
+	// Mapped files are hashed and decompressed directly from memory instead of being read into temporary buffers.
+	// The file must not be truncated while it is open, so only map files that are replaced instead of overwritten.
+	[[nodiscard]] bool Open(class IStorage *pStorage, const char *pFilename, int StorageType, bool Mapped = false);
 	void Close();
 	bool IsOpen() const;
 	IOHANDLE File() const;
@@ -42,6 +44,9 @@ public:
 	const char *GetDataString(int Index);
 	void ReplaceData(int Index, char *pData, size_t Size); // memory for data must have been allocated with malloc
 	void UnloadData(int Index);
+	// Loads the data of the given indices on the job pool of the engine and waits until all of them are loaded.
+	// The data can then be accessed as usual. Only mapped files are loaded in parallel.
+	void LoadData(class IEngine *pEngine, std::vector<int> vIndices, bool Swap = false);
 	int NumData() const;
 
 	int GetItemSize(int Index) const;
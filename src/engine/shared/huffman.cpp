@@ -92,67 +92,110 @@ void CHuffman::ConstructTree(const unsigned *pFrequencies)
 	Setbits_r(m_pStartNode, 0, 0);
 }
 
-void CHuffman::Init(const unsigned *pFrequencies)
+unsigned CHuffman::MaxDepth(const CNode *pNode) const
 {
-	// make sure to cleanout every thing
-	mem_zero(m_aNodes, sizeof(m_aNodes));
-	mem_zero(m_apDecodeLut, sizeof(m_apDecodeLut));
-	m_pStartNode = nullptr;
-	m_NumNodes = 0;
-
-	// construct the tree
-	ConstructTree(pFrequencies);
+	if(pNode->m_NumBits)
+		return 0;
+	return 1 + std::max(MaxDepth(&m_aNodes[pNode->m_aLeafs[0]]), MaxDepth(&m_aNodes[pNode->m_aLeafs[1]]));
+}
 
-	// build decode LUT
+void CHuffman::BuildDecodeLut()
+{
+	int NumSubLut = 0;
 	for(int i = 0; i < HUFFMAN_LUTSIZE; i++)
 	{
+		CDecodeEntry &Entry = m_aDecodeLut[i];
+		mem_zero(&Entry, sizeof(Entry));
+		Entry.m_SubOffset = -1;
+
+		// decode as many complete symbols as fit into the lut bits
 		unsigned Bits = i;
-		int k;
-		CNode *pNode = m_pStartNode;
-		for(k = 0; k < HUFFMAN_LUTBITS; k++)
+		unsigned NumBits = 0;
+		const CNode *pNode = m_pStartNode;
+		while(NumBits < HUFFMAN_LUTBITS)
 		{
 			pNode = &m_aNodes[pNode->m_aLeafs[Bits & 1]];
 			Bits >>= 1;
+			NumBits++;
 
-			if(!pNode)
-				break;
+			if(!pNode->m_NumBits)
+				continue;
 
-			if(pNode->m_NumBits)
+			if(Entry.m_NumSymbols == 0)
+				Entry.m_FirstNode = pNode - m_aNodes;
+			if(pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL])
 			{
-				m_apDecodeLut[i] = pNode;
+				Entry.m_Eof = true;
 				break;
 			}
+
+			Entry.m_Symbols |= (unsigned long long)pNode->m_Symbol << (Entry.m_NumSymbols * 8);
+			Entry.m_NumSymbols++;
+			Entry.m_NumBits = NumBits;
+			if(Entry.m_NumSymbols == HUFFMAN_LUTSYMBOLS)
+				break;
+			pNode = m_pStartNode;
 		}
 
-		if(k == HUFFMAN_LUTBITS)
-			m_apDecodeLut[i] = pNode;
+		if(Entry.m_NumSymbols || Entry.m_Eof)
+			continue;
+
+		// the first code is longer than the lut bits, continue in a table of the remaining subtree
+		Entry.m_FirstNode = pNode - m_aNodes;
+		const unsigned SubBits = MaxDepth(pNode);
+		if(SubBits > 12 || NumSubLut + (1 << SubBits) > HUFFMAN_SUBLUTSIZE)
+			continue;
+
+		Entry.m_SubBits = SubBits;
+		Entry.m_SubOffset = NumSubLut;
+		for(int j = 0; j < (1 << SubBits); j++)
+		{
+			unsigned SubIndexBits = j;
+			const CNode *pSubNode = pNode;
+			while(!pSubNode->m_NumBits)
+			{
+				pSubNode = &m_aNodes[pSubNode->m_aLeafs[SubIndexBits & 1]];
+				SubIndexBits >>= 1;
+			}
+			m_aSubLut[NumSubLut + j] = {pSubNode->m_Symbol, (unsigned char)pSubNode->m_NumBits, pSubNode == &m_aNodes[HUFFMAN_EOF_SYMBOL]};
+		}
+		NumSubLut += 1 << SubBits;
 	}
 }
 
+void CHuffman::Init(const unsigned *pFrequencies)
+{
+	// make sure to cleanout every thing
+	mem_zero(m_aNodes, sizeof(m_aNodes));
+	m_pStartNode = nullptr;
+	m_NumNodes = 0;
+
+	// construct the tree
+	ConstructTree(pFrequencies);
+	m_MaxCodeBits = MaxDepth(m_pStartNode);
+
+	// build decode LUT
+	BuildDecodeLut();
+}
+
+static inline unsigned long long ReadLittleEndian64(const unsigned char *pData)
+{
+	return (unsigned long long)pData[0] |
+		((unsigned long long)pData[1] << 8) |
+		((unsigned long long)pData[2] << 16) |
+		((unsigned long long)pData[3] << 24) |
+		((unsigned long long)pData[4] << 32) |
+		((unsigned long long)pData[5] << 40) |
+		((unsigned long long)pData[6] << 48) |
+		((unsigned long long)pData[7] << 56);
+}
+
 //***************************************************************
 int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int OutputSize) const
 {
-	// this macro loads a symbol for a byte into bits and bitcount
-#define HUFFMAN_MACRO_LOADSYMBOL(Sym) \
-	do \
-	{ \
-		Bits |= m_aNodes[Sym].m_Bits << Bitcount; \
-		Bitcount += m_aNodes[Sym].m_NumBits; \
-	} while(0)
-
-	// this macro writes the symbol stored in bits and bitcount to the dst pointer
-#define HUFFMAN_MACRO_WRITE() \
-	do \
-	{ \
-		while(Bitcount >= 8) \
-		{ \
-			*pDst++ = (unsigned char)(Bits & 0xff); \
-			if(pDst == pDstEnd) \
-				return -1; \
-			Bits >>= 8; \
-			Bitcount -= 8; \
-		} \
-	} while(0)
+	// the bit buffer has to hold a full word and a code
+	if(m_MaxCodeBits > HUFFMAN_MAX_FAST_CODEBITS)
+		return -1;
 
 	// setup buffer pointers
 	const unsigned char *pSrc = (const unsigned char *)pInput;
@@ -161,45 +204,67 @@ int CHuffman::Compress(const void *pInput, int InputSize, void *pOutput, int Out
 	unsigned char *pDstEnd = pDst + OutputSize;
 
 	// symbol variables
-	unsigned Bits = 0;
+	unsigned long long Bits = 0;
 	unsigned Bitcount = 0;
 
-	// make sure that we have data that we want to compress
-	if(InputSize)
+	for(; pSrc != pSrcEnd; pSrc++)
 	{
-		// {A} load the first symbol
-		int Symbol = *pSrc++;
+		const CNode *pNode = &m_aNodes[*pSrc];
+		Bits |= (unsigned long long)pNode->m_Bits << Bitcount;
+		Bitcount += pNode->m_NumBits;
 
-		while(pSrc != pSrcEnd)
+		// write whole words, the last byte has to fit after them
+		if(Bitcount >= 32)
 		{
-			// {B} load the symbol
-			HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-
-			// {C} fetch next symbol, this is done here because it will reduce dependency in the code
-			Symbol = *pSrc++;
-
-			// {B} write the symbol loaded at
-			HUFFMAN_MACRO_WRITE();
+			if(pDstEnd - pDst < 5)
+				return -1;
+			pDst[0] = Bits;
+			pDst[1] = Bits >> 8;
+			pDst[2] = Bits >> 16;
+			pDst[3] = Bits >> 24;
+			pDst += 4;
+			Bits >>= 32;
+			Bitcount -= 32;
 		}
-
-		// write the last symbol loaded from {C} or {A} in the case of only 1 byte input buffer
-		HUFFMAN_MACRO_LOADSYMBOL(Symbol);
-		HUFFMAN_MACRO_WRITE();
 	}
 
 	// write EOF symbol
-	HUFFMAN_MACRO_LOADSYMBOL(HUFFMAN_EOF_SYMBOL);
-	HUFFMAN_MACRO_WRITE();
-
-	// write out the last bits
-	*pDst++ = Bits;
+	Bits |= (unsigned long long)m_aNodes[HUFFMAN_EOF_SYMBOL].m_Bits << Bitcount;
+	Bitcount += m_aNodes[HUFFMAN_EOF_SYMBOL].m_NumBits;
+
+	// write out the remaining bytes, the last one even if it has no bits left
+	const int NumBytes = Bitcount / 8 + 1;
+	if(pDstEnd - pDst < NumBytes)
+		return -1;
+	for(int i = 0; i < NumBytes; i++)
+	{
+		*pDst++ = Bits;
+		Bits >>= 8;
+	}
 
 	// return the size of the output
 	return (int)(pDst - (const unsigned char *)pOutput);
+}
 
-	// remove macros
-#undef HUFFMAN_MACRO_LOADSYMBOL
-#undef HUFFMAN_MACRO_WRITE
+CHuffman::CCode CHuffman::WalkTree(const CDecodeEntry &Entry, unsigned long long Bits) const
+{
+	const CNode *pNode = &m_aNodes[Entry.m_FirstNode];
+	while(!pNode->m_NumBits)
+	{
+		pNode = &m_aNodes[pNode->m_aLeafs[Bits & 1]];
+		Bits >>= 1;
+	}
+	return {pNode->m_Symbol, (unsigned char)pNode->m_NumBits, pNode == &m_aNodes[HUFFMAN_EOF_SYMBOL]};
+}
+
+inline CHuffman::CCode CHuffman::DecodeLong(const CDecodeEntry &Entry, unsigned long long Bits) const
+{
+	// Bits start after the lut bits
+	if(Entry.m_SubOffset >= 0)
+		return m_aSubLut[Entry.m_SubOffset + (Bits & ((1u << Entry.m_SubBits) - 1))];
+
+	// walk the tree bit by bit if the sub table didn't fit
+	return WalkTree(Entry, Bits);
 }
 
 //***************************************************************
@@ -207,77 +272,109 @@ int CHuffman::Decompress(const void *pInput, int InputSize, void *pOutput, int O
 {
 	// setup buffer pointers
 	unsigned char *pDst = (unsigned char *)pOutput;
-	unsigned char *pSrc = (unsigned char *)pInput;
+	const unsigned char *pSrc = (const unsigned char *)pInput;
 	unsigned char *pDstEnd = pDst + OutputSize;
-	unsigned char *pSrcEnd = pSrc + InputSize;
+	const unsigned char *pSrcEnd = pSrc + InputSize;
 
-	unsigned Bits = 0;
+	unsigned long long Bits = 0;
 	unsigned Bitcount = 0;
 
-	const CNode *pEof = &m_aNodes[HUFFMAN_EOF_SYMBOL];
-
-	while(true)
+	// {A} while there are at least 8 bytes of input, refill 64 bits at once
+	// and decode up to HUFFMAN_LUTSYMBOLS symbols per lookup
+	if(m_MaxCodeBits <= HUFFMAN_MAX_FAST_CODEBITS)
 	{
-		// {A} try to load a node now, this will reduce dependency at location {D}
-		const CNode *pNode = nullptr;
-		if(Bitcount >= HUFFMAN_LUTBITS)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
-
-		// {B} fill with new bits
-		while(Bitcount < 24 && pSrc != pSrcEnd)
+		while(pSrcEnd - pSrc >= 8)
 		{
-			Bits |= (*pSrc++) << Bitcount;
-			Bitcount += 8;
-		}
-
-		// {C} load symbol now if we didn't that earlier at location {A}
-		if(!pNode)
-			pNode = m_apDecodeLut[Bits & HUFFMAN_LUTMASK];
+			// bits above Bitcount are either zero or already hold the same input bits
+			Bits |= ReadLittleEndian64(pSrc) << Bitcount;
+			pSrc += (63 - Bitcount) >> 3;
+			Bitcount |= 56;
 
-		if(!pNode)
-			return -1;
+			while(Bitcount >= HUFFMAN_MAX_FAST_CODEBITS)
+			{
+				const CDecodeEntry &Entry = m_aDecodeLut[Bits & HUFFMAN_LUTMASK];
+				if(Entry.m_NumSymbols)
+				{
+					if(pDstEnd - pDst < Entry.m_NumSymbols)
+						return -1;
+					const unsigned long long Symbols = Entry.m_Symbols;
+					if(pDstEnd - pDst >= HUFFMAN_LUTSYMBOLS)
+					{
+						// write all of them at once, only the first m_NumSymbols count
+						pDst[0] = Symbols;
+						pDst[1] = Symbols >> 8;
+						pDst[2] = Symbols >> 16;
+						pDst[3] = Symbols >> 24;
+						pDst[4] = Symbols >> 32;
+						pDst[5] = Symbols >> 40;
+						pDst[6] = Symbols >> 48;
+						pDst[7] = Symbols >> 56;
+					}
+					else
+					{
+						for(int i = 0; i < Entry.m_NumSymbols; i++)
+							pDst[i] = Symbols >> (i * 8);
+					}
+					pDst += Entry.m_NumSymbols;
+					Bits >>= Entry.m_NumBits;
+					Bitcount -= Entry.m_NumBits;
+
+					if(Entry.m_Eof)
+						return (int)(pDst - (const unsigned char *)pOutput);
+					continue;
+				}
+
+				if(Entry.m_Eof)
+					return (int)(pDst - (const unsigned char *)pOutput);
+
+				// code longer than the lut bits
+				const CCode Code = DecodeLong(Entry, Bits >> HUFFMAN_LUTBITS);
+				Bits >>= Code.m_NumBits;
+				Bitcount -= Code.m_NumBits;
+
+				if(Code.m_Eof)
+					return (int)(pDst - (const unsigned char *)pOutput);
+				if(pDst == pDstEnd)
+					return -1;
+				*pDst++ = Code.m_Symbol;
+			}
+		}
+	}
 
-		// {D} check if we hit a symbol already
-		if(pNode->m_NumBits)
+	// {B} decode the rest symbol by symbol, the input is implicitly padded with zero bits
+	int BufferedBits = Bitcount;
+	while(true)
+	{
+		while(BufferedBits <= 56 && pSrc != pSrcEnd)
 		{
-			// remove the bits for that symbol
-			Bits >>= pNode->m_NumBits;
-			Bitcount -= pNode->m_NumBits;
+			Bits |= (unsigned long long)(*pSrc++) << BufferedBits;
+			BufferedBits += 8;
 		}
-		else
-		{
-			// remove the bits that the lut checked up for us
-			Bits >>= HUFFMAN_LUTBITS;
-			Bitcount -= HUFFMAN_LUTBITS;
-
-			// walk the tree bit by bit
-			while(true)
-			{
-				// traverse tree
-				pNode = &m_aNodes[pNode->m_aLeafs[Bits & 1]];
-
-				// remove bit
-				Bitcount--;
-				Bits >>= 1;
 
-				// check if we hit a symbol
-				if(pNode->m_NumBits)
-					break;
+		const CDecodeEntry &Entry = m_aDecodeLut[Bits & HUFFMAN_LUTMASK];
+		const CNode *pFirst = &m_aNodes[Entry.m_FirstNode];
+		CCode Code = {pFirst->m_Symbol, (unsigned char)pFirst->m_NumBits, pFirst == &m_aNodes[HUFFMAN_EOF_SYMBOL]};
+		if(!pFirst->m_NumBits)
+		{
+			Code = DecodeLong(Entry, Bits >> HUFFMAN_LUTBITS);
 
-				// no more bits, decoding error
-				if(Bitcount == 0)
-					return -1;
-			}
+			// earlier versions failed if the input ended inside a code longer than the lut,
+			// but only once they had the lut bits, keep this for compatibility
+			if(pSrc == pSrcEnd && BufferedBits > HUFFMAN_LUTBITS && BufferedBits < Code.m_NumBits)
+				return -1;
 		}
 
+		Bits >>= Code.m_NumBits;
+		BufferedBits = std::max(BufferedBits - (int)Code.m_NumBits, 0);
+
 		// check for eof
-		if(pNode == pEof)
+		if(Code.m_Eof)
 			break;
 
 		// output character
 		if(pDst == pDstEnd)
 			return -1;
-		*pDst++ = pNode->m_Symbol;
+		*pDst++ = Code.m_Symbol;
 	}
 
 	// return the size of the decompressed buffer
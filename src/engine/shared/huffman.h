@@ -14,7 +14,16 @@ class CHuffman
 
 		HUFFMAN_LUTBITS = 10,
 		HUFFMAN_LUTSIZE = (1 << HUFFMAN_LUTBITS),
-		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1)
+		HUFFMAN_LUTMASK = (HUFFMAN_LUTSIZE - 1),
+
+		// maximum number of symbols decoded with a single lookup
+		HUFFMAN_LUTSYMBOLS = 8,
+
+		// space for the tables of the codes longer than HUFFMAN_LUTBITS
+		HUFFMAN_SUBLUTSIZE = 4096,
+
+		// the fast paths keep up to this many bits of a code in a machine word
+		HUFFMAN_MAX_FAST_CODEBITS = 32,
 	};
 
 	struct CNode
@@ -30,15 +39,49 @@ class CHuffman
 		unsigned char m_Symbol;
 	};
 
+	// a single decoded code
+	struct CCode
+	{
+		unsigned char m_Symbol;
+		unsigned char m_NumBits;
+		bool m_Eof;
+	};
+
+	struct CDecodeEntry
+	{
+		// complete symbols in the lut bits, packed from the lowest byte on, and the number of bits they take up
+		unsigned long long m_Symbols;
+		unsigned char m_NumSymbols;
+		unsigned char m_NumBits;
+
+		// the EOF symbol directly follows m_aSymbols
+		bool m_Eof;
+
+		// bits of the sub table to continue with if the first code is longer than the lut bits
+		unsigned char m_SubBits;
+
+		// node of the first code, the inner node reached after the lut bits if it is longer
+		unsigned short m_FirstNode;
+
+		// offset of the sub table in m_aSubLut, -1 to walk the tree instead
+		short m_SubOffset;
+	};
+
 	static const unsigned ms_aFreqTable[HUFFMAN_MAX_SYMBOLS];
 
 	CNode m_aNodes[HUFFMAN_MAX_NODES];
-	CNode *m_apDecodeLut[HUFFMAN_LUTSIZE];
+	CDecodeEntry m_aDecodeLut[HUFFMAN_LUTSIZE];
+	CCode m_aSubLut[HUFFMAN_SUBLUTSIZE];
 	CNode *m_pStartNode;
 	int m_NumNodes;
+	unsigned m_MaxCodeBits;
 
 	void Setbits_r(CNode *pNode, int Bits, unsigned Depth);
 	void ConstructTree(const unsigned *pFrequencies);
+	unsigned MaxDepth(const CNode *pNode) const;
+	void BuildDecodeLut();
+	CCode DecodeLong(const CDecodeEntry &Entry, unsigned long long Bits) const;
+	CCode WalkTree(const CDecodeEntry &Entry, unsigned long long Bits) const;
 
 public:
 	/*
@@ -3,7 +3,9 @@
 #include "map.h"
 
 #include <base/log.h>
+#include <base/system.h>
 
+#include <engine/engine.h>
 #include <engine/storage.h>
 
 #include <game/mapitems.h>
@@ -35,6 +37,11 @@ void CMap::UnloadData(int Index)
 	m_DataFile.UnloadData(Index);
 }
 
+void CMap::LoadData(const std::vector<int> &vIndices)
+{
+	m_DataFile.LoadData(Kernel()->RequestInterface<IEngine>(), vIndices);
+}
+
 int CMap::NumData() const
 {
 	return m_DataFile.NumData();
@@ -76,10 +83,13 @@ bool CMap::Load(const char *pMapName)
 	if(!pStorage)
 		return false;
 
+	const int64_t StartTime = time_get();
+
 	// Ensure current datafile is not left in an inconsistent state if loading fails,
 	// by loading the new datafile separately first.
 	CDataFileReader NewDataFile;
-	if(!NewDataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL))
+	// Maps are replaced by renaming, so they can safely be mapped
+	if(!NewDataFile.Open(pStorage, pMapName, IStorage::TYPE_ALL, true))
 		return false;
 
 	// Check version
@@ -91,7 +101,11 @@ bool CMap::Load(const char *pMapName)
 		return false;
 	}
 
-	// Replace compressed tile layers with uncompressed ones
+	const int64_t OpenTime = time_get();
+
+	// Decompress the tiles of all tile layers in parallel, every client and server needs them
+	std::vector<CMapItemLayerTilemap *> vpTilemaps;
+	std::vector<int> vTileData;
 	int GroupsStart, GroupsNum, LayersStart, LayersNum;
 	NewDataFile.GetType(MAPITEMTYPE_GROUP, &GroupsStart, &GroupsNum);
 	NewDataFile.GetType(MAPITEMTYPE_LAYER, &LayersStart, &LayersNum);
@@ -104,25 +118,39 @@ bool CMap::Load(const char *pMapName)
 			if(pLayer->m_Type == LAYERTYPE_TILES)
 			{
 				CMapItemLayerTilemap *pTilemap = reinterpret_cast<CMapItemLayerTilemap *>(pLayer);
-				if(pTilemap->m_Version >= CMapItemLayerTilemap::VERSION_TEEWORLDS_TILESKIP)
-				{
-					const size_t TilemapCount = (size_t)pTilemap->m_Width * pTilemap->m_Height;
-					const size_t TilemapSize = TilemapCount * sizeof(CTile);
-
-					if(((int)TilemapCount / pTilemap->m_Width != pTilemap->m_Height) || (TilemapSize / sizeof(CTile) != TilemapCount))
-					{
-						log_error("map/load", "map layer too big (%d * %d * %d causes an integer overflow)", pTilemap->m_Width, pTilemap->m_Height, (int)sizeof(CTile));
-						return false;
-					}
-					CTile *pTiles = static_cast<CTile *>(malloc(TilemapSize));
-					if(!pTiles)
-						return false;
-					ExtractTiles(pTiles, (size_t)pTilemap->m_Width * pTilemap->m_Height, static_cast<CTile *>(NewDataFile.GetData(pTilemap->m_Data)), NewDataFile.GetDataSize(pTilemap->m_Data) / sizeof(CTile));
-					NewDataFile.ReplaceData(pTilemap->m_Data, reinterpret_cast<char *>(pTiles), TilemapSize);
-				}
+				vpTilemaps.push_back(pTilemap);
+				vTileData.push_back(pTilemap->m_Data);
+			}
+		}
+	}
+	NewDataFile.LoadData(Kernel()->RequestInterface<IEngine>(), vTileData);
+	const int64_t InflateTime = time_get();
+
+	// Replace compressed tile layers with uncompressed ones
+	for(CMapItemLayerTilemap *pTilemap : vpTilemaps)
+	{
+		if(pTilemap->m_Version >= CMapItemLayerTilemap::VERSION_TEEWORLDS_TILESKIP)
+		{
+			const size_t TilemapCount = (size_t)pTilemap->m_Width * pTilemap->m_Height;
+			const size_t TilemapSize = TilemapCount * sizeof(CTile);
+
+			if(((int)TilemapCount / pTilemap->m_Width != pTilemap->m_Height) || (TilemapSize / sizeof(CTile) != TilemapCount))
+			{
+				log_error("map/load", "map layer too big (%d * %d * %d causes an integer overflow)", pTilemap->m_Width, pTilemap->m_Height, (int)sizeof(CTile));
+				return false;
 			}
+			CTile *pTiles = static_cast<CTile *>(malloc(TilemapSize));
+			if(!pTiles)
+				return false;
+			ExtractTiles(pTiles, (size_t)pTilemap->m_Width * pTilemap->m_Height, static_cast<CTile *>(NewDataFile.GetData(pTilemap->m_Data)), NewDataFile.GetDataSize(pTilemap->m_Data) / sizeof(CTile));
+			NewDataFile.ReplaceData(pTilemap->m_Data, reinterpret_cast<char *>(pTiles), TilemapSize);
 		}
 	}
+	const int64_t ExtractTime = time_get();
+
+	log_debug("map/load", "loaded '%s' in %.2fms (open and hash %.2fms, decompress %d tile layers %.2fms, extract tiles %.2fms)",
+		pMapName, (ExtractTime - StartTime) * 1000.0 / time_freq(), (OpenTime - StartTime) * 1000.0 / time_freq(),
+		(int)vTileData.size(), (InflateTime - OpenTime) * 1000.0 / time_freq(), (ExtractTime - InflateTime) * 1000.0 / time_freq());
 
 	// Replace existing datafile with new datafile
 	m_DataFile.Close();
@@ -23,6 +23,7 @@ public:
 	void *GetDataSwapped(int Index) override;
 	const char *GetDataString(int Index) override;
 	void UnloadData(int Index) override;
+	void LoadData(const std::vector<int> &vIndices) override;
 	int NumData() const override;
 
 	int GetItemSize(int Index) override;
@@ -22,6 +22,37 @@ void WriteSecurityToken(unsigned char *pData, SECURITY_TOKEN Token)
 	uint_to_bytes_be(pData, Token);
 }
 
+CNetRecvQueue::CPacket *CNetRecvQueue::BeginPush()
+{
+	const unsigned Write = m_Write.load(std::memory_order_relaxed);
+	if(Write - m_Read.load(std::memory_order_acquire) == SIZE)
+		return nullptr;
+	return &m_aPackets[Write % SIZE];
+}
+
+void CNetRecvQueue::EndPush()
+{
+	m_Write.store(m_Write.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+const CNetRecvQueue::CPacket *CNetRecvQueue::Front() const
+{
+	const unsigned Read = m_Read.load(std::memory_order_relaxed);
+	if(Read == m_Write.load(std::memory_order_acquire))
+		return nullptr;
+	return &m_aPackets[Read % SIZE];
+}
+
+void CNetRecvQueue::Pop()
+{
+	m_Read.store(m_Read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+int CNetRecvQueue::Num() const
+{
+	return m_Write.load(std::memory_order_acquire) - m_Read.load(std::memory_order_acquire);
+}
+
 void CNetRecvUnpacker::Clear()
 {
 	m_Valid = false;
@@ -9,6 +9,11 @@
 #include <base/types.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 class CHuffman;
@@ -395,6 +400,38 @@ public:
 	int FetchChunk(CNetChunk *pChunk);
 };
 
+// lock-free queue of received datagrams, filled by exactly one thread and drained by exactly one other
+class CNetRecvQueue
+{
+public:
+	enum
+	{
+		SIZE = 1024,
+	};
+
+	struct CPacket
+	{
+		NETADDR m_Addr;
+		int m_DataSize;
+		unsigned char m_aData[NET_MAX_PACKETSIZE];
+	};
+
+	// producer side, returns nullptr if the queue is full
+	CPacket *BeginPush();
+	void EndPush();
+
+	// consumer side, returns nullptr if the queue is empty
+	const CPacket *Front() const;
+	void Pop();
+
+	int Num() const;
+
+private:
+	std::atomic<unsigned> m_Read{0};
+	std::atomic<unsigned> m_Write{0};
+	CPacket m_aPackets[SIZE];
+};
+
 // server side
 class CNetServer
 {
@@ -434,6 +471,19 @@ class CNetServer
 
 	CNetRecvUnpacker m_RecvUnpacker;
 
+	// optional network thread which receives the datagrams, see StartIoThread
+	void *m_pIoThread = nullptr;
+	std::unique_ptr<CNetRecvQueue> m_pRecvQueue;
+	std::atomic<bool> m_IoThreadShutdown{false};
+	std::atomic<uint64_t> m_NumDroppedPackets{0};
+	std::mutex m_RecvQueueMutex;
+	std::condition_variable m_RecvQueueCondition;
+	unsigned char m_aRecvBuffer[NET_MAX_PACKETSIZE];
+
+	static void IoThread(void *pUser);
+	void StopIoThread();
+	int RecvPacket(NETADDR *pAddr, unsigned char **ppData);
+
 	void OnTokenCtrlMsg(NETADDR &Addr, int ControlMsg, const CNetPacketConstruct &Packet);
 	int OnSixupCtrlMsg(NETADDR &Addr, CNetChunk *pChunk, int ControlMsg, const CNetPacketConstruct &Packet, SECURITY_TOKEN &ResponseToken, SECURITY_TOKEN Token);
 	void OnPreConnMsg(NETADDR &Addr, CNetPacketConstruct &Packet);
@@ -460,6 +510,19 @@ public:
 	int Send(CNetChunk *pChunk);
 	void Update();
 
+	// Moves receiving and validating the datagrams to a separate thread,
+	// so floods are dropped there instead of stalling the caller of Recv.
+	// Does nothing if the socket also listens for websockets.
+	void StartIoThread();
+	// Waits until there is something to receive or the timeout has passed.
+	bool WaitForPackets(std::chrono::nanoseconds Timeout);
+	// Datagrams the network thread dropped because they were malformed or the queue was full.
+	uint64_t NumDroppedPackets() const { return m_NumDroppedPackets.load(std::memory_order_relaxed); }
+
+	// queue outgoing packets until EndBatch, see net_udp_begin_batch
+	void BeginBatch() { net_udp_begin_batch(m_Socket); }
+	void EndBatch() { net_udp_end_batch(m_Socket); }
+
 	//
 	void Drop(int ClientId, const char *pReason);
 
@@ -5,6 +5,7 @@
 #include "network.h"
 
 #include <base/hash_ctxt.h>
+#include <base/log.h>
 #include <base/math.h>
 #include <base/system.h>
 
@@ -90,10 +91,105 @@ void CNetServer::Close()
 	{
 		return;
 	}
+	StopIoThread();
 	net_udp_close(m_Socket);
 	m_Socket = nullptr;
 }
 
+void CNetServer::StartIoThread()
+{
+	if(m_pIoThread)
+		return;
+	// the websocket context is not thread-safe, so websocket I/O has to stay on the main thread
+	if(net_socket_type(m_Socket) & (NETTYPE_WEBSOCKET_IPV4 | NETTYPE_WEBSOCKET_IPV6))
+	{
+		log_info("net", "not receiving on a network thread because websockets are enabled");
+		return;
+	}
+	m_pRecvQueue = std::make_unique<CNetRecvQueue>();
+	m_IoThreadShutdown = false;
+	m_pIoThread = thread_init(IoThread, this, "net io");
+}
+
+void CNetServer::StopIoThread()
+{
+	if(!m_pIoThread)
+		return;
+	m_IoThreadShutdown = true;
+	thread_wait(m_pIoThread);
+	m_pIoThread = nullptr;
+	m_pRecvQueue = nullptr;
+}
+
+void CNetServer::IoThread(void *pUser)
+{
+	CNetServer *pThis = static_cast<CNetServer *>(pUser);
+	CNetRecvQueue *pQueue = pThis->m_pRecvQueue.get();
+
+	while(!pThis->m_IoThreadShutdown)
+	{
+		// wake up regularly to notice the shutdown
+		if(!net_socket_read_wait(pThis->m_Socket, std::chrono::milliseconds(100)))
+			continue;
+
+		bool Pushed = false;
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes;
+		while((Bytes = net_udp_recv(pThis->m_Socket, &Addr, &pData)) > 0)
+		{
+			std::optional<int> Flags = CNetBase::UnpackPacketFlags(pData, Bytes);
+			// keep a quarter of the queue for connection-oriented packets, so connless floods can't starve the players
+			const int Limit = Flags && !(*Flags & NET_PACKETFLAG_CONNLESS) ? (int)CNetRecvQueue::SIZE : CNetRecvQueue::SIZE * 3 / 4;
+			CNetRecvQueue::CPacket *pPacket = Flags && pQueue->Num() < Limit ? pQueue->BeginPush() : nullptr;
+			if(!pPacket)
+			{
+				pThis->m_NumDroppedPackets.fetch_add(1, std::memory_order_relaxed);
+				continue;
+			}
+			pPacket->m_Addr = Addr;
+			pPacket->m_DataSize = Bytes;
+			mem_copy(pPacket->m_aData, pData, Bytes);
+			pQueue->EndPush();
+			Pushed = true;
+		}
+
+		if(Pushed)
+		{
+			// lock so the wakeup can't get lost between the check and the wait in WaitForPackets
+			{
+				const std::lock_guard<std::mutex> Lock(pThis->m_RecvQueueMutex);
+			}
+			pThis->m_RecvQueueCondition.notify_one();
+		}
+	}
+}
+
+bool CNetServer::WaitForPackets(std::chrono::nanoseconds Timeout)
+{
+	if(!m_pIoThread)
+		return net_socket_read_wait(m_Socket, Timeout);
+
+	std::unique_lock<std::mutex> Lock(m_RecvQueueMutex);
+	return m_RecvQueueCondition.wait_for(Lock, Timeout, [this]() { return m_pRecvQueue->Num() > 0; });
+}
+
+int CNetServer::RecvPacket(NETADDR *pAddr, unsigned char **ppData)
+{
+	if(!m_pIoThread)
+		return net_udp_recv(m_Socket, pAddr, ppData);
+
+	const CNetRecvQueue::CPacket *pPacket = m_pRecvQueue->Front();
+	if(!pPacket)
+		return 0;
+	const int Bytes = pPacket->m_DataSize;
+	*pAddr = pPacket->m_Addr;
+	mem_copy(m_aRecvBuffer, pPacket->m_aData, Bytes);
+	*ppData = m_aRecvBuffer;
+	m_pRecvQueue->Pop();
+	return Bytes;
+}
+
 void CNetServer::Drop(int ClientId, const char *pReason)
 {
 	// TODO: insert lots of checks here
@@ -595,7 +691,7 @@ int CNetServer::Recv(CNetChunk *pChunk, SECURITY_TOKEN *pResponseToken)
 
 		// TODO: empty the recvinfo
 		unsigned char *pData;
-		int Bytes = net_udp_recv(m_Socket, &Addr, &pData);
+		int Bytes = RecvPacket(&Addr, &pData);
 
 		// no more packets for now
 		if(Bytes <= 0)
@@ -0,0 +1,138 @@
+#include "profiler.h"
+
+#include "csv.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+
+static const char *const s_apSectionNames[] = {
+	"game_tick",
+	"entity_projectile",
+	"entity_laser",
+	"entity_pickup",
+	"entity_flag",
+	"entity_character",
+	"snap",
+	"snap_delta",
+	"snap_compress",
+	"net_send",
+	"net_recv",
+	"teehistorian",
+	"sql_results",
+};
+static_assert(std::size(s_apSectionNames) == CTickProfiler::NUM_SECTIONS);
+
+CTickProfiler::CTickProfiler() :
+	m_Enabled(false),
+	m_pCsvFile(nullptr)
+{
+	Reset();
+}
+
+CTickProfiler::~CTickProfiler()
+{
+	SetCsvFile(nullptr);
+}
+
+const char *CTickProfiler::SectionName(int Section)
+{
+	dbg_assert(Section >= 0 && Section < NUM_SECTIONS, "invalid profiler section");
+	return s_apSectionNames[Section];
+}
+
+void CTickProfiler::SetEnabled(bool Enabled)
+{
+	if(m_Enabled.exchange(Enabled) == Enabled)
+		return;
+	Reset();
+}
+
+void CTickProfiler::SetCsvFile(IOHANDLE File)
+{
+	if(m_pCsvFile)
+	{
+		aio_close(m_pCsvFile);
+		aio_wait(m_pCsvFile);
+		aio_free(m_pCsvFile);
+		m_pCsvFile = nullptr;
+	}
+	if(!File)
+		return;
+
+	// the header is written once when the file is opened, the rows are written asynchronously
+	const char *apColumns[NUM_SECTIONS + 1];
+	apColumns[0] = "tick";
+	for(int i = 0; i < NUM_SECTIONS; i++)
+		apColumns[i + 1] = s_apSectionNames[i];
+	CsvWrite(File, std::size(apColumns), apColumns);
+	m_pCsvFile = aio_new(File);
+}
+
+void CTickProfiler::EndTick(int Tick)
+{
+	if(!Enabled())
+		return;
+
+	for(int i = 0; i < NUM_SECTIONS; i++)
+		m_aaSamples[i][m_NextSample] = m_aCurrent[i].exchange(0, std::memory_order_relaxed);
+
+	if(m_pCsvFile)
+	{
+		// write microseconds to keep the file small, the values never need to be quoted
+		char aRow[(NUM_SECTIONS + 1) * 24];
+		str_format(aRow, sizeof(aRow), "%d", Tick);
+		for(int i = 0; i < NUM_SECTIONS; i++)
+		{
+			char aValue[24];
+			str_format(aValue, sizeof(aValue), ",%.3f", m_aaSamples[i][m_NextSample] / 1000.0);
+			str_append(aRow, aValue);
+		}
+		aio_lock(m_pCsvFile);
+		aio_write_unlocked(m_pCsvFile, aRow, str_length(aRow));
+		aio_write_newline_unlocked(m_pCsvFile);
+		aio_unlock(m_pCsvFile);
+	}
+
+	m_NextSample = (m_NextSample + 1) % HISTORY;
+	m_NumSamples = std::min(m_NumSamples + 1, (int)HISTORY);
+}
+
+void CTickProfiler::Reset()
+{
+	for(auto &Current : m_aCurrent)
+		Current.store(0, std::memory_order_relaxed);
+	m_NumSamples = 0;
+	m_NextSample = 0;
+}
+
+CTickProfiler::CStats CTickProfiler::Stats(int Section) const
+{
+	dbg_assert(Section >= 0 && Section < NUM_SECTIONS, "invalid profiler section");
+
+	CStats Stats;
+	Stats.m_NumSamples = m_NumSamples;
+	Stats.m_MedianNs = 0;
+	Stats.m_P99Ns = 0;
+	Stats.m_MaxNs = 0;
+	if(m_NumSamples == 0)
+		return Stats;
+
+	// the order of the samples does not matter, the ring is filled from the start
+	int64_t aSorted[HISTORY];
+	std::copy(m_aaSamples[Section], m_aaSamples[Section] + m_NumSamples, aSorted);
+	int64_t *pEnd = aSorted + m_NumSamples;
+	int64_t *pMedian = aSorted + (m_NumSamples - 1) / 2;
+	int64_t *pP99 = aSorted + (m_NumSamples - 1) * 99 / 100;
+	std::nth_element(aSorted, pP99, pEnd);
+	std::nth_element(aSorted, pMedian, pP99);
+	Stats.m_MedianNs = *pMedian;
+	Stats.m_P99Ns = *pP99;
+	Stats.m_MaxNs = *std::max_element(pP99, pEnd);
+	return Stats;
+}
+
+int64_t CProfileScope::Now()
+{
+	return time_get_nanoseconds().count();
+}
@@ -0,0 +1,115 @@
+#ifndef ENGINE_SHARED_PROFILER_H
+#define ENGINE_SHARED_PROFILER_H
+
+#include <base/system.h>
+#include <base/types.h>
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Collects the time spent in the parts of the server tick.
+ *
+ * Sections are measured with @link CProfileScope @endlink and summed up until
+ * @link CTickProfiler::EndTick @endlink stores them as one sample. Sections may
+ * nest, so they do not add up to the total tick time. The last @link HISTORY @endlink
+ * samples of each section are kept to compute percentiles.
+ */
+class CTickProfiler
+{
+public:
+	enum ESection
+	{
+		SECTION_GAME_TICK = 0,
+		// in the order of the entity types of the server's game world
+		SECTION_ENTITY_PROJECTILE,
+		SECTION_ENTITY_LASER,
+		SECTION_ENTITY_PICKUP,
+		SECTION_ENTITY_FLAG,
+		SECTION_ENTITY_CHARACTER,
+		SECTION_SNAP,
+		SECTION_SNAP_DELTA,
+		SECTION_SNAP_COMPRESS,
+		SECTION_NET_SEND,
+		SECTION_NET_RECV,
+		SECTION_TEEHISTORIAN,
+		SECTION_SQL_RESULTS,
+		NUM_SECTIONS,
+	};
+
+	enum
+	{
+		HISTORY = 1024,
+	};
+
+	struct CStats
+	{
+		int m_NumSamples;
+		int64_t m_MedianNs;
+		int64_t m_P99Ns;
+		int64_t m_MaxNs;
+	};
+
+	CTickProfiler();
+	~CTickProfiler();
+
+	static const char *SectionName(int Section);
+
+	// can be called from any thread
+	bool Enabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+	void SetEnabled(bool Enabled);
+
+	/**
+	 * Opens the file the samples are streamed to, one row per tick. The rows
+	 * are buffered and written by a separate thread.
+	 *
+	 * @param File The file to write to, or `nullptr` to stop streaming.
+	 * Ownership is transferred to the profiler.
+	 */
+	void SetCsvFile(IOHANDLE File);
+	bool HasCsvFile() const { return m_pCsvFile != nullptr; }
+
+	// can be called from any thread
+	void Add(int Section, int64_t Ns) { m_aCurrent[Section].fetch_add(Ns, std::memory_order_relaxed); }
+
+	// stores the times of the current tick as one sample
+	void EndTick(int Tick);
+	void Reset();
+	CStats Stats(int Section) const;
+
+private:
+	std::atomic<bool> m_Enabled;
+	ASYNCIO *m_pCsvFile;
+	std::atomic<int64_t> m_aCurrent[NUM_SECTIONS];
+	int64_t m_aaSamples[NUM_SECTIONS][HISTORY];
+	int m_NumSamples;
+	int m_NextSample;
+};
+
+/**
+ * Adds the time until it goes out of scope to a section of the profiler.
+ *
+ * Only checks a flag if the profiler is disabled.
+ */
+class CProfileScope
+{
+	CTickProfiler *m_pProfiler;
+	int m_Section;
+	int64_t m_Start;
+
+public:
+	CProfileScope(CTickProfiler *pProfiler, int Section) :
+		m_pProfiler(pProfiler->Enabled() ? pProfiler : nullptr), m_Section(Section), m_Start(m_pProfiler ? Now() : 0)
+	{
+	}
+	~CProfileScope()
+	{
+		if(m_pProfiler)
+			m_pProfiler->Add(m_Section, Now() - m_Start);
+	}
+
+private:
+	static int64_t Now();
+};
+
+#endif // ENGINE_SHARED_PROFILER_H
@@ -11,9 +11,16 @@
 #include <generated/protocol7.h>
 #include <generated/protocolglue.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <limits>
 
+// SSE2 is part of the amd64 baseline, so no runtime detection is needed
+#if defined(CONF_ARCH_AMD64) || defined(__SSE2__)
+#define SNAPSHOT_DELTA_SSE2 1
+#include <emmintrin.h>
+#endif
+
 // CSnapshot
 
 const CSnapshotItem *CSnapshot::GetItem(int Index) const
@@ -160,63 +167,101 @@ bool CSnapshot::IsValid(size_t ActualSize) const
 	return true;
 }
 
-// CSnapshotDelta
+// CSnapshotItemTable
 
-enum
+static inline unsigned HashItemKey(int Key)
 {
-	HASHLIST_SIZE = 256,
-	HASHLIST_BUCKET_SIZE = 64,
-};
+	// Fibonacci hashing, the type and id in the upper and lower half both end up in the low bits
+	unsigned Hash = (unsigned)Key * 0x9E3779B1u;
+	return Hash ^ (Hash >> 16);
+}
 
-struct CItemList
+int CSnapshotItemTable::NumEntries(int NumItems)
 {
-	int m_Num;
-	int m_aKeys[HASHLIST_BUCKET_SIZE];
-	int m_aIndex[HASHLIST_BUCKET_SIZE];
-};
+	// keep the load factor at or below one half
+	int Entries = 8;
+	while(Entries < 2 * NumItems)
+		Entries *= 2;
+	return Entries;
+}
 
-static inline size_t CalcHashId(int Key)
+size_t CSnapshotItemTable::TotalSize(int NumItems)
 {
-	// djb2 (http://www.cse.yorku.ca/~oz/hash.html)
-	unsigned Hash = 5381;
-	for(unsigned Shift = 0; Shift < sizeof(int); Shift++)
-		Hash = ((Hash << 5) + Hash) + ((Key >> (Shift * 8)) & 0xFF);
-	return Hash % HASHLIST_SIZE;
+	return sizeof(CSnapshotItemTable) + NumEntries(NumItems) * 2 * sizeof(int);
 }
 
-static void GenerateHash(CItemList *pHashlist, const CSnapshot *pSnapshot)
+void CSnapshotItemTable::Build(const CSnapshot *pSnapshot)
 {
-	for(int i = 0; i < HASHLIST_SIZE; i++)
-		pHashlist[i].m_Num = 0;
+	m_Mask = NumEntries(pSnapshot->NumItems()) - 1;
+	int *pEntries = Entries();
+	for(int i = 0; i <= m_Mask; i++)
+		pEntries[i * 2 + 1] = -1;
 
-	for(int i = 0; i < pSnapshot->NumItems(); i++)
+	for(int Index = 0; Index < pSnapshot->NumItems(); Index++)
 	{
-		int Key = pSnapshot->GetItem(i)->Key();
-		size_t HashId = CalcHashId(Key);
-		if(pHashlist[HashId].m_Num < HASHLIST_BUCKET_SIZE)
+		const int Key = pSnapshot->GetItem(Index)->Key();
+		for(unsigned Slot = HashItemKey(Key) & m_Mask;; Slot = (Slot + 1) & m_Mask)
 		{
-			pHashlist[HashId].m_aIndex[pHashlist[HashId].m_Num] = i;
-			pHashlist[HashId].m_aKeys[pHashlist[HashId].m_Num] = Key;
-			pHashlist[HashId].m_Num++;
+			if(pEntries[Slot * 2 + 1] == -1)
+			{
+				pEntries[Slot * 2] = Key;
+				pEntries[Slot * 2 + 1] = Index;
+				break;
+			}
+			// keep the first item with a duplicate key
+			if(pEntries[Slot * 2] == Key)
+				break;
 		}
 	}
 }
 
-static int GetItemIndexHashed(int Key, const CItemList *pHashlist)
+int CSnapshotItemTable::Find(int Key) const
 {
-	size_t HashId = CalcHashId(Key);
-	for(int i = 0; i < pHashlist[HashId].m_Num; i++)
+	const int *pEntries = Entries();
+	for(unsigned Slot = HashItemKey(Key) & m_Mask;; Slot = (Slot + 1) & m_Mask)
 	{
-		if(pHashlist[HashId].m_aKeys[i] == Key)
-			return pHashlist[HashId].m_aIndex[i];
+		if(pEntries[Slot * 2 + 1] == -1)
+			return -1;
+		if(pEntries[Slot * 2] == Key)
+			return pEntries[Slot * 2 + 1];
 	}
+}
 
-	return -1;
+// CSnapshotDelta
+
+// number of bits the value takes up when packed with CVariableInt::Pack
+static inline uint64_t PackedBits(int Value)
+{
+	unsigned Rest = (Value < 0 ? ~(unsigned)Value : (unsigned)Value) >> 6;
+	uint64_t Bytes = 1;
+	while(Rest)
+	{
+		Bytes++;
+		Rest >>= 7;
+	}
+	return Bytes * 8;
 }
 
 int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, int Size)
 {
 	int Needed = 0;
+#if defined(SNAPSHOT_DELTA_SSE2)
+	__m128i NeededLanes = _mm_setzero_si128();
+	while(Size >= 4)
+	{
+		// integer subtraction of the lanes wraps like the unsigned one below
+		const __m128i Diff = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)pCurrent), _mm_loadu_si128((const __m128i *)pPast));
+		_mm_storeu_si128((__m128i *)pOut, Diff);
+		NeededLanes = _mm_or_si128(NeededLanes, Diff);
+		pOut += 4;
+		pPast += 4;
+		pCurrent += 4;
+		Size -= 4;
+	}
+	NeededLanes = _mm_or_si128(NeededLanes, _mm_shuffle_epi32(NeededLanes, _MM_SHUFFLE(1, 0, 3, 2)));
+	NeededLanes = _mm_or_si128(NeededLanes, _mm_shuffle_epi32(NeededLanes, _MM_SHUFFLE(2, 3, 0, 1)));
+	Needed = _mm_cvtsi128_si32(NeededLanes);
+#endif
 	while(Size)
 	{
 		// subtraction with wrapping by casting to unsigned
@@ -233,20 +278,27 @@ int CSnapshotDelta::DiffItem(const int *pPast, const int *pCurrent, int *pOut, i
 
 void CSnapshotDelta::UndiffItem(const int *pPast, const int *pDiff, int *pOut, int Size, uint64_t *pDataRate)
 {
+	uint64_t DataRate = 0;
+	for(int i = 0; i < Size; i++)
+		DataRate += pDiff[i] == 0 ? 1 : PackedBits(pDiff[i]);
+	*pDataRate += DataRate;
+
+#if defined(SNAPSHOT_DELTA_SSE2)
+	while(Size >= 4)
+	{
+		// integer addition of the lanes wraps like the unsigned one below
+		_mm_storeu_si128((__m128i *)pOut, _mm_add_epi32(_mm_loadu_si128((const __m128i *)pPast), _mm_loadu_si128((const __m128i *)pDiff)));
+		pOut += 4;
+		pPast += 4;
+		pDiff += 4;
+		Size -= 4;
+	}
+#endif
 	while(Size)
 	{
 		// addition with wrapping by casting to unsigned
 		*pOut = (unsigned)*pPast + (unsigned)*pDiff;
 
-		if(*pDiff == 0)
-			*pDataRate += 1;
-		else
-		{
-			unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
-			unsigned char *pEnd = CVariableInt::Pack(aBuf, *pDiff, sizeof(aBuf));
-			*pDataRate += (uint64_t)(pEnd - (unsigned char *)aBuf) * 8;
-		}
-
 		pOut++;
 		pPast++;
 		pDiff++;
@@ -291,8 +343,7 @@ const CSnapshotDelta::CData *CSnapshotDelta::EmptyDelta() const
 	return &m_Empty;
 }
 
-// TODO: OPT: this should be made much faster
-int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData)
+int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData, const CSnapshotItemTable *pFromTable)
 {
 	CData *pDelta = (CData *)pDstData;
 	int *pData = (int *)pDelta->m_aData;
@@ -301,14 +352,15 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	pDelta->m_NumUpdateItems = 0;
 	pDelta->m_NumTempItems = 0;
 
-	CItemList aHashlist[HASHLIST_SIZE];
-	GenerateHash(aHashlist, pTo);
+	alignas(int) char aToTableData[CSnapshotItemTable::MAX_SIZE];
+	CSnapshotItemTable *pToTable = (CSnapshotItemTable *)aToTableData;
+	pToTable->Build(pTo);
 
 	// pack deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
-		if(GetItemIndexHashed(pFromItem->Key(), aHashlist) == -1)
+		if(pToTable->Find(pFromItem->Key()) == -1)
 		{
 			// deleted
 			pDelta->m_NumDeletedItems++;
@@ -317,7 +369,13 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 		}
 	}
 
-	GenerateHash(aHashlist, pFrom);
+	alignas(int) char aFromTableData[CSnapshotItemTable::MAX_SIZE];
+	if(!pFromTable)
+	{
+		CSnapshotItemTable *pBuiltTable = (CSnapshotItemTable *)aFromTableData;
+		pBuiltTable->Build(pFrom);
+		pFromTable = pBuiltTable;
+	}
 
 	// fetch previous indices
 	// we do this as a separate pass because it helps the cache
@@ -325,8 +383,8 @@ int CSnapshotDelta::CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, vo
 	const int NumItems = pTo->NumItems();
 	for(int i = 0; i < NumItems; i++)
 	{
-		const CSnapshotItem *pCurItem = pTo->GetItem(i); // O(1) .. O(n)
-		aPastIndices[i] = GetItemIndexHashed(pCurItem->Key(), aHashlist); // O(n) .. O(n^n)
+		const CSnapshotItem *pCurItem = pTo->GetItem(i);
+		aPastIndices[i] = pFromTable->Find(pCurItem->Key());
 	}
 
 	for(int i = 0; i < NumItems; i++)
@@ -507,7 +565,7 @@ int CSnapshotDelta::DebugDumpDelta(const void *pSrcData, int DataSize)
 	return 0;
 }
 
-int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const void *pSrcData, int DataSize, bool Sixup)
+int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const void *pSrcData, int DataSize, bool Sixup, const CSnapshotItemTable *pFromTable)
 {
 	CData *pDelta = (CData *)pSrcData;
 	int *pData = (int *)pDelta->m_aData;
@@ -524,30 +582,42 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 	if(pData > pEnd)
 		return -101;
 
+	alignas(int) char aFromTableData[CSnapshotItemTable::MAX_SIZE];
+	if(!pFromTable)
+	{
+		CSnapshotItemTable *pBuiltTable = (CSnapshotItemTable *)aFromTableData;
+		pBuiltTable->Build(pFrom);
+		pFromTable = pBuiltTable;
+	}
+
+	// a valid delta can't delete more items than the old snapshot has
+	if(pDelta->m_NumDeletedItems > CSnapshot::MAX_ITEMS)
+		return -101;
+	int aDeletedKeys[CSnapshot::MAX_ITEMS];
+	mem_copy(aDeletedKeys, pDeleted, pDelta->m_NumDeletedItems * sizeof(int));
+	std::sort(aDeletedKeys, aDeletedKeys + pDelta->m_NumDeletedItems);
+
+	// index of the kept items in the builder, -1 if deleted
+	int aBuilderIndices[CSnapshot::MAX_ITEMS];
+
 	// copy all non deleted stuff
 	for(int i = 0; i < pFrom->NumItems(); i++)
 	{
 		const CSnapshotItem *pFromItem = pFrom->GetItem(i);
-		const int ItemSize = pFrom->GetItemSize(i);
-		bool Keep = true;
-		for(int d = 0; d < pDelta->m_NumDeletedItems; d++)
+		if(std::binary_search(aDeletedKeys, aDeletedKeys + pDelta->m_NumDeletedItems, pFromItem->Key()))
 		{
-			if(pDeleted[d] == pFromItem->Key())
-			{
-				Keep = false;
-				break;
-			}
+			aBuilderIndices[i] = -1;
+			continue;
 		}
 
-		if(Keep)
-		{
-			void *pObj = Builder.NewItem(pFromItem->Type(), pFromItem->Id(), ItemSize);
-			if(!pObj)
-				return -301;
+		const int ItemSize = pFrom->GetItemSize(i);
+		aBuilderIndices[i] = Builder.NumItems();
+		void *pObj = Builder.NewItem(pFromItem->Type(), pFromItem->Id(), ItemSize);
+		if(!pObj)
+			return -301;
 
-			// keep it
-			mem_copy(pObj, pFromItem->Data(), ItemSize);
-		}
+		// keep it
+		mem_copy(pObj, pFromItem->Data(), ItemSize);
 	}
 
 	// unpack updated stuff
@@ -583,14 +653,18 @@ int CSnapshotDelta::UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const vo
 		const int Key = (Type << 16) | Id;
 
 		// create the item if needed
-		int *pNewData = Builder.GetItemData(Key);
+		const int FromIndex = pFromTable->Find(Key);
+		int *pNewData;
+		if(FromIndex != -1 && aBuilderIndices[FromIndex] != -1)
+			pNewData = Builder.GetItemDataAt(aBuilderIndices[FromIndex]);
+		else
+			pNewData = Builder.GetItemData(Key);
 		if(!pNewData)
 			pNewData = (int *)Builder.NewItem(Type, Id, ItemSize);
 
 		if(!pNewData)
 			return -302;
 
-		const int FromIndex = pFrom->GetItemIndex(Key);
 		if(FromIndex != -1)
 		{
 			// we got an update so we need to apply the diff
@@ -625,6 +699,7 @@ void CSnapshotStorage::PurgeAll()
 		CHolder *pNext = m_pFirst->m_pNext;
 		free(m_pFirst->m_pSnap);
 		free(m_pFirst->m_pAltSnap);
+		free(m_pFirst->m_pItemTable);
 		free(m_pFirst);
 		m_pFirst = pNext;
 	}
@@ -642,6 +717,7 @@ void CSnapshotStorage::PurgeUntil(int Tick)
 			return; // no more to remove
 		free(pHolder->m_pSnap);
 		free(pHolder->m_pAltSnap);
+		free(pHolder->m_pItemTable);
 		free(pHolder);
 
 		// did we come to the end of the list?
@@ -683,6 +759,8 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 		pHolder->m_AltSnapSize = 0;
 	}
 
+	pHolder->m_pItemTable = nullptr;
+
 	// link
 	pHolder->m_pNext = nullptr;
 	pHolder->m_pPrev = m_pLast;
@@ -693,7 +771,7 @@ void CSnapshotStorage::Add(int Tick, int64_t Tagtime, size_t DataSize, const voi
 	m_pLast = pHolder;
 }
 
-int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const
+int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData, const CSnapshotItemTable **ppItemTable) const
 {
 	CHolder *pHolder = m_pFirst;
 
@@ -707,6 +785,15 @@ int CSnapshotStorage::Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData,
 				*ppData = pHolder->m_pSnap;
 			if(ppAltData)
 				*ppAltData = pHolder->m_pAltSnap;
+			if(ppItemTable)
+			{
+				if(!pHolder->m_pItemTable)
+				{
+					pHolder->m_pItemTable = static_cast<CSnapshotItemTable *>(malloc(CSnapshotItemTable::TotalSize(pHolder->m_pSnap->NumItems())));
+					pHolder->m_pItemTable->Build(pHolder->m_pSnap);
+				}
+				*ppItemTable = pHolder->m_pItemTable;
+			}
 			return pHolder->m_SnapSize;
 		}
 
@@ -739,6 +826,18 @@ CSnapshotItem *CSnapshotBuilder::GetItem(int Index)
 	return (CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
 }
 
+const CSnapshotItem *CSnapshotBuilder::GetItem(int Index) const
+{
+	return (const CSnapshotItem *)&(m_aData[m_aOffsets[Index]]);
+}
+
+int CSnapshotBuilder::GetItemSize(int Index) const
+{
+	if(Index == m_NumItems - 1)
+		return (m_DataSize - m_aOffsets[Index]) - sizeof(CSnapshotItem);
+	return (m_aOffsets[Index + 1] - m_aOffsets[Index]) - sizeof(CSnapshotItem);
+}
+
 int *CSnapshotBuilder::GetItemData(int Key)
 {
 	for(int i = 0; i < m_NumItems; i++)
@@ -752,6 +851,11 @@ int *CSnapshotBuilder::GetItemData(int Key)
 	return nullptr;
 }
 
+int *CSnapshotBuilder::GetItemDataAt(int Index)
+{
+	return GetItem(Index)->Data();
+}
+
 int CSnapshotBuilder::Finish(void *pSnapData)
 {
 	// flatten and make the snapshot
@@ -810,6 +914,33 @@ int CSnapshotBuilder::GetExtendedItemTypeIndex(int TypeId)
 	return -1;
 }
 
+bool CSnapshotBuilder::CopyItems(const CSnapshotBuilder *pFrom, int FirstIndex, int NumItems)
+{
+	dbg_assert(FirstIndex >= 0 && NumItems >= 0 && FirstIndex + NumItems <= pFrom->m_NumItems, "index out of range");
+	dbg_assert(!pFrom->m_Sixup, "cannot copy items of sixup snapshot");
+	for(int i = FirstIndex; i < FirstIndex + NumItems; i++)
+	{
+		const CSnapshotItem *pItem = pFrom->GetItem(i);
+		int Type = pItem->Type();
+		if(Type == 0 && pItem->Id() >= CSnapshot::OFFSET_UUID_TYPE) // NETOBJTYPE_EX
+		{
+			// registered again by NewItem if this snapshot uses the type
+			continue;
+		}
+		if(Type >= CSnapshot::OFFSET_UUID_TYPE)
+		{
+			Type = pFrom->m_aExtendedItemTypes[CSnapshot::MAX_TYPE - Type];
+		}
+
+		const int Size = pFrom->GetItemSize(i);
+		void *pData = NewItem(Type, pItem->Id(), Size);
+		if(!pData)
+			return false;
+		mem_copy(pData, pItem->Data(), Size);
+	}
+	return true;
+}
+
 void *CSnapshotBuilder::NewItem(int Type, int Id, int Size)
 {
 	if(Id == -1)
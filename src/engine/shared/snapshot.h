@@ -72,6 +72,32 @@ public:
 	static const CSnapshot *EmptySnapshot() { return &ms_EmptySnapshot; }
 };
 
+// CSnapshotItemTable
+
+// Open addressing hash table which maps the item keys of a snapshot to their indices.
+// The entries are stored behind the table, so it must be placed in memory of `TotalSize` bytes.
+class CSnapshotItemTable
+{
+	int m_Mask;
+
+	int *Entries() { return (int *)(this + 1); }
+	const int *Entries() const { return (const int *)(this + 1); }
+
+	static int NumEntries(int NumItems);
+
+public:
+	enum
+	{
+		MAX_ENTRIES = 2 * CSnapshot::MAX_ITEMS,
+		MAX_SIZE = (1 + 2 * MAX_ENTRIES) * sizeof(int),
+	};
+
+	static size_t TotalSize(int NumItems);
+	void Build(const CSnapshot *pSnapshot);
+	// Returns the index of the first item with the key or -1, like `CSnapshot::GetItemIndex`.
+	int Find(int Key) const;
+};
+
 // CSnapshotDelta
 
 class CSnapshotDelta
@@ -108,8 +134,8 @@ public:
 	void SetStaticsize(int ItemType, size_t Size);
 	void SetStaticsize7(int ItemType, size_t Size);
 	const CData *EmptyDelta() const;
-	int CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData);
-	int UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const void *pSrcData, int DataSize, bool Sixup);
+	int CreateDelta(const CSnapshot *pFrom, const CSnapshot *pTo, void *pDstData, const CSnapshotItemTable *pFromTable = nullptr);
+	int UnpackDelta(const CSnapshot *pFrom, CSnapshot *pTo, const void *pSrcData, int DataSize, bool Sixup, const CSnapshotItemTable *pFromTable = nullptr);
 	int DebugDumpDelta(const void *pSrcData, int DataSize);
 };
 
@@ -132,6 +158,9 @@ public:
 
 		CSnapshot *m_pSnap;
 		CSnapshot *m_pAltSnap;
+
+		// built on first use as delta base
+		CSnapshotItemTable *m_pItemTable;
 	};
 
 	CHolder *m_pFirst;
@@ -143,7 +172,7 @@ public:
 	void PurgeAll();
 	void PurgeUntil(int Tick);
 	void Add(int Tick, int64_t Tagtime, size_t DataSize, const void *pData, size_t AltDataSize, const void *pAltData);
-	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData) const;
+	int Get(int Tick, int64_t *pTagtime, const CSnapshot **ppData, const CSnapshot **ppAltData, const CSnapshotItemTable **ppItemTable = nullptr) const;
 };
 
 class CSnapshotBuilder
@@ -175,9 +204,16 @@ public:
 	void Init7(const CSnapshot *pSnapshot);
 
 	void *NewItem(int Type, int Id, int Size);
+	// Copies items of another builder, skipping its internal extended item type registrations.
+	// Returns `false` if not all items fit into this snapshot.
+	bool CopyItems(const CSnapshotBuilder *pFrom, int FirstIndex, int NumItems);
 
 	CSnapshotItem *GetItem(int Index);
+	const CSnapshotItem *GetItem(int Index) const;
+	int GetItemSize(int Index) const;
 	int *GetItemData(int Key);
+	int *GetItemDataAt(int Index);
+	int NumItems() const { return m_NumItems; }
 
 	int Finish(void *pSnapdata);
 };
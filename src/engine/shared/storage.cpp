@@ -77,6 +77,9 @@ public:
 				"assets/hud",
 				"assets/particles",
 				"audio",
+				"cache",
+				"cache/communityicons",
+				"cache/skins",
 				"communityicons",
 				"downloadedmaps",
 				"downloadedskins",
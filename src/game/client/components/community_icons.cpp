@@ -3,6 +3,7 @@
 #include <base/log.h>
 
 #include <engine/engine.h>
+#include <engine/gfx/image_cache.h>
 #include <engine/gfx/image_manipulation.h>
 #include <engine/storage.h>
 
@@ -65,27 +66,54 @@ const CCommunityIcon *CCommunityIcons::Find(const char *pCommunityId)
 	return Icon == m_vCommunityIcons.end() ? nullptr : &(*Icon);
 }
 
+// Increase when LoadFile changes the resulting images
+static constexpr int COMMUNITY_ICON_CACHE_VERSION = 1;
+
 bool CCommunityIcons::LoadFile(const char *pPath, int DirType, CImageInfo &Info, CImageInfo &InfoGrayscale, SHA256_DIGEST &Sha256)
 {
-	if(!Graphics()->LoadPng(Info, pPath, DirType))
+	void *pPngData;
+	unsigned PngSize;
+	if(!Storage()->ReadFile(pPath, DirType, &pPngData, &PngSize))
 	{
 		log_error("menus/browser", "Failed to load community icon from '%s'", pPath);
 		return false;
 	}
-	if(Info.m_Format != CImageInfo::FORMAT_RGBA)
+	Sha256 = sha256(pPngData, PngSize);
+
+	const CImageCache Cache(Storage(), "cache/communityicons", COMMUNITY_ICON_CACHE_VERSION);
+	CImageInfo aImages[2];
+	if(Cache.Load(Sha256, aImages, std::size(aImages), nullptr, 0))
 	{
-		Info.Free();
-		log_error("menus/browser", "Failed to load community icon from '%s': must be an RGBA image", pPath);
+		free(pPngData);
+		Info = std::move(aImages[0]);
+		InfoGrayscale = std::move(aImages[1]);
+		return true;
+	}
+
+	const bool Loaded = Graphics()->LoadPng(Info, static_cast<uint8_t *>(pPngData), PngSize, pPath);
+	free(pPngData);
+	if(!Loaded)
+	{
+		log_error("menus/browser", "Failed to load community icon from '%s'", pPath);
 		return false;
 	}
-	if(!Storage()->CalculateHashes(pPath, DirType, &Sha256))
+	if(Info.m_Format != CImageInfo::FORMAT_RGBA)
 	{
 		Info.Free();
-		log_error("menus/browser", "Failed to load community icon from '%s': could not calculate hash", pPath);
+		log_error("menus/browser", "Failed to load community icon from '%s': must be an RGBA image", pPath);
 		return false;
 	}
 	InfoGrayscale = Info.DeepCopy();
 	ConvertToGrayscale(InfoGrayscale);
+
+	aImages[0] = std::move(Info);
+	aImages[1] = std::move(InfoGrayscale);
+	if(!Cache.Save(Sha256, aImages, std::size(aImages), nullptr, 0))
+	{
+		log_warn("menus/browser", "Failed to write community icon '%s' to the cache", pPath);
+	}
+	Info = std::move(aImages[0]);
+	InfoGrayscale = std::move(aImages[1]);
 	return true;
 }
 
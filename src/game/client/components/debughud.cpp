@@ -75,6 +75,12 @@ void CDebugHud::RenderNetCorrections()
 	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->m_Snap.m_pLocalCharacter->m_Angle);
 	RenderRow("Angle:", aBuf);
 
+	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->m_PredictedTicksSimulated);
+	RenderRow("Predicted ticks:", aBuf);
+
+	str_format(aBuf, sizeof(aBuf), "%d/%d", GameClient()->m_PredictionCacheHits, GameClient()->m_PredictionCacheMisses);
+	RenderRow("Cache hits/misses:", aBuf);
+
 	str_format(aBuf, sizeof(aBuf), "%d", GameClient()->NetobjNumCorrections());
 	RenderRow("Netobj corrections", aBuf);
 	RenderRow(" on:", GameClient()->NetobjCorrectedOn());
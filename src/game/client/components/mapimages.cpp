@@ -97,6 +97,20 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 
 	const int TextureLoadFlag = Graphics()->Uses2DTextureArrays() ? IGraphics::TEXLOAD_TO_2D_ARRAY_TEXTURE : IGraphics::TEXLOAD_TO_3D_TEXTURE;
 
+	// decompress all embedded images that are used in parallel before uploading them one by one
+	const int64_t StartTime = time_get();
+	std::vector<int> vImageData;
+	for(int i = 0; i < m_Count; i++)
+	{
+		const CMapItemImage_v2 *pImg = static_cast<const CMapItemImage_v2 *>(pMap->GetItem(Start + i));
+		if(aTextureUsedByTileOrQuadLayerFlag[i] != 0 && !pImg->m_External && (pImg->m_Version <= 1 || pImg->m_MustBe1 == 1))
+		{
+			vImageData.push_back(pImg->m_ImageData);
+		}
+	}
+	pMap->LoadData(vImageData);
+	const int64_t InflateTime = time_get();
+
 	// load new textures
 	bool ShowWarning = false;
 	for(int i = 0; i < m_Count; i++)
@@ -169,6 +183,8 @@ void CMapImages::OnMapLoadImpl(class CLayers *pLayers, IMap *pMap)
 		pMap->UnloadData(pImg->m_ImageName);
 		ShowWarning = ShowWarning || m_aTextures[i].IsNullTexture();
 	}
+	log_debug("mapimages", "loaded %d map images in %.2fms (decompress %d embedded images %.2fms, upload %.2fms)",
+		m_Count, (time_get() - StartTime) * 1000.0 / time_freq(), (int)vImageData.size(), (InflateTime - StartTime) * 1000.0 / time_freq(), (time_get() - InflateTime) * 1000.0 / time_freq());
 	if(ShowWarning)
 	{
 		Client()->AddWarning(SWarning(Localize("Some map images could not be loaded. Check the local console for details.")));
@@ -48,6 +48,20 @@ void CMapSounds::OnMapLoad()
 
 	m_Count = std::clamp<int>(m_Count, 0, MAX_MAPSOUNDS);
 
+	// decompress all embedded samples in parallel before decoding them one by one
+	const int64_t StartTime = time_get();
+	std::vector<int> vSoundData;
+	for(int i = 0; i < m_Count; i++)
+	{
+		const CMapItemSound *pSound = static_cast<const CMapItemSound *>(pMap->GetItem(Start + i));
+		if(!pSound->m_External)
+		{
+			vSoundData.push_back(pSound->m_SoundData);
+		}
+	}
+	pMap->LoadData(vSoundData);
+	const int64_t InflateTime = time_get();
+
 	// load new samples
 	bool ShowWarning = false;
 	for(int i = 0; i < m_Count; i++)
@@ -87,6 +101,8 @@ void CMapSounds::OnMapLoad()
 		}
 		ShowWarning = ShowWarning || m_aSounds[i] == -1;
 	}
+	log_debug("mapsounds", "loaded %d map sounds in %.2fms (decompress %d embedded sounds %.2fms, decode %.2fms)",
+		m_Count, (time_get() - StartTime) * 1000.0 / time_freq(), (int)vSoundData.size(), (InflateTime - StartTime) * 1000.0 / time_freq(), (time_get() - InflateTime) * 1000.0 / time_freq());
 	if(ShowWarning)
 	{
 		Client()->AddWarning(SWarning(Localize("Some map sounds could not be loaded. Check the local console for details.")));
@@ -21,21 +21,104 @@ CParticles::CParticles()
 	m_RenderGeneral.m_pParts = this;
 }
 
-void CParticles::OnReset()
+void CParticles::CGroup::Add(const CParticle &Part, float Life)
 {
-	// reset particles
-	for(int i = 0; i < MAX_PARTICLES; i++)
+	m_vPos.push_back(Part.m_Pos);
+	m_vVel.push_back(Part.m_Vel);
+	m_vLife.push_back(Life);
+	m_vRot.push_back(Part.m_Rot);
+	m_vLifeSpan.push_back(Part.m_LifeSpan);
+	m_vGravity.push_back(Part.m_Gravity);
+	m_vFriction.push_back(Part.m_Friction);
+	m_vRotspeed.push_back(Part.m_Rotspeed);
+	m_vCollides.push_back(Part.m_Collides);
+	m_vColor.push_back(Part.m_Color);
+	m_vSpr.push_back(Part.m_Spr);
+	m_vStartSize.push_back(Part.m_StartSize);
+	m_vEndSize.push_back(Part.m_EndSize);
+	m_vUseAlphaFading.push_back(Part.m_UseAlphaFading);
+	m_vStartAlpha.push_back(Part.m_StartAlpha);
+	m_vEndAlpha.push_back(Part.m_EndAlpha);
+}
+
+int CParticles::CGroup::RemoveDead()
+{
+	// compact the arrays in place, this keeps the order the particles were added in
+	const int Num = this->Num();
+	int NumAlive = 0;
+	for(int i = 0; i < Num; i++)
 	{
-		m_aParticles[i].m_PrevPart = i - 1;
-		m_aParticles[i].m_NextPart = i + 1;
+		if(m_vLife[i] > m_vLifeSpan[i])
+			continue;
+		if(NumAlive != i)
+		{
+			m_vPos[NumAlive] = m_vPos[i];
+			m_vVel[NumAlive] = m_vVel[i];
+			m_vLife[NumAlive] = m_vLife[i];
+			m_vRot[NumAlive] = m_vRot[i];
+			m_vLifeSpan[NumAlive] = m_vLifeSpan[i];
+			m_vGravity[NumAlive] = m_vGravity[i];
+			m_vFriction[NumAlive] = m_vFriction[i];
+			m_vRotspeed[NumAlive] = m_vRotspeed[i];
+			m_vCollides[NumAlive] = m_vCollides[i];
+			m_vColor[NumAlive] = m_vColor[i];
+			m_vSpr[NumAlive] = m_vSpr[i];
+			m_vStartSize[NumAlive] = m_vStartSize[i];
+			m_vEndSize[NumAlive] = m_vEndSize[i];
+			m_vUseAlphaFading[NumAlive] = m_vUseAlphaFading[i];
+			m_vStartAlpha[NumAlive] = m_vStartAlpha[i];
+			m_vEndAlpha[NumAlive] = m_vEndAlpha[i];
+		}
+		NumAlive++;
 	}
+	if(NumAlive == Num)
+		return 0;
+
+	m_vPos.resize(NumAlive);
+	m_vVel.resize(NumAlive);
+	m_vLife.resize(NumAlive);
+	m_vRot.resize(NumAlive);
+	m_vLifeSpan.resize(NumAlive);
+	m_vGravity.resize(NumAlive);
+	m_vFriction.resize(NumAlive);
+	m_vRotspeed.resize(NumAlive);
+	m_vCollides.resize(NumAlive);
+	m_vColor.resize(NumAlive);
+	m_vSpr.resize(NumAlive);
+	m_vStartSize.resize(NumAlive);
+	m_vEndSize.resize(NumAlive);
+	m_vUseAlphaFading.resize(NumAlive);
+	m_vStartAlpha.resize(NumAlive);
+	m_vEndAlpha.resize(NumAlive);
+	return Num - NumAlive;
+}
 
-	m_aParticles[0].m_PrevPart = 0;
-	m_aParticles[MAX_PARTICLES - 1].m_NextPart = -1;
-	m_FirstFree = 0;
+void CParticles::CGroup::Clear()
+{
+	m_vPos.clear();
+	m_vVel.clear();
+	m_vLife.clear();
+	m_vRot.clear();
+	m_vLifeSpan.clear();
+	m_vGravity.clear();
+	m_vFriction.clear();
+	m_vRotspeed.clear();
+	m_vCollides.clear();
+	m_vColor.clear();
+	m_vSpr.clear();
+	m_vStartSize.clear();
+	m_vEndSize.clear();
+	m_vUseAlphaFading.clear();
+	m_vStartAlpha.clear();
+	m_vEndAlpha.clear();
+}
 
-	for(int &FirstPart : m_aFirstPart)
-		FirstPart = -1;
+void CParticles::OnReset()
+{
+	// reset particles
+	for(CGroup &Group : m_aGroups)
+		Group.Clear();
+	m_NumParticles = 0;
 }
 
 void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
@@ -52,27 +135,11 @@ void CParticles::Add(int Group, CParticle *pPart, float TimePassed)
 			return;
 	}
 
-	if(m_FirstFree == -1)
+	if(m_NumParticles >= MAX_PARTICLES)
 		return;
 
-	// remove from the free list
-	int Id = m_FirstFree;
-	m_FirstFree = m_aParticles[Id].m_NextPart;
-	if(m_FirstFree != -1)
-		m_aParticles[m_FirstFree].m_PrevPart = -1;
-
-	// copy data
-	m_aParticles[Id] = *pPart;
-
-	// insert to the group list
-	m_aParticles[Id].m_PrevPart = -1;
-	m_aParticles[Id].m_NextPart = m_aFirstPart[Group];
-	if(m_aFirstPart[Group] != -1)
-		m_aParticles[m_aFirstPart[Group]].m_PrevPart = Id;
-	m_aFirstPart[Group] = Id;
-
-	// set some parameters
-	m_aParticles[Id].m_Life = TimePassed;
+	m_aGroups[Group].Add(*pPart, TimePassed);
+	m_NumParticles++;
 }
 
 void CParticles::Update(float TimePassed)
@@ -92,55 +159,50 @@ void CParticles::Update(float TimePassed)
 		m_FrictionFraction -= 0.05f;
 	}
 
-	for(int &FirstPart : m_aFirstPart)
+	for(CGroup &Group : m_aGroups)
 	{
-		int i = FirstPart;
-		while(i != -1)
+		const int Num = Group.Num();
+		vec2 *pPos = Group.m_vPos.data();
+		vec2 *pVel = Group.m_vVel.data();
+		float *pLife = Group.m_vLife.data();
+		float *pRot = Group.m_vRot.data();
+		const float *pGravity = Group.m_vGravity.data();
+		const float *pFriction = Group.m_vFriction.data();
+		const float *pRotspeed = Group.m_vRotspeed.data();
+
+		// the loops without branches get vectorized
+		for(int i = 0; i < Num; i++)
+			pVel[i].y += pGravity[i] * TimePassed;
+
+		for(int f = 0; f < FrictionCount; f++) // apply friction
+			for(int i = 0; i < Num; i++)
+				pVel[i] *= pFriction[i];
+
+		for(int i = 0; i < Num; i++)
 		{
-			int Next = m_aParticles[i].m_NextPart;
-			//m_aParticles[i].vel += flow_get(m_aParticles[i].pos)*time_passed * m_aParticles[i].flow_affected;
-			m_aParticles[i].m_Vel.y += m_aParticles[i].m_Gravity * TimePassed;
+			pLife[i] += TimePassed;
+			pRot[i] += TimePassed * pRotspeed[i];
+		}
 
-			for(int f = 0; f < FrictionCount; f++) // apply friction
-				m_aParticles[i].m_Vel *= m_aParticles[i].m_Friction;
+		const uint8_t *pCollides = Group.m_vCollides.data();
 
-			// move the point
-			vec2 Vel = m_aParticles[i].m_Vel * TimePassed;
-			if(m_aParticles[i].m_Collides)
+		// move the points, newest first like the rendering
+		for(int i = Num - 1; i >= 0; i--)
+		{
+			vec2 Vel = pVel[i] * TimePassed;
+			if(pCollides[i])
 			{
-				Collision()->MovePoint(&m_aParticles[i].m_Pos, &Vel, random_float(0.1f, 1.0f), nullptr);
+				Collision()->MovePoint(&pPos[i], &Vel, random_float(0.1f, 1.0f), nullptr);
+				pVel[i] = Vel * (1.0f / TimePassed);
 			}
 			else
 			{
-				m_aParticles[i].m_Pos += Vel;
+				pPos[i] += Vel;
 			}
-			m_aParticles[i].m_Vel = Vel * (1.0f / TimePassed);
-
-			m_aParticles[i].m_Life += TimePassed;
-			m_aParticles[i].m_Rot += TimePassed * m_aParticles[i].m_Rotspeed;
-
-			// check particle death
-			if(m_aParticles[i].m_Life > m_aParticles[i].m_LifeSpan)
-			{
-				// remove it from the group list
-				if(m_aParticles[i].m_PrevPart != -1)
-					m_aParticles[m_aParticles[i].m_PrevPart].m_NextPart = m_aParticles[i].m_NextPart;
-				else
-					FirstPart = m_aParticles[i].m_NextPart;
-
-				if(m_aParticles[i].m_NextPart != -1)
-					m_aParticles[m_aParticles[i].m_NextPart].m_PrevPart = m_aParticles[i].m_PrevPart;
-
-				// insert to the free list
-				if(m_FirstFree != -1)
-					m_aParticles[m_FirstFree].m_PrevPart = i;
-				m_aParticles[i].m_PrevPart = -1;
-				m_aParticles[i].m_NextPart = m_FirstFree;
-				m_FirstFree = i;
-			}
-
-			i = Next;
 		}
+
+		// check particle death
+		m_NumParticles -= Group.RemoveDead();
 	}
 }
 
@@ -219,84 +281,62 @@ void CParticles::RenderGroup(int Group)
 		ParticleQuadContainerIndex = m_ExtraParticleQuadContainerIndex;
 	}
 
+	const CGroup &Parts = m_aGroups[Group];
+	const int Num = Parts.Num();
+	if(Num == 0)
+		return;
+
+	auto &&GetAlpha = [&](int i, float a) {
+		if(Parts.m_vUseAlphaFading[i])
+			return mix(Parts.m_vStartAlpha[i], Parts.m_vEndAlpha[i], a);
+		return Parts.m_vColor[i].a;
+	};
+
 	// don't use the buffer methods here, else the old renderer gets many draw calls
 	if(Graphics()->IsQuadContainerBufferingEnabled())
 	{
-		int i = m_aFirstPart[Group];
-
 		static IGraphics::SRenderSpriteInfo s_aParticleRenderInfo[MAX_PARTICLES];
 
 		int CurParticleRenderCount = 0;
 
 		// batching makes sense for stuff like ninja particles
-		ColorRGBA LastColor;
-		int LastQuadOffset = 0;
+		ColorRGBA LastColor = Parts.m_vColor[Num - 1];
+		LastColor.a = GetAlpha(Num - 1, Parts.m_vLife[Num - 1] / Parts.m_vLifeSpan[Num - 1]);
+		int LastQuadOffset = Parts.m_vSpr[Num - 1];
+		Graphics()->SetColor(LastColor);
 
-		if(i != -1)
+		// newest first, new particles are drawn below older ones
+		for(int i = Num - 1; i >= 0; i--)
 		{
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
-			LastColor.r = m_aParticles[i].m_Color.r;
-			LastColor.g = m_aParticles[i].m_Color.g;
-			LastColor.b = m_aParticles[i].m_Color.b;
-			LastColor.a = Alpha;
-
-			Graphics()->SetColor(
-				m_aParticles[i].m_Color.r,
-				m_aParticles[i].m_Color.g,
-				m_aParticles[i].m_Color.b,
-				Alpha);
-
-			LastQuadOffset = m_aParticles[i].m_Spr;
-		}
-
-		while(i != -1)
-		{
-			int QuadOffset = m_aParticles[i].m_Spr;
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
+			int QuadOffset = Parts.m_vSpr[i];
+			float a = Parts.m_vLife[i] / Parts.m_vLifeSpan[i];
+			vec2 p = Parts.m_vPos[i];
+			float Size = mix(Parts.m_vStartSize[i], Parts.m_vEndSize[i], a);
+			float Alpha = GetAlpha(i, a);
+			const ColorRGBA &Color = Parts.m_vColor[i];
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
 			if(ParticleIsVisibleOnScreen(p, Size))
 			{
-				if((size_t)CurParticleRenderCount == gs_GraphicsMaxParticlesRenderCount || LastColor.r != m_aParticles[i].m_Color.r || LastColor.g != m_aParticles[i].m_Color.g || LastColor.b != m_aParticles[i].m_Color.b || LastColor.a != Alpha || LastQuadOffset != QuadOffset)
+				if((size_t)CurParticleRenderCount == gs_GraphicsMaxParticlesRenderCount || LastColor.r != Color.r || LastColor.g != Color.g || LastColor.b != Color.b || LastColor.a != Alpha || LastQuadOffset != QuadOffset)
 				{
 					Graphics()->TextureSet(aParticles[LastQuadOffset - FirstParticleOffset]);
 					Graphics()->RenderQuadContainerAsSpriteMultiple(ParticleQuadContainerIndex, LastQuadOffset - FirstParticleOffset, CurParticleRenderCount, s_aParticleRenderInfo);
 					CurParticleRenderCount = 0;
 					LastQuadOffset = QuadOffset;
 
-					Graphics()->SetColor(
-						m_aParticles[i].m_Color.r,
-						m_aParticles[i].m_Color.g,
-						m_aParticles[i].m_Color.b,
-						Alpha);
-
-					LastColor.r = m_aParticles[i].m_Color.r;
-					LastColor.g = m_aParticles[i].m_Color.g;
-					LastColor.b = m_aParticles[i].m_Color.b;
+					LastColor = Color;
 					LastColor.a = Alpha;
+					Graphics()->SetColor(LastColor);
 				}
 
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[0] = p.x;
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Pos[1] = p.y;
 				s_aParticleRenderInfo[CurParticleRenderCount].m_Scale = Size;
-				s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = m_aParticles[i].m_Rot;
+				s_aParticleRenderInfo[CurParticleRenderCount].m_Rotation = Parts.m_vRot[i];
 
 				++CurParticleRenderCount;
 			}
-
-			i = m_aParticles[i].m_NextPart;
 		}
 
 		Graphics()->TextureSet(aParticles[LastQuadOffset - FirstParticleOffset]);
@@ -304,43 +344,41 @@ void CParticles::RenderGroup(int Group)
 	}
 	else
 	{
-		int i = m_aFirstPart[Group];
-
 		Graphics()->BlendNormal();
 		Graphics()->WrapClamp();
 
-		while(i != -1)
+		// one batch for all consecutive particles with the same sprite
+		int LastSpr = -1;
+		for(int i = Num - 1; i >= 0; i--)
 		{
-			float a = m_aParticles[i].m_Life / m_aParticles[i].m_LifeSpan;
-			vec2 p = m_aParticles[i].m_Pos;
-			float Size = mix(m_aParticles[i].m_StartSize, m_aParticles[i].m_EndSize, a);
-			float Alpha = m_aParticles[i].m_Color.a;
-			if(m_aParticles[i].m_UseAlphaFading)
-			{
-				Alpha = mix(m_aParticles[i].m_StartAlpha, m_aParticles[i].m_EndAlpha, a);
-			}
+			float a = Parts.m_vLife[i] / Parts.m_vLifeSpan[i];
+			vec2 p = Parts.m_vPos[i];
+			float Size = mix(Parts.m_vStartSize[i], Parts.m_vEndSize[i], a);
 
 			// the current position, respecting the size, is inside the viewport, render it, else ignore
-			if(ParticleIsVisibleOnScreen(p, Size))
+			if(!ParticleIsVisibleOnScreen(p, Size))
+				continue;
+
+			if(Parts.m_vSpr[i] != LastSpr)
 			{
-				Graphics()->TextureSet(aParticles[m_aParticles[i].m_Spr - FirstParticleOffset]);
+				if(LastSpr != -1)
+					Graphics()->QuadsEnd();
+				LastSpr = Parts.m_vSpr[i];
+				Graphics()->TextureSet(aParticles[LastSpr - FirstParticleOffset]);
 				Graphics()->QuadsBegin();
+			}
 
-				Graphics()->QuadsSetRotation(m_aParticles[i].m_Rot);
-
-				Graphics()->SetColor(
-					m_aParticles[i].m_Color.r,
-					m_aParticles[i].m_Color.g,
-					m_aParticles[i].m_Color.b,
-					Alpha);
+			Graphics()->QuadsSetRotation(Parts.m_vRot[i]);
 
-				IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
-				Graphics()->QuadsDraw(&QuadItem, 1);
-				Graphics()->QuadsEnd();
-			}
+			ColorRGBA Color = Parts.m_vColor[i];
+			Color.a = GetAlpha(i, a);
+			Graphics()->SetColor(Color);
 
-			i = m_aParticles[i].m_NextPart;
+			IGraphics::CQuadItem QuadItem(p.x, p.y, Size, Size);
+			Graphics()->QuadsDraw(&QuadItem, 1);
 		}
+		if(LastSpr != -1)
+			Graphics()->QuadsEnd();
 		Graphics()->WrapNormal();
 		Graphics()->BlendNormal();
 	}
@@ -7,6 +7,8 @@
 
 #include <game/client/component.h>
 
+#include <vector>
+
 // particles
 struct CParticle
 {
@@ -54,11 +56,6 @@ struct CParticle
 	ColorRGBA m_Color;
 
 	bool m_Collides;
-
-	// set by the particle system
-	float m_Life;
-	int m_PrevPart;
-	int m_NextPart;
 };
 
 class CParticles : public CComponent
@@ -94,9 +91,42 @@ private:
 		MAX_PARTICLES = 1024 * 8,
 	};
 
-	CParticle m_aParticles[MAX_PARTICLES];
-	int m_FirstFree;
-	int m_aFirstPart[NUM_GROUPS];
+	// the particles of a group as structure of arrays, without gaps and
+	// in the order they were added
+	class CGroup
+	{
+	public:
+		// changed every update
+		std::vector<vec2> m_vPos;
+		std::vector<vec2> m_vVel;
+		std::vector<float> m_vLife;
+		std::vector<float> m_vRot;
+
+		// read by the update
+		std::vector<float> m_vLifeSpan;
+		std::vector<float> m_vGravity;
+		std::vector<float> m_vFriction;
+		std::vector<float> m_vRotspeed;
+		std::vector<uint8_t> m_vCollides;
+
+		// only read for rendering
+		std::vector<ColorRGBA> m_vColor;
+		std::vector<int> m_vSpr;
+		std::vector<float> m_vStartSize;
+		std::vector<float> m_vEndSize;
+		std::vector<uint8_t> m_vUseAlphaFading;
+		std::vector<float> m_vStartAlpha;
+		std::vector<float> m_vEndAlpha;
+
+		int Num() const { return m_vPos.size(); }
+		void Add(const CParticle &Part, float Life);
+		// removes the particles past their life span, returns how many
+		int RemoveDead();
+		void Clear();
+	};
+
+	CGroup m_aGroups[NUM_GROUPS];
+	int m_NumParticles;
 
 	float m_FrictionFraction = 0.0f;
 	int64_t m_LastRenderTime = 0;
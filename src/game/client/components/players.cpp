@@ -1495,6 +1495,7 @@ void CPlayers::OnRender()
 	}
 
 	// render spectating players
+	RenderTools()->BeginTeeBatch();
 	for(const auto &Client : GameClient()->m_aClients)
 	{
 		if(!Client.m_SpecCharPresent)
@@ -1510,6 +1511,7 @@ void CPlayers::OnRender()
 		}
 		RenderTools()->RenderTee(CAnimState::GetIdle(), &SpectatorTeeRenderInfo()->TeeRenderInfo(), EMOTE_BLINK, vec2(1, 0), Client.m_SpecChar, Alpha);
 	}
+	RenderTools()->EndTeeBatch();
 
 	// render everyone else's tee, then either our own or the tee we are spectating.
 	const int RenderLastId = (GameClient()->m_Snap.m_SpecInfo.m_SpectatorId != SPEC_FREEVIEW && GameClient()->m_Snap.m_SpecInfo.m_Active) ? GameClient()->m_Snap.m_SpecInfo.m_SpectatorId : LocalClientId;
@@ -351,6 +351,8 @@ void CScoreboard::RenderScoreboard(CUIRect Scoreboard, int Team, int CountStart,
 	char aBuf[64];
 	int MaxTeamSize = Config()->m_SvMaxTeamSize;
 
+	// the tees do not overlap the rest of the rows
+	RenderTools()->BeginTeeBatch();
 	for(int RenderDead = 0; RenderDead < 2; RenderDead++)
 	{
 		for(int i = 0; i < MAX_CLIENTS; i++)
@@ -613,6 +615,7 @@ void CScoreboard::RenderScoreboard(CUIRect Scoreboard, int Team, int CountStart,
 				break;
 		}
 	}
+	RenderTools()->EndTeeBatch();
 }
 
 void CScoreboard::RenderRecordingNotification(float x)
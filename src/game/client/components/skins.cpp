@@ -8,6 +8,7 @@
 #include <base/system.h>
 
 #include <engine/engine.h>
+#include <engine/gfx/image_cache.h>
 #include <engine/gfx/image_manipulation.h>
 #include <engine/graphics.h>
 #include <engine/shared/config.h>
@@ -30,8 +31,20 @@ CSkins::CAbstractSkinLoadJob::CAbstractSkinLoadJob(CSkins *pSkins, const char *p
 
 CSkins::CAbstractSkinLoadJob::~CAbstractSkinLoadJob()
 {
-	m_Data.m_Info.Free();
-	m_Data.m_InfoGrayscale.Free();
+	m_Data.Free();
+}
+
+void CSkins::CSkinLoadData::Free()
+{
+	m_Info.Free();
+	for(CImageInfo &Part : m_aOriginalParts)
+	{
+		Part.Free();
+	}
+	for(CImageInfo &Part : m_aColorableParts)
+	{
+		Part.Free();
+	}
 }
 
 CSkins::CSkinLoadJob::CSkinLoadJob(CSkins *pSkins, const char *pName, int StorageType) :
@@ -285,6 +298,42 @@ static void CheckMetrics(CSkin::CSkinMetricVariable &Metrics, const uint8_t *pIm
 	Metrics.m_MaxHeight = CheckHeight;
 }
 
+const CDataSprite *CSkins::SkinPartSprite(int Part)
+{
+	static const int s_aPartSprites[CSkinLoadData::NUM_PARTS] = {
+		SPRITE_TEE_BODY,
+		SPRITE_TEE_BODY_OUTLINE,
+		SPRITE_TEE_FOOT,
+		SPRITE_TEE_FOOT_OUTLINE,
+		SPRITE_TEE_HAND,
+		SPRITE_TEE_HAND_OUTLINE,
+		SPRITE_TEE_EYE_NORMAL,
+		SPRITE_TEE_EYE_ANGRY,
+		SPRITE_TEE_EYE_PAIN,
+		SPRITE_TEE_EYE_HAPPY,
+		SPRITE_TEE_EYE_DEAD,
+		SPRITE_TEE_EYE_SURPRISE,
+	};
+	return &g_pData->m_aSprites[s_aPartSprites[Part]];
+}
+
+// Same as the copy done by IGraphics::LoadSpriteTexture, but can run on any thread
+static CImageInfo ExtractSkinPart(const CImageInfo &Image, const CDataSprite *pSprite)
+{
+	const int ImageGridX = Image.m_Width / pSprite->m_pSet->m_Gridx;
+	const int ImageGridY = Image.m_Height / pSprite->m_pSet->m_Gridy;
+	const int Width = pSprite->m_W * ImageGridX;
+	const int Height = pSprite->m_H * ImageGridY;
+
+	CImageInfo Part;
+	Part.m_Width = Width;
+	Part.m_Height = Height;
+	Part.m_Format = Image.m_Format;
+	Part.m_pData = static_cast<uint8_t *>(malloc(Part.DataSize()));
+	Part.CopyRectFrom(Image, pSprite->m_X * ImageGridX, pSprite->m_Y * ImageGridY, Width, Height, 0, 0);
+	return Part;
+}
+
 bool CSkins::LoadSkinData(const char *pName, CSkinLoadData &Data) const
 {
 	if(!Graphics()->CheckImageDivisibility(pName, Data.m_Info, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridx, g_pData->m_aSprites[SPRITE_TEE_BODY].m_pSet->m_Gridy, true))
@@ -358,8 +407,8 @@ bool CSkins::LoadSkinData(const char *pName, CSkinLoadData &Data) const
 	CheckMetrics(Data.m_Metrics.m_Feet, Data.m_Info.m_pData, Pitch, FeetOffsetX, FeetOffsetY, FeetWidth, FeetHeight);
 	CheckMetrics(Data.m_Metrics.m_Feet, Data.m_Info.m_pData, Pitch, FeetOutlineOffsetX, FeetOutlineOffsetY, FeetOutlineWidth, FeetOutlineHeight);
 
-	Data.m_InfoGrayscale = Data.m_Info.DeepCopy();
-	ConvertToGrayscale(Data.m_InfoGrayscale);
+	CImageInfo InfoGrayscale = Data.m_Info.DeepCopy();
+	ConvertToGrayscale(InfoGrayscale);
 
 	int aFreq[256] = {0};
 	uint8_t OrgWeight = 1;
@@ -371,9 +420,9 @@ bool CSkins::LoadSkinData(const char *pName, CSkinLoadData &Data) const
 		for(size_t x = 0; x < BodyWidth; x++)
 		{
 			const size_t Offset = y * Pitch + x * PixelStep;
-			if(Data.m_InfoGrayscale.m_pData[Offset + 3] > 128)
+			if(InfoGrayscale.m_pData[Offset + 3] > 128)
 			{
-				aFreq[Data.m_InfoGrayscale.m_pData[Offset]]++;
+				aFreq[InfoGrayscale.m_pData[Offset]]++;
 			}
 		}
 	}
@@ -392,7 +441,7 @@ bool CSkins::LoadSkinData(const char *pName, CSkinLoadData &Data) const
 		for(size_t x = 0; x < BodyWidth; x++)
 		{
 			const size_t Offset = y * Pitch + x * PixelStep;
-			uint8_t v = Data.m_InfoGrayscale.m_pData[Offset];
+			uint8_t v = InfoGrayscale.m_pData[Offset];
 			if(v <= OrgWeight)
 			{
 				v = (uint8_t)((v / (float)OrgWeight) * NewWeight);
@@ -401,40 +450,123 @@ bool CSkins::LoadSkinData(const char *pName, CSkinLoadData &Data) const
 			{
 				v = (uint8_t)(((v - OrgWeight) / (float)(255 - OrgWeight)) * (255 - NewWeight) + NewWeight);
 			}
-			Data.m_InfoGrayscale.m_pData[Offset] = v;
-			Data.m_InfoGrayscale.m_pData[Offset + 1] = v;
-			Data.m_InfoGrayscale.m_pData[Offset + 2] = v;
+			InfoGrayscale.m_pData[Offset] = v;
+			InfoGrayscale.m_pData[Offset + 1] = v;
+			InfoGrayscale.m_pData[Offset + 2] = v;
 		}
 	}
 
+	// Split the parts here so the main thread only has to upload them
+	for(int Part = 0; Part < CSkinLoadData::NUM_PARTS; ++Part)
+	{
+		Data.m_aOriginalParts[Part] = ExtractSkinPart(Data.m_Info, SkinPartSprite(Part));
+		Data.m_aColorableParts[Part] = ExtractSkinPart(InfoGrayscale, SkinPartSprite(Part));
+	}
+	InfoGrayscale.Free();
+	Data.m_Info.Free();
+
 	return true;
 }
 
-void CSkins::LoadSkinFinish(CSkinContainer *pSkinContainer, const CSkinLoadData &Data)
+// Increase when LoadSkinData changes the resulting images or metrics
+static constexpr int SKIN_CACHE_VERSION = 1;
+
+// Data of a skin stored in the cache next to the part images
+class CSkinCacheExtra
 {
-	CSkin Skin{pSkinContainer->Name()};
+public:
+	float m_aBloodColor[4];
+	int m_aaMetrics[2][6];
+};
 
-	Skin.m_OriginalSkin.m_Body = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
-	Skin.m_OriginalSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
-	Skin.m_OriginalSkin.m_Feet = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_FOOT]);
-	Skin.m_OriginalSkin.m_FeetOutline = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE]);
-	Skin.m_OriginalSkin.m_Hands = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_HAND]);
-	Skin.m_OriginalSkin.m_HandsOutline = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_HAND_OUTLINE]);
-	for(size_t i = 0; i < std::size(Skin.m_OriginalSkin.m_aEyes); ++i)
+bool CSkins::LoadSkinPng(const char *pName, const uint8_t *pPngData, size_t PngSize, const char *pContextName, CSkinLoadData &Data) const
+{
+	const SHA256_DIGEST Sha256 = sha256(pPngData, PngSize);
+	const CImageCache Cache(Storage(), "cache/skins", SKIN_CACHE_VERSION);
+	CImageInfo aParts[2 * CSkinLoadData::NUM_PARTS];
+	CSkinCacheExtra Extra;
+	CSkin::CSkinMetricVariable *apMetrics[] = {&Data.m_Metrics.m_Body, &Data.m_Metrics.m_Feet};
+	if(Cache.Load(Sha256, aParts, std::size(aParts), &Extra, sizeof(Extra)))
+	{
+		for(int Part = 0; Part < CSkinLoadData::NUM_PARTS; ++Part)
+		{
+			Data.m_aOriginalParts[Part] = std::move(aParts[Part]);
+			Data.m_aColorableParts[Part] = std::move(aParts[CSkinLoadData::NUM_PARTS + Part]);
+		}
+		Data.m_BloodColor = ColorRGBA(Extra.m_aBloodColor[0], Extra.m_aBloodColor[1], Extra.m_aBloodColor[2], Extra.m_aBloodColor[3]);
+		for(size_t i = 0; i < std::size(apMetrics); ++i)
+		{
+			// Assign the values directly, the assignment operators only extend the metrics
+			apMetrics[i]->m_Width.m_Value = Extra.m_aaMetrics[i][0];
+			apMetrics[i]->m_Height.m_Value = Extra.m_aaMetrics[i][1];
+			apMetrics[i]->m_OffsetX.m_Value = Extra.m_aaMetrics[i][2];
+			apMetrics[i]->m_OffsetY.m_Value = Extra.m_aaMetrics[i][3];
+			apMetrics[i]->m_MaxWidth.m_Value = Extra.m_aaMetrics[i][4];
+			apMetrics[i]->m_MaxHeight.m_Value = Extra.m_aaMetrics[i][5];
+		}
+		return true;
+	}
+
+	if(!Graphics()->LoadPng(Data.m_Info, pPngData, PngSize, pContextName))
+	{
+		return false;
+	}
+	if(!LoadSkinData(pName, Data))
 	{
-		Skin.m_OriginalSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(Data.m_Info, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
+		return false;
 	}
 
-	Skin.m_ColorableSkin.m_Body = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_BODY]);
-	Skin.m_ColorableSkin.m_BodyOutline = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_BODY_OUTLINE]);
-	Skin.m_ColorableSkin.m_Feet = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_FOOT]);
-	Skin.m_ColorableSkin.m_FeetOutline = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_FOOT_OUTLINE]);
-	Skin.m_ColorableSkin.m_Hands = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_HAND]);
-	Skin.m_ColorableSkin.m_HandsOutline = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_HAND_OUTLINE]);
-	for(size_t i = 0; i < std::size(Skin.m_ColorableSkin.m_aEyes); ++i)
+	for(int Part = 0; Part < CSkinLoadData::NUM_PARTS; ++Part)
+	{
+		aParts[Part] = std::move(Data.m_aOriginalParts[Part]);
+		aParts[CSkinLoadData::NUM_PARTS + Part] = std::move(Data.m_aColorableParts[Part]);
+	}
+	Extra.m_aBloodColor[0] = Data.m_BloodColor.r;
+	Extra.m_aBloodColor[1] = Data.m_BloodColor.g;
+	Extra.m_aBloodColor[2] = Data.m_BloodColor.b;
+	Extra.m_aBloodColor[3] = Data.m_BloodColor.a;
+	for(size_t i = 0; i < std::size(apMetrics); ++i)
 	{
-		Skin.m_ColorableSkin.m_aEyes[i] = Graphics()->LoadSpriteTexture(Data.m_InfoGrayscale, &g_pData->m_aSprites[SPRITE_TEE_EYE_NORMAL + i]);
+		Extra.m_aaMetrics[i][0] = apMetrics[i]->m_Width.m_Value;
+		Extra.m_aaMetrics[i][1] = apMetrics[i]->m_Height.m_Value;
+		Extra.m_aaMetrics[i][2] = apMetrics[i]->m_OffsetX.m_Value;
+		Extra.m_aaMetrics[i][3] = apMetrics[i]->m_OffsetY.m_Value;
+		Extra.m_aaMetrics[i][4] = apMetrics[i]->m_MaxWidth.m_Value;
+		Extra.m_aaMetrics[i][5] = apMetrics[i]->m_MaxHeight.m_Value;
 	}
+	if(!Cache.Save(Sha256, aParts, std::size(aParts), &Extra, sizeof(Extra)))
+	{
+		log_warn("skins", "Failed to write skin '%s' to the cache", pName);
+	}
+	for(int Part = 0; Part < CSkinLoadData::NUM_PARTS; ++Part)
+	{
+		Data.m_aOriginalParts[Part] = std::move(aParts[Part]);
+		Data.m_aColorableParts[Part] = std::move(aParts[CSkinLoadData::NUM_PARTS + Part]);
+	}
+	return true;
+}
+
+void CSkins::LoadSkinFinish(CSkinContainer *pSkinContainer, CSkinLoadData &Data)
+{
+	CSkin Skin{pSkinContainer->Name()};
+
+	const auto &&LoadTextures = [&](CSkin::CSkinTextures &Textures, CImageInfo *pParts) {
+		const auto &&LoadPart = [&](int Part) {
+			return Graphics()->LoadTextureRawMove(pParts[Part], 0, SkinPartSprite(Part)->m_pName);
+		};
+		Textures.m_Body = LoadPart(CSkinLoadData::PART_BODY);
+		Textures.m_BodyOutline = LoadPart(CSkinLoadData::PART_BODY_OUTLINE);
+		Textures.m_Feet = LoadPart(CSkinLoadData::PART_FEET);
+		Textures.m_FeetOutline = LoadPart(CSkinLoadData::PART_FEET_OUTLINE);
+		Textures.m_Hands = LoadPart(CSkinLoadData::PART_HANDS);
+		Textures.m_HandsOutline = LoadPart(CSkinLoadData::PART_HANDS_OUTLINE);
+		for(size_t i = 0; i < std::size(Textures.m_aEyes); ++i)
+		{
+			Textures.m_aEyes[i] = LoadPart(CSkinLoadData::PART_EYES + i);
+		}
+	};
+	LoadTextures(Skin.m_OriginalSkin, Data.m_aOriginalParts);
+	LoadTextures(Skin.m_ColorableSkin, Data.m_aColorableParts);
 
 	Skin.m_Metrics = Data.m_Metrics;
 	Skin.m_BloodColor = Data.m_BloodColor;
@@ -465,21 +597,27 @@ void CSkins::LoadSkinDirect(const char *pName)
 	str_format(aPath, sizeof(aPath), "skins/%s.png", pName);
 	CSkinLoadData DefaultSkinData;
 	SkinIt->second->SetState(CSkinContainer::EState::LOADING);
-	if(!Graphics()->LoadPng(DefaultSkinData.m_Info, aPath, SkinIt->second->StorageType()))
+	void *pPngData;
+	unsigned PngSize;
+	if(!Storage()->ReadFile(aPath, SkinIt->second->StorageType(), &pPngData, &PngSize))
 	{
 		log_error("skins", "Failed to load PNG of skin '%s' from '%s'", pName, aPath);
 		SkinIt->second->SetState(CSkinContainer::EState::ERROR);
 	}
-	else if(LoadSkinData(pName, DefaultSkinData))
-	{
-		LoadSkinFinish(SkinIt->second.get(), DefaultSkinData);
-	}
 	else
 	{
-		SkinIt->second->SetState(CSkinContainer::EState::ERROR);
+		if(LoadSkinPng(pName, static_cast<uint8_t *>(pPngData), PngSize, aPath, DefaultSkinData))
+		{
+			LoadSkinFinish(SkinIt->second.get(), DefaultSkinData);
+		}
+		else
+		{
+			log_error("skins", "Failed to load PNG of skin '%s' from '%s'", pName, aPath);
+			SkinIt->second->SetState(CSkinContainer::EState::ERROR);
+		}
+		free(pPngData);
 	}
-	DefaultSkinData.m_Info.Free();
-	DefaultSkinData.m_InfoGrayscale.Free();
+	DefaultSkinData.Free();
 }
 
 void CSkins::OnConsoleInit()
@@ -628,6 +766,8 @@ void CSkins::UpdateStartLoading(CSkinLoadingStats &Stats)
 
 void CSkins::UpdateFinishLoading(CSkinLoadingStats &Stats, std::chrono::nanoseconds StartTime, std::chrono::nanoseconds MaxTime)
 {
+	// The uploads are only queued here, limit them so the backend does not stall on a large batch
+	size_t NumToFinish = 8;
 	for(auto &[_, pSkinContainer] : m_Skins)
 	{
 		if(Stats.m_NumLoading == 0)
@@ -644,13 +784,14 @@ void CSkins::UpdateFinishLoading(CSkinLoadingStats &Stats, std::chrono::nanoseco
 			continue;
 		}
 		Stats.m_NumLoading--;
-		if(pSkinContainer->m_pLoadJob->State() == IJob::STATE_DONE && pSkinContainer->m_pLoadJob->m_Data.m_Info.m_pData)
+		if(pSkinContainer->m_pLoadJob->State() == IJob::STATE_DONE && pSkinContainer->m_pLoadJob->m_Data.IsLoaded())
 		{
 			LoadSkinFinish(pSkinContainer.get(), pSkinContainer->m_pLoadJob->m_Data);
 			GameClient()->OnSkinUpdate(pSkinContainer->Name());
 			pSkinContainer->m_pLoadJob = nullptr;
 			Stats.m_NumLoaded++;
-			if(time_get_nanoseconds() - StartTime >= MaxTime)
+			NumToFinish--;
+			if(NumToFinish == 0 || time_get_nanoseconds() - StartTime >= MaxTime)
 			{
 				// Avoid using too much frame time for loading skins
 				break;
@@ -949,18 +1090,18 @@ void CSkins::CSkinLoadJob::Run()
 {
 	char aPath[IO_MAX_PATH_LENGTH];
 	str_format(aPath, sizeof(aPath), "skins/%s.png", m_aName);
-	if(m_pSkins->Graphics()->LoadPng(m_Data.m_Info, aPath, m_StorageType))
+	void *pPngData;
+	unsigned PngSize;
+	if(!m_pSkins->Storage()->ReadFile(aPath, m_StorageType, &pPngData, &PngSize))
 	{
-		if(State() == IJob::STATE_ABORTED)
-		{
-			return;
-		}
-		m_pSkins->LoadSkinData(m_aName, m_Data);
+		log_error("skins", "Failed to load PNG of skin '%s' from '%s'", m_aName, aPath);
+		return;
 	}
-	else
+	if(State() != IJob::STATE_ABORTED && !m_pSkins->LoadSkinPng(m_aName, static_cast<uint8_t *>(pPngData), PngSize, aPath, m_Data))
 	{
 		log_error("skins", "Failed to load PNG of skin '%s' from '%s'", m_aName, aPath);
 	}
+	free(pPngData);
 }
 
 CSkins::CSkinDownloadJob::CSkinDownloadJob(CSkins *pSkins, const char *pName) :
@@ -1018,15 +1159,15 @@ void CSkins::CSkinDownloadJob::Run()
 		unsigned PngSize;
 		if(m_pSkins->Storage()->ReadFile(aPathReal, IStorage::TYPE_SAVE, &pPngData, &PngSize))
 		{
-			if(m_pSkins->Graphics()->LoadPng(m_Data.m_Info, static_cast<uint8_t *>(pPngData), PngSize, aPathReal))
+			if(State() != IJob::STATE_ABORTED)
 			{
-				if(State() == IJob::STATE_ABORTED)
-				{
-					return;
-				}
-				m_pSkins->LoadSkinData(m_aName, m_Data);
+				m_pSkins->LoadSkinPng(m_aName, static_cast<uint8_t *>(pPngData), PngSize, aPathReal, m_Data);
 			}
 			free(pPngData);
+			if(State() == IJob::STATE_ABORTED)
+			{
+				return;
+			}
 		}
 	}
 
@@ -1042,7 +1183,7 @@ void CSkins::CSkinDownloadJob::Run()
 	}
 	if(pGet->StatusCode() == 304) // 304 Not Modified
 	{
-		bool Success = m_Data.m_Info.m_pData != nullptr;
+		bool Success = m_Data.IsLoaded();
 		pGet->OnValidation(Success);
 		if(Success)
 		{
@@ -1078,18 +1219,13 @@ void CSkins::CSkinDownloadJob::Run()
 	size_t ResultSize;
 	pGet->Result(&pResult, &ResultSize);
 
-	m_Data.m_Info.Free();
-	m_Data.m_InfoGrayscale.Free();
-	const bool Success = m_pSkins->Graphics()->LoadPng(m_Data.m_Info, pResult, ResultSize, aUrl);
-	if(Success)
+	m_Data.Free();
+	if(State() == IJob::STATE_ABORTED)
 	{
-		if(State() == IJob::STATE_ABORTED)
-		{
-			return;
-		}
-		m_pSkins->LoadSkinData(m_aName, m_Data);
+		return;
 	}
-	else
+	const bool Success = m_pSkins->LoadSkinPng(m_aName, pResult, ResultSize, aUrl, m_Data);
+	if(!Success)
 	{
 		log_error("skins", "Failed to load PNG of skin '%s' downloaded from '%s' (size %" PRIzu ")", m_aName, aUrl, ResultSize);
 	}
@@ -30,10 +30,32 @@ private:
 	class CSkinLoadData
 	{
 	public:
+		enum
+		{
+			PART_BODY = 0,
+			PART_BODY_OUTLINE,
+			PART_FEET,
+			PART_FEET_OUTLINE,
+			PART_HANDS,
+			PART_HANDS_OUTLINE,
+			PART_EYES,
+			NUM_PARTS = PART_EYES + 6,
+		};
+
+		/**
+		 * The decoded skin image, only used until it is split into the parts.
+		 */
 		CImageInfo m_Info;
-		CImageInfo m_InfoGrayscale;
+		/**
+		 * The parts of the original and the colorable skin, ready to be uploaded without copying.
+		 */
+		CImageInfo m_aOriginalParts[NUM_PARTS];
+		CImageInfo m_aColorableParts[NUM_PARTS];
 		CSkin::CSkinMetrics m_Metrics;
 		ColorRGBA m_BloodColor;
+
+		bool IsLoaded() const { return m_aOriginalParts[PART_BODY].m_pData != nullptr; }
+		void Free();
 	};
 
 	/**
@@ -306,8 +328,10 @@ private:
 	CSkin m_PlaceholderSkin;
 	char m_aEventSkinPrefix[MAX_SKIN_LENGTH];
 
+	static const CDataSprite *SkinPartSprite(int Part);
+	bool LoadSkinPng(const char *pName, const uint8_t *pPngData, size_t PngSize, const char *pContextName, CSkinLoadData &Data) const;
 	bool LoadSkinData(const char *pName, CSkinLoadData &Data) const;
-	void LoadSkinFinish(CSkinContainer *pSkinContainer, const CSkinLoadData &Data);
+	void LoadSkinFinish(CSkinContainer *pSkinContainer, CSkinLoadData &Data);
 	void LoadSkinDirect(const char *pName);
 	const CSkinContainer *FindContainerImpl(const char *pName);
 	static int SkinScan(const char *pName, int IsDir, int StorageType, void *pUser);
@@ -19,176 +19,6 @@ static std::optional<bool> RegexMatch(const char *pString, const char *pRegex)
 	return regex_match(aTokens, pString, 0, 0, 0, 0) != -1;
 }
 
-int CConditional::ParseValue(char *pBuf, int Length)
-{
-	const char *pFirstSpace = nullptr;
-	for(const char *p = pBuf; *p != '\0'; ++p)
-	{
-		if(*p == ' ')
-		{
-			pFirstSpace = p;
-			break;
-		}
-	}
-	if(pFirstSpace && *(pFirstSpace + 1) != '\0')
-	{
-		// Is a function, only function calls have spaces
-		const int FuncLength = pFirstSpace - pBuf;
-		char aParam[256];
-		str_copy(aParam, pFirstSpace + 1);
-		ParseString(aParam, sizeof(aParam));
-		for(const auto &[Key, FFunc] : m_vFunctions)
-			if(str_comp_nocase_num(pBuf, Key.c_str(), FuncLength) == 0)
-				return FFunc(aParam, pBuf, Length);
-	}
-	else
-	{
-		// Is a variable
-		if(m_pResult)
-		{
-			// Check for numerics
-			int Index;
-			if(str_toint(pBuf, &Index))
-			{
-				if(Index >= 0)
-					return str_copy(pBuf, m_pResult->GetString(Index), Length);
-				else
-					return str_copy(pBuf, "", Length);
-			}
-		}
-		for(const auto &[Key, FFunc] : m_vVariables)
-			if(str_comp_nocase(pBuf, Key.c_str()) == 0)
-				return FFunc(pBuf, Length);
-	}
-	return -1;
-}
-
-void CConditional::ParseString(char *pBuf, int Length)
-{
-	if(!pBuf || Length <= 0)
-		return;
-	bool HasBrackets = false;
-	for(const char *p = pBuf; *p != '\0'; ++p)
-		if(*p == '{' || *p == '}')
-			HasBrackets = true;
-	if(!HasBrackets)
-		return;
-
-	// May give malformed result on buffer overflow
-
-	int Len = strnlen(pBuf, Length);
-	while(true)
-	{
-		int LastOpen = -1;
-		int ClosePos = -1;
-
-		// Find the innermost {...} not inside any parsed range
-		for(int i = 0; i < Len; ++i)
-		{
-			if(pBuf[i] != '{' && pBuf[i] != '}')
-				continue;
-			// Count number of backslashes before this character
-			int BackslashCount = 0;
-			for(int j = i - 1; j >= 0 && pBuf[j] == '\\'; --j)
-				BackslashCount++;
-			if(BackslashCount % 2 != 0)
-				continue;
-			if(pBuf[i] == '{')
-			{
-				LastOpen = i;
-			}
-			else if(pBuf[i] == '}' && LastOpen != -1)
-			{
-				ClosePos = i;
-				break;
-			}
-		}
-
-		if(LastOpen == -1 || ClosePos <= LastOpen)
-			break;
-
-		int ExprLen = ClosePos - LastOpen - 1;
-
-		char aTemp[512];
-		int CopyLen = std::min(ExprLen, (int)sizeof(aTemp) - 1);
-		mem_copy(aTemp, pBuf + LastOpen + 1, CopyLen);
-		aTemp[CopyLen] = '\0';
-
-		int ResultLen = ParseValue(aTemp, sizeof(aTemp));
-		if(ResultLen == -1)
-		{
-			if(Len + 2 >= Length)
-				break; // Not enough space; stop
-			mem_move(pBuf + ClosePos + 1, pBuf + ClosePos, Len - ClosePos + 1);
-			pBuf[ClosePos] = '\\';
-			Len++;
-			mem_move(pBuf + LastOpen + 1, pBuf + LastOpen, Len - LastOpen + 1);
-			pBuf[LastOpen] = '\\';
-			Len++;
-		}
-		else
-		{
-			for(const char *p = aTemp; *p != '\0'; ++p)
-				if(*p == '{' || *p == '}' || *p == '\\')
-					ResultLen++;
-			mem_move(pBuf + LastOpen + ResultLen, pBuf + ClosePos + 1, Len - ClosePos);
-			EscapeString(aTemp, pBuf + LastOpen, Length - LastOpen);
-			Len -= ClosePos - LastOpen + 1;
-			Len += ResultLen;
-			pBuf[Len] = '\0';
-		}
-	}
-	UnescapeString(pBuf, Length);
-}
-
-int CConditional::EscapeString(char *pIn, char *pBuf, int Length)
-{
-	int WriteIndex = 0;
-	for(int i = 0; pIn[i] != '\0'; ++i)
-	{
-		char c = pIn[i];
-
-		// If we need to write an escape character and the actual character
-		if((c == '{' || c == '}' || c == '\\'))
-		{
-			if(WriteIndex + 2 >= Length)
-				break; // not enough room for escape + char + null
-			pBuf[WriteIndex++] = '\\';
-		}
-		else
-		{
-			if(WriteIndex + 1 >= Length)
-				break; // not enough room for char + null
-		}
-
-		pBuf[WriteIndex++] = c;
-	}
-	return WriteIndex;
-}
-
-void CConditional::UnescapeString(char *pString, int Length)
-{
-	int WritePos = 0; // Position to write the unescaped char
-	for(int ReadPos = 0; ReadPos < Length - 1; ReadPos++)
-	{
-		if(pString[ReadPos] == '\\' && ReadPos + 1 < Length)
-		{
-			char NextChar = pString[ReadPos + 1];
-			if(NextChar == '\\' || NextChar == '{' || NextChar == '}')
-			{
-				// Replace the escape sequence by the actual character
-				pString[WritePos++] = NextChar;
-				ReadPos++; // Skip the escaped character
-				continue;
-			}
-		}
-		// Normal character, copy as-is
-		pString[WritePos++] = pString[ReadPos];
-	}
-	// Null-terminate the resulting string
-	pString[WritePos] = '\0';
-}
-
 void CConditional::ConIfeq(IConsole::IResult *pResult, void *pUserData)
 {
 	CConditional *pThis = (CConditional *)pUserData;
@@ -447,6 +277,8 @@ void CConditional::OnConsoleInit()
 	Console()->Register("ifrneq", "s[a] s[b] r[command]", CFGFLAG_CLIENT, ConIfrneq, this, "Comapre 2 values, if a doesnt match the regex b run the command");
 	Console()->Register("return", "", CFGFLAG_CLIENT, ConReturn, this, "Stop executing the current script, does nothing in other contexts");
 
+	ClearPrograms();
+
 	Console()->m_FConditionalCompose = [this](char *pBuf, int Length) {
 		ParseString(pBuf, Length);
 	};
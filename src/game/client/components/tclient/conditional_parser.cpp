@@ -0,0 +1,328 @@
+#include "conditional_parser.h"
+
+#include <base/system.h>
+
+#include <algorithm>
+
+int CConditionalParser::ParseValue(char *pBuf, int Length)
+{
+	const char *pFirstSpace = nullptr;
+	for(const char *p = pBuf; *p != '\0'; ++p)
+	{
+		if(*p == ' ')
+		{
+			pFirstSpace = p;
+			break;
+		}
+	}
+	if(pFirstSpace && *(pFirstSpace + 1) != '\0')
+	{
+		// Is a function, only function calls have spaces
+		const int FuncLength = pFirstSpace - pBuf;
+		char aParam[256];
+		str_copy(aParam, pFirstSpace + 1);
+		ParseString(aParam, sizeof(aParam));
+		for(const auto &[Key, FFunc] : m_vFunctions)
+			if(str_comp_nocase_num(pBuf, Key.c_str(), FuncLength) == 0)
+				return FFunc(aParam, pBuf, Length);
+	}
+	else
+	{
+		// Is a variable
+		if(m_pResult)
+		{
+			// Check for numerics
+			int Index;
+			if(str_toint(pBuf, &Index))
+			{
+				if(Index >= 0)
+					return str_copy(pBuf, m_pResult->GetString(Index), Length);
+				else
+					return str_copy(pBuf, "", Length);
+			}
+		}
+		for(const auto &[Key, FFunc] : m_vVariables)
+			if(str_comp_nocase(pBuf, Key.c_str()) == 0)
+				return FFunc(pBuf, Length);
+	}
+	return -1;
+}
+
+void CConditionalParser::ResolveValue(CToken &Token, const char *pExpr) const
+{
+	// Same lookup as ParseValue, for expressions that do not contain other expressions
+	Token.m_Value = VALUE_UNKNOWN;
+	const char *pFirstSpace = str_find(pExpr, " ");
+	if(pFirstSpace && *(pFirstSpace + 1) != '\0')
+	{
+		const int FuncLength = pFirstSpace - pExpr;
+		for(int i = 0; i < (int)m_vFunctions.size(); ++i)
+		{
+			if(str_comp_nocase_num(pExpr, m_vFunctions[i].first.c_str(), FuncLength) != 0)
+				continue;
+			// The parameter can only contain escaped brackets, which ParseString would unescape
+			char aParam[256];
+			str_copy(aParam, pFirstSpace + 1);
+			if(str_find(aParam, "{") || str_find(aParam, "}"))
+				UnescapeString(aParam, sizeof(aParam));
+			Token.m_Value = VALUE_FUNCTION;
+			Token.m_Index = i;
+			Token.m_Param = aParam;
+			return;
+		}
+	}
+	else
+	{
+		int Index;
+		if(str_toint(pExpr, &Index))
+		{
+			Token.m_Value = VALUE_RESULT;
+			Token.m_Index = Index;
+			return;
+		}
+		for(int i = 0; i < (int)m_vVariables.size(); ++i)
+		{
+			if(str_comp_nocase(pExpr, m_vVariables[i].first.c_str()) != 0)
+				continue;
+			Token.m_Value = VALUE_VARIABLE;
+			Token.m_Index = i;
+			return;
+		}
+	}
+}
+
+const CConditionalParser::CProgram &CConditionalParser::Compile(std::string_view Source)
+{
+	auto It = m_Programs.find(Source);
+	if(It != m_Programs.end())
+		return It->second;
+	// Programs of a running evaluation must stay alive
+	if(m_Programs.size() >= MAX_PROGRAMS && m_RunDepth == 0)
+		m_Programs.clear();
+	CProgram &Program = m_Programs.emplace(Source, CProgram()).first->second;
+	Program.m_Source = Source;
+
+	// A closing bracket closes the last open one and escaped brackets are text,
+	// evaluating the tokens in order then gives the same result as substituting innermost first
+	const char *pSource = Program.m_Source.c_str();
+	const int SourceLength = Program.m_Source.size();
+	std::vector<int> vOpen; // Token of each open bracket
+	int TextStart = 0;
+	const auto AddText = [&](int End) {
+		if(End <= TextStart)
+			return;
+		CToken &Text = Program.m_vTokens.emplace_back();
+		Text.m_Type = TOKEN_TEXT;
+		Text.m_Offset = TextStart;
+		Text.m_Length = End - TextStart;
+	};
+	for(int i = 0; i < SourceLength; ++i)
+	{
+		if(pSource[i] != '{' && pSource[i] != '}')
+			continue;
+		int BackslashCount = 0;
+		for(int j = i - 1; j >= 0 && pSource[j] == '\\'; --j)
+			BackslashCount++;
+		if(BackslashCount % 2 != 0)
+			continue;
+		if(pSource[i] == '{')
+		{
+			AddText(i);
+			TextStart = i + 1;
+			vOpen.push_back(Program.m_vTokens.size());
+			Program.m_MaxDepth = std::max(Program.m_MaxDepth, (int)vOpen.size());
+			CToken &Open = Program.m_vTokens.emplace_back();
+			Open.m_Type = TOKEN_OPEN;
+			Open.m_Offset = i;
+			Open.m_Length = 1;
+		}
+		else if(!vOpen.empty())
+		{
+			const int Open = vOpen.back();
+			vOpen.pop_back();
+			AddText(i);
+			TextStart = i + 1;
+			CToken Close;
+			Close.m_Type = TOKEN_CLOSE;
+			Close.m_Offset = i;
+			Close.m_Length = 1;
+			const int NumInner = Program.m_vTokens.size() - Open - 1;
+			if(NumInner == 0)
+			{
+				ResolveValue(Close, "");
+			}
+			else if(NumInner == 1 && Program.m_vTokens.back().m_Type == TOKEN_TEXT && Program.m_vTokens.back().m_Length < 512)
+			{
+				char aExpr[512];
+				str_truncate(aExpr, sizeof(aExpr), pSource + Program.m_vTokens.back().m_Offset, Program.m_vTokens.back().m_Length);
+				ResolveValue(Close, aExpr);
+			}
+			Program.m_vTokens.push_back(std::move(Close));
+		}
+	}
+	AddText(SourceLength);
+	// Brackets that are never closed are text
+	for(int Open : vOpen)
+		Program.m_vTokens[Open].m_Type = TOKEN_TEXT;
+	return Program;
+}
+
+void CConditionalParser::RunProgram(const CProgram &Program, char *pBuf, int Length)
+{
+	// May give malformed result on buffer overflow
+	int Len = 0;
+	// Output position of each open bracket, only deeply nested strings need the heap
+	int aSmallStarts[32];
+	std::vector<int> vLargeStarts;
+	int *pStarts = aSmallStarts;
+	if(Program.m_MaxDepth > (int)std::size(aSmallStarts))
+	{
+		vLargeStarts.resize(Program.m_MaxDepth);
+		pStarts = vLargeStarts.data();
+	}
+	int Depth = 0;
+	const auto Append = [&](const char *pStr, int StrLength) {
+		const int Num = std::min(StrLength, Length - 1 - Len);
+		mem_copy(pBuf + Len, pStr, Num);
+		Len += Num;
+	};
+	for(const CToken &Token : Program.m_vTokens)
+	{
+		if(Token.m_Type == TOKEN_TEXT)
+		{
+			Append(Program.m_Source.c_str() + Token.m_Offset, Token.m_Length);
+			continue;
+		}
+		if(Token.m_Type == TOKEN_OPEN)
+		{
+			pStarts[Depth++] = Len;
+			continue;
+		}
+
+		const int Start = pStarts[--Depth];
+		char aTemp[512];
+		const int CopyLen = std::min(Len - Start, (int)sizeof(aTemp) - 1);
+		mem_copy(aTemp, pBuf + Start, CopyLen);
+		aTemp[CopyLen] = '\0';
+
+		int ResultLen;
+		switch(Token.m_Value)
+		{
+		case VALUE_UNKNOWN:
+			ResultLen = -1;
+			break;
+		case VALUE_VARIABLE:
+			ResultLen = m_vVariables[Token.m_Index].second(aTemp, sizeof(aTemp));
+			break;
+		case VALUE_FUNCTION:
+			ResultLen = m_vFunctions[Token.m_Index].second(Token.m_Param.c_str(), aTemp, sizeof(aTemp));
+			break;
+		case VALUE_RESULT:
+			if(!m_pResult)
+				ResultLen = ParseValue(aTemp, sizeof(aTemp));
+			else
+				ResultLen = str_copy(aTemp, Token.m_Index >= 0 ? m_pResult->GetString(Token.m_Index) : "", sizeof(aTemp));
+			break;
+		default:
+			ResultLen = ParseValue(aTemp, sizeof(aTemp));
+			break;
+		}
+
+		if(ResultLen == -1)
+		{
+			// Keep the expression, with escaped brackets. The check uses the length the string
+			// would have if it was substituted in place, the open brackets and the rest included
+			const int RestLength = Program.m_Source.size() - Token.m_Offset - 1;
+			if(Len + Depth + 2 + RestLength + 2 >= Length)
+			{
+				// Not enough space; stop and leave the open brackets and the rest as they are
+				Append("}", 1);
+				Append(Program.m_Source.c_str() + Token.m_Offset + 1, RestLength);
+				for(int i = Depth; i >= 0 && Len + 1 < Length; --i)
+				{
+					mem_move(pBuf + pStarts[i] + 1, pBuf + pStarts[i], Len - pStarts[i]);
+					pBuf[pStarts[i]] = '{';
+					Len++;
+				}
+				break;
+			}
+			mem_move(pBuf + Start + 2, pBuf + Start, Len - Start);
+			pBuf[Start] = '\\';
+			pBuf[Start + 1] = '{';
+			Len += 2;
+			Append("\\}", 2);
+		}
+		else
+		{
+			Len = Start + EscapeString(aTemp, pBuf + Start, Length - Start);
+		}
+	}
+	pBuf[Len] = '\0';
+}
+
+void CConditionalParser::ParseString(char *pBuf, int Length)
+{
+	if(!pBuf || Length <= 0)
+		return;
+	bool HasBrackets = false;
+	for(const char *p = pBuf; *p != '\0'; ++p)
+		if(*p == '{' || *p == '}')
+			HasBrackets = true;
+	if(!HasBrackets)
+		return;
+
+	// Binds run the same strings over and over, only compile them once
+	const CProgram &Program = Compile(std::string_view(pBuf, strnlen(pBuf, Length)));
+	m_RunDepth++;
+	RunProgram(Program, pBuf, Length);
+	m_RunDepth--;
+	UnescapeString(pBuf, Length);
+}
+
+int CConditionalParser::EscapeString(char *pIn, char *pBuf, int Length)
+{
+	int WriteIndex = 0;
+	for(int i = 0; pIn[i] != '\0'; ++i)
+	{
+		char c = pIn[i];
+
+		// If we need to write an escape character and the actual character
+		if((c == '{' || c == '}' || c == '\\'))
+		{
+			if(WriteIndex + 2 >= Length)
+				break; // not enough room for escape + char + null
+			pBuf[WriteIndex++] = '\\';
+		}
+		else
+		{
+			if(WriteIndex + 1 >= Length)
+				break; // not enough room for char + null
+		}
+
+		pBuf[WriteIndex++] = c;
+	}
+	return WriteIndex;
+}
+
+void CConditionalParser::UnescapeString(char *pString, int Length)
+{
+	int WritePos = 0; // Position to write the unescaped char
+	for(int ReadPos = 0; ReadPos < Length - 1; ReadPos++)
+	{
+		if(pString[ReadPos] == '\\' && ReadPos + 1 < Length)
+		{
+			char NextChar = pString[ReadPos + 1];
+			if(NextChar == '\\' || NextChar == '{' || NextChar == '}')
+			{
+				// Replace the escape sequence by the actual character
+				pString[WritePos++] = NextChar;
+				ReadPos++; // Skip the escaped character
+				continue;
+			}
+		}
+		// Normal character, copy as-is
+		pString[WritePos++] = pString[ReadPos];
+	}
+	// Null-terminate the resulting string
+	pString[WritePos] = '\0';
+}
@@ -0,0 +1,75 @@
+#ifndef GAME_CLIENT_COMPONENTS_TCLIENT_CONDITIONAL_PARSER_H
+#define GAME_CLIENT_COMPONENTS_TCLIENT_CONDITIONAL_PARSER_H
+
+#include <engine/console.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Substitutes the {variable} and {function param} expressions of a string, independent of the client
+class CConditionalParser
+{
+protected:
+	std::vector<std::pair<std::string, std::function<int(char *pOut, int Length)>>> m_vVariables;
+	std::vector<std::pair<std::string, std::function<int(const char *pParam, char *pOut, int Length)>>> m_vFunctions;
+	int ParseValue(char *pBuf, int Length);
+
+	// Programs refer to the variables and functions by index, call after changing them
+	void ClearPrograms() { m_Programs.clear(); }
+
+private:
+	enum
+	{
+		TOKEN_TEXT = 0,
+		TOKEN_OPEN,
+		TOKEN_CLOSE,
+
+		// what a closing token evaluates, decided when compiling
+		VALUE_DYNAMIC = 0, // contains other expressions, looked up by ParseValue
+		VALUE_UNKNOWN,
+		VALUE_VARIABLE,
+		VALUE_FUNCTION,
+		VALUE_RESULT, // numeric argument index, looked up by ParseValue without a result
+
+		MAX_PROGRAMS = 256,
+	};
+	class CToken
+	{
+	public:
+		int m_Type;
+		// TOKEN_TEXT: span of the source, still escaped, TOKEN_OPEN and TOKEN_CLOSE: the bracket
+		int m_Offset = 0;
+		int m_Length = 0;
+		// TOKEN_CLOSE
+		int m_Value = VALUE_DYNAMIC;
+		int m_Index = -1;
+		std::string m_Param;
+	};
+	// a string split into text and the expressions in it, innermost first
+	class CProgram
+	{
+	public:
+		std::string m_Source;
+		std::vector<CToken> m_vTokens;
+		int m_MaxDepth = 0;
+	};
+	std::map<std::string, CProgram, std::less<>> m_Programs;
+	int m_RunDepth = 0;
+	const CProgram &Compile(std::string_view Source);
+	void ResolveValue(CToken &Token, const char *pExpr) const;
+	void RunProgram(const CProgram &Program, char *pBuf, int Length);
+
+public:
+	virtual ~CConditionalParser() = default;
+
+	const IConsole::IResult *m_pResult = nullptr;
+
+	void ParseString(char *pBuf, int Length);
+	static int EscapeString(char *pIn, char *pBuf, int Length);
+	static void UnescapeString(char *pString, int Length); // Inplace
+};
+
+#endif
@@ -17,8 +17,14 @@ enum
 	OUTLINE_TELE,
 	OUTLINE_KILL,
 	OUTLINE_SOLID,
+	NUM_OUTLINES,
 };
 
+// Stays below the vertex limit of drawing a quad container without buffering
+static constexpr int MAX_CHUNK_QUADS = 4096;
+
+static constexpr float TILE_SCALE = 32.0f;
+
 enum class OutlineLayer
 {
 	GAME,
@@ -100,8 +106,166 @@ public:
 // The order of this determines order of priority into the one map (tele + freeze = tele)
 static constexpr COutLineLayer OUTLINE_LAYERS[] = {{OutlineLayer::TELE}, {OutlineLayer::GAME}, {OutlineLayer::FRONT}};
 
+int COutlines::GetTile(int x, int y) const
+{
+	x = std::clamp(x, 0, m_MapDataSize.x - 1);
+	y = std::clamp(y, 0, m_MapDataSize.y - 1);
+	return m_pMapData[y * m_MapDataSize.x + x];
+}
+
+int COutlines::GetTileQuads(int Type, int x, int y, float Width, IGraphics::CQuadItem *pQuads) const
+{
+	const float Scale = TILE_SCALE;
+	// Find neighbours
+	const bool aNeighbors[8] = {
+		GetTile(x - 1, y - 1) >= Type,
+		GetTile(x - 0, y - 1) >= Type,
+		GetTile(x + 1, y - 1) >= Type,
+		GetTile(x - 1, y + 0) >= Type,
+		GetTile(x + 1, y + 0) >= Type,
+		GetTile(x - 1, y + 1) >= Type,
+		GetTile(x + 0, y + 1) >= Type,
+		GetTile(x + 1, y + 1) >= Type,
+	};
+	// Figure out edges
+	int NumQuads = 0;
+	// Lone corners first
+	if(!aNeighbors[0] && aNeighbors[1] && aNeighbors[3])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Width, Width);
+	if(!aNeighbors[2] && aNeighbors[1] && aNeighbors[4])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale, Width, Width);
+	if(!aNeighbors[5] && aNeighbors[3] && aNeighbors[6])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Width, Width, Width);
+	if(!aNeighbors[7] && aNeighbors[6] && aNeighbors[4])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale + Scale - Width, Width, Width);
+	// Top
+	if(!aNeighbors[1])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Scale, Width);
+	// Bottom
+	if(!aNeighbors[6])
+		pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Width, Scale, Width);
+	// Left
+	if(!aNeighbors[3])
+	{
+		if(aNeighbors[1] && aNeighbors[6])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Width, Scale);
+		else if(aNeighbors[6])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Width, Width, Scale - Width);
+		else if(aNeighbors[1])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Width, Scale - Width);
+		else
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Width, Width, Scale - Width * 2.0f);
+	}
+	// Right
+	if(!aNeighbors[4])
+	{
+		if(aNeighbors[1] && aNeighbors[6])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale, Width, Scale);
+		else if(aNeighbors[6])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale + Width, Width, Scale - Width);
+		else if(aNeighbors[1])
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale, Width, Scale - Width);
+		else
+			pQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Width, y * Scale + Width, Width, Scale - Width * 2.0f);
+	}
+	return NumQuads;
+}
+
+void COutlines::ClearGeometry(int Type)
+{
+	CGeometry &Geometry = m_aGeometries[Type];
+	for(auto &vChunks : Geometry.m_avChunks)
+	{
+		for(auto &Chunk : vChunks)
+			Graphics()->DeleteQuadContainer(Chunk.m_QuadContainer);
+		vChunks.clear();
+	}
+	Geometry.m_Width = -1;
+}
+
+void COutlines::BuildGeometry(int Type, int Width)
+{
+	ClearGeometry(Type);
+	CGeometry &Geometry = m_aGeometries[Type];
+	Geometry.m_Width = Width;
+
+	// The color is applied when rendering
+	Graphics()->TextureClear();
+	Graphics()->SetColor(1.0f, 1.0f, 1.0f, 1.0f);
+
+	std::vector<IGraphics::CQuadItem> vQuads;
+	vQuads.reserve(MAX_CHUNK_QUADS);
+	float ChunkMin = 0.0f;
+	float ChunkMax = 0.0f;
+	auto &&FlushChunk = [&](int Part) {
+		if(vQuads.empty())
+			return;
+		CChunk Chunk;
+		Chunk.m_QuadContainer = Graphics()->CreateQuadContainer(false);
+		Chunk.m_Min = ChunkMin;
+		Chunk.m_Max = ChunkMax;
+		Graphics()->QuadContainerAddQuads(Chunk.m_QuadContainer, vQuads.data(), vQuads.size());
+		Graphics()->QuadContainerUpload(Chunk.m_QuadContainer);
+		Geometry.m_avChunks[Part].push_back(Chunk);
+		vQuads.clear();
+	};
+	// Pos is the position of the tile along the axis the part is culled on
+	auto &&AddTile = [&](int Part, int x, int y, float Pos) {
+		if(GetTile(x, y) != Type)
+			return;
+		IGraphics::CQuadItem aQuads[8];
+		const int NumQuads = GetTileQuads(Type, x, y, Width, aQuads);
+		if(NumQuads <= 0)
+			return;
+		if(vQuads.size() + NumQuads > (size_t)MAX_CHUNK_QUADS)
+			FlushChunk(Part);
+		if(vQuads.empty())
+			ChunkMin = Pos;
+		ChunkMax = Pos + TILE_SCALE;
+		for(int i = 0; i < NumQuads; i++)
+		{
+			// Tiles outside of the map only have edges along the border,
+			// store them with a size of 1 across to stretch them when rendering
+			IGraphics::CQuadItem &Quad = aQuads[i];
+			if(Part == PART_LEFT || Part == PART_RIGHT)
+			{
+				Quad.m_X = (Quad.m_X - x * TILE_SCALE) / TILE_SCALE;
+				Quad.m_Width /= TILE_SCALE;
+			}
+			else if(Part == PART_TOP || Part == PART_BOTTOM)
+			{
+				Quad.m_Y = (Quad.m_Y - y * TILE_SCALE) / TILE_SCALE;
+				Quad.m_Height /= TILE_SCALE;
+			}
+			vQuads.push_back(Quad);
+		}
+	};
+
+	// Rows first so the chunks cover as few rows as possible
+	for(int y = 0; y < m_MapDataSize.y; y++)
+		for(int x = 0; x < m_MapDataSize.x; x++)
+			AddTile(PART_MAP, x, y, y * TILE_SCALE);
+	FlushChunk(PART_MAP);
+	for(int y = 0; y < m_MapDataSize.y; y++)
+		AddTile(PART_LEFT, -1, y, y * TILE_SCALE);
+	FlushChunk(PART_LEFT);
+	for(int y = 0; y < m_MapDataSize.y; y++)
+		AddTile(PART_RIGHT, m_MapDataSize.x, y, y * TILE_SCALE);
+	FlushChunk(PART_RIGHT);
+	for(int x = 0; x < m_MapDataSize.x; x++)
+		AddTile(PART_TOP, x, -1, x * TILE_SCALE);
+	FlushChunk(PART_TOP);
+	for(int x = 0; x < m_MapDataSize.x; x++)
+		AddTile(PART_BOTTOM, x, m_MapDataSize.y, x * TILE_SCALE);
+	FlushChunk(PART_BOTTOM);
+}
+
 void COutlines::OnMapLoad()
 {
+	static_assert((int)NUM_OUTLINES <= (int)NUM_TYPES);
+	for(int Type = 0; Type < NUM_OUTLINES; Type++)
+		ClearGeometry(Type);
+
 	if(m_pMapData)
 	{
 		delete[] m_pMapData;
@@ -143,122 +307,61 @@ void COutlines::OnRender()
 	if(!g_Config.m_TcOutline)
 		return;
 
-	const float Scale = 32.0f;
-
 	float ScreenX0, ScreenY0, ScreenX1, ScreenY1;
 	Graphics()->GetScreen(&ScreenX0, &ScreenY0, &ScreenX1, &ScreenY1);
-	int StartY = (int)(ScreenY0 / Scale) - 1;
-	int StartX = (int)(ScreenX0 / Scale) - 1;
-	int EndY = (int)(ScreenY1 / Scale) + 1;
-	int EndX = (int)(ScreenX1 / Scale) + 1;
-	int MaxScale = 12;
-	if(EndX - StartX > Graphics()->ScreenWidth() / MaxScale || EndY - StartY > Graphics()->ScreenHeight() / MaxScale)
-	{
-		int EdgeX = (EndX - StartX) - (Graphics()->ScreenWidth() / MaxScale);
-		StartX += EdgeX / 2;
-		EndX -= EdgeX / 2;
-		int EdgeY = (EndY - StartY) - (Graphics()->ScreenHeight() / MaxScale);
-		StartY += EdgeY / 2;
-		EndY -= EdgeY / 2;
-	}
+	const float MapWidth = m_MapDataSize.x * TILE_SCALE;
+	const float MapHeight = m_MapDataSize.y * TILE_SCALE;
 
-	auto GetTile = [&](int x, int y) {
-		x = std::clamp(x, 0, m_MapDataSize.x - 1);
-		y = std::clamp(y, 0, m_MapDataSize.y - 1);
-		return m_pMapData[y * m_MapDataSize.x + x];
+	class COutlineConfig
+	{
+	public:
+		int m_Type;
+		const int &m_Enable;
+		const int &m_Width;
+		const unsigned int &m_Color;
+	};
+	const COutlineConfig aConfigs[] = {
+		{OUTLINE_UNFREEZE, g_Config.m_TcOutlineUnfreeze, g_Config.m_TcOutlineWidthUnfreeze, g_Config.m_TcOutlineColorUnfreeze},
+		{OUTLINE_FREEZE, g_Config.m_TcOutlineFreeze, g_Config.m_TcOutlineWidthFreeze, g_Config.m_TcOutlineColorFreeze},
+		{OUTLINE_TELE, g_Config.m_TcOutlineTele, g_Config.m_TcOutlineWidthTele, g_Config.m_TcOutlineColorTele},
+		{OUTLINE_KILL, g_Config.m_TcOutlineKill, g_Config.m_TcOutlineWidthKill, g_Config.m_TcOutlineColorKill},
+		{OUTLINE_SOLID, g_Config.m_TcOutlineSolid, g_Config.m_TcOutlineWidthSolid, g_Config.m_TcOutlineColorSolid},
 	};
 
-	Graphics()->TextureClear();
-	Graphics()->QuadsBegin();
-
-	for(int y = StartY; y < EndY; y++)
+	for(const COutlineConfig &Config : aConfigs)
 	{
-		for(int x = StartX; x < EndX; x++)
-		{
-			const int Type = GetTile(x, y);
-			if(Type == OUTLINE_NONE)
-				continue;
-			class COutlineConfig
-			{
-			public:
-				const int &m_Enable;
-				const int &m_Width;
-				const unsigned int &m_Color;
-			};
-			const COutlineConfig Config = [&]() -> COutlineConfig {
-				if(Type == OUTLINE_SOLID)
-					return {g_Config.m_TcOutlineSolid, g_Config.m_TcOutlineWidthSolid, g_Config.m_TcOutlineColorSolid};
-				if(Type == OUTLINE_FREEZE)
-					return {g_Config.m_TcOutlineFreeze, g_Config.m_TcOutlineWidthFreeze, g_Config.m_TcOutlineColorFreeze};
-				if(Type == OUTLINE_UNFREEZE)
-					return {g_Config.m_TcOutlineUnfreeze, g_Config.m_TcOutlineWidthUnfreeze, g_Config.m_TcOutlineColorUnfreeze};
-				if(Type == OUTLINE_KILL)
-					return {g_Config.m_TcOutlineKill, g_Config.m_TcOutlineWidthKill, g_Config.m_TcOutlineColorKill};
-				if(Type == OUTLINE_TELE)
-					return {g_Config.m_TcOutlineTele, g_Config.m_TcOutlineWidthTele, g_Config.m_TcOutlineColorTele};
-				dbg_assert(false, "Invalid value for Type at %d, %d/%d, %d", x, y, m_MapDataSize.x, m_MapDataSize.y);
-			}();
-			if(!Config.m_Enable || Config.m_Width <= 0)
-				continue;
-			// Find neighbours
-			const bool aNeighbors[8] = {
-				GetTile(x - 1, y - 1) >= Type,
-				GetTile(x - 0, y - 1) >= Type,
-				GetTile(x + 1, y - 1) >= Type,
-				GetTile(x - 1, y + 0) >= Type,
-				GetTile(x + 1, y + 0) >= Type,
-				GetTile(x - 1, y + 1) >= Type,
-				GetTile(x + 0, y + 1) >= Type,
-				GetTile(x + 1, y + 1) >= Type,
-			};
-			// Figure out edges
-			IGraphics::CQuadItem aQuads[8];
-			int NumQuads = 0;
-			// Lone corners first
-			if(!aNeighbors[0] && aNeighbors[1] && aNeighbors[3])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[2] && aNeighbors[1] && aNeighbors[4])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[5] && aNeighbors[3] && aNeighbors[6])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Config.m_Width, Config.m_Width, Config.m_Width);
-			if(!aNeighbors[7] && aNeighbors[6] && aNeighbors[4])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Scale - Config.m_Width, Config.m_Width, Config.m_Width);
-			// Top
-			if(!aNeighbors[1])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Scale, Config.m_Width);
-			// Bottom
-			if(!aNeighbors[6])
-				aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Scale - Config.m_Width, Scale, Config.m_Width);
-			// Left
-			if(!aNeighbors[3])
-			{
-				if(aNeighbors[1] && aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Scale);
-				else if(aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width);
-				else if(aNeighbors[1])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale, Config.m_Width, Scale - Config.m_Width);
-				else
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width * 2.0f);
-			}
-			// Right
-			if(!aNeighbors[4])
+		if(!Config.m_Enable || Config.m_Width <= 0)
+			continue;
+		CGeometry &Geometry = m_aGeometries[Config.m_Type];
+		if(Geometry.m_Width != Config.m_Width)
+			BuildGeometry(Config.m_Type, Config.m_Width);
+
+		Graphics()->TextureClear();
+		Graphics()->SetColor(color_cast<ColorRGBA>(ColorHSLA(Config.m_Color, true)));
+		auto &&RenderPart = [&](int Part, float Min, float Max, float X, float Y, float ScaleX, float ScaleY) {
+			for(const CChunk &Chunk : Geometry.m_avChunks[Part])
 			{
-				if(aNeighbors[1] && aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Scale);
-				else if(aNeighbors[6])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width);
-				else if(aNeighbors[1])
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale, Config.m_Width, Scale - Config.m_Width);
-				else
-					aQuads[NumQuads++] = IGraphics::CQuadItem(x * Scale + Scale - Config.m_Width, y * Scale + Config.m_Width, Config.m_Width, Scale - Config.m_Width * 2.0f);
+				if(Chunk.m_Max < Min || Chunk.m_Min > Max)
+					continue;
+				Graphics()->RenderQuadContainerEx(Chunk.m_QuadContainer, 0, -1, X, Y, ScaleX, ScaleY);
 			}
-			if(NumQuads <= 0)
-				continue;
-			Graphics()->SetColor(color_cast<ColorRGBA>(ColorHSLA(Config.m_Color, true)));
-			Graphics()->QuadsDrawTL(aQuads, NumQuads);
+		};
+		RenderPart(PART_MAP, ScreenY0, ScreenY1, 0.0f, 0.0f, 1.0f, 1.0f);
+		// Stretch the border parts over the visible area outside of the map
+		if(ScreenX0 < 0.0f)
+			RenderPart(PART_LEFT, ScreenY0, ScreenY1, ScreenX0, 0.0f, std::min(ScreenX1, 0.0f) - ScreenX0, 1.0f);
+		if(ScreenX1 > MapWidth)
+		{
+			const float X = std::max(ScreenX0, MapWidth);
+			RenderPart(PART_RIGHT, ScreenY0, ScreenY1, X, 0.0f, ScreenX1 - X, 1.0f);
+		}
+		if(ScreenY0 < 0.0f)
+			RenderPart(PART_TOP, ScreenX0, ScreenX1, 0.0f, ScreenY0, 1.0f, std::min(ScreenY1, 0.0f) - ScreenY0);
+		if(ScreenY1 > MapHeight)
+		{
+			const float Y = std::max(ScreenY0, MapHeight);
+			RenderPart(PART_BOTTOM, ScreenX0, ScreenX1, 0.0f, Y, 1.0f, ScreenY1 - Y);
 		}
 	}
-
-	Graphics()->QuadsEnd();
+	Graphics()->SetColor(1.0f, 1.0f, 1.0f, 1.0f);
 }
@@ -1,16 +1,59 @@
 #ifndef GAME_CLIENT_COMPONENTS_TCLIENT_OUTLINES_H
 #define GAME_CLIENT_COMPONENTS_TCLIENT_OUTLINES_H
 
+#include <engine/graphics.h>
+
 #include <game/client/component.h>
 
+#include <vector>
+
 class CTile;
 class CTeleTile;
 
 class COutlines : public CComponent
 {
 private:
+	enum
+	{
+		NUM_TYPES = 6,
+	};
+
+	// Parts of the geometry, tiles outside the map repeat the border tiles
+	enum
+	{
+		PART_MAP = 0,
+		PART_LEFT,
+		PART_RIGHT,
+		PART_TOP,
+		PART_BOTTOM,
+		NUM_PARTS,
+	};
+
+	class CChunk
+	{
+	public:
+		int m_QuadContainer;
+		// Range covered along the axis the part is culled on
+		float m_Min;
+		float m_Max;
+	};
+
+	class CGeometry
+	{
+	public:
+		// Outline width the geometry was built with, -1 if not built
+		int m_Width = -1;
+		std::vector<CChunk> m_avChunks[NUM_PARTS];
+	};
+
 	ivec2 m_MapDataSize;
 	int *m_pMapData = nullptr;
+	CGeometry m_aGeometries[NUM_TYPES];
+
+	int GetTile(int x, int y) const;
+	int GetTileQuads(int Type, int x, int y, float Width, IGraphics::CQuadItem *pQuads) const;
+	void BuildGeometry(int Type, int Width);
+	void ClearGeometry(int Type);
 
 public:
 	int Sizeof() const override { return sizeof(*this); }
@@ -27,6 +27,7 @@ void CTrails::ClearHistory(int ClientId)
 	for(int i = 0; i < 200; ++i)
 		m_History[ClientId][i] = {{}, -1};
 	m_HistoryValid[ClientId] = false;
+	m_avCache[ClientId].clear();
 }
 void CTrails::OnReset()
 {
@@ -46,6 +47,15 @@ void CTrails::OnRender()
 
 	Graphics()->TextureClear();
 
+	// all trails are drawn in one batch
+	const bool LineMode = g_Config.m_TcTeeTrailWidth == 0;
+	if(LineMode)
+		Graphics()->LinesBegin();
+	else
+		Graphics()->QuadsBegin();
+
+	const ColorRGBA SolidColor = color_cast<ColorRGBA>(ColorHSLA(g_Config.m_TcTeeTrailColor));
+
 	for(int ClientId = 0; ClientId < MAX_CLIENTS; ClientId++)
 	{
 		const bool Local = GameClient()->m_Snap.m_LocalClientId == ClientId;
@@ -105,7 +115,6 @@ void CTrails::OnRender()
 		// m_History[ClientId][(GameTick + 2) % 200] = m_History[ClientId][GameTick % 200];
 
 		IGraphics::CLineItem LineItem;
-		bool LineMode = g_Config.m_TcTeeTrailWidth == 0;
 
 		float Alpha = g_Config.m_TcTeeTrailAlpha / 100.0f;
 		// Taken from players.cpp
@@ -185,7 +194,7 @@ void CTrails::OnRender()
 			switch(g_Config.m_TcTeeTrailColorMode)
 			{
 			case COLORMODE_SOLID:
-				Part.m_Col = color_cast<ColorRGBA>(ColorHSLA(g_Config.m_TcTeeTrailColor));
+				Part.m_Col = SolidColor;
 				break;
 			case COLORMODE_TEE:
 				if(TeeInfo.m_CustomColoredSkin)
@@ -235,6 +244,9 @@ void CTrails::OnRender()
 			continue;
 
 		// Calculate the widths
+		std::vector<CCachedPart> &vCache = m_avCache[ClientId];
+		if(vCache.empty())
+			vCache.resize(200);
 		for(int i = 0; i < (int)s_Trail.size(); i++)
 		{
 			CTrailPart &Part = s_Trail.at(i);
@@ -258,58 +270,60 @@ void CTrails::OnRender()
 			else
 				NextPos = s_Trail.at(i + 1).m_Pos;
 
-			vec2 NextDirection = normalize(NextPos - Pos);
-			vec2 PrevDirection = normalize(Pos - PrevPos);
-
-			vec2 Normal = vec2(-PrevDirection.y, PrevDirection.x);
-			Part.m_Normal = Normal;
-			vec2 Tanget = normalize(NextDirection + PrevDirection);
-			if(Tanget == vec2(0.0f, 0.0f))
-				Tanget = Normal;
-
-			vec2 PerpVec = vec2(-Tanget.y, Tanget.x);
-			Width = Part.m_Width;
-			float ScaledWidth = Width / dot(Normal, PerpVec);
-			float TopScaled = ScaledWidth;
-			float BotScaled = ScaledWidth;
-			if(dot(PrevDirection, Tanget) > 0.0f)
-				TopScaled = std::min(Width * 3.0f, TopScaled);
-			else
-				BotScaled = std::min(Width * 3.0f, BotScaled);
-
-			vec2 Top = Pos + PerpVec * TopScaled;
-			vec2 Bot = Pos - PerpVec * BotScaled;
-			Part.m_Top = Top;
-			Part.m_Bot = Bot;
-
-			// Bevel Cap
-			if(dot(PrevDirection, NextDirection) < -0.25f)
+			// only the ends move between ticks
+			CCachedPart &Cached = vCache[Part.m_Tick % 200];
+			if(Cached.m_Tick != Part.m_Tick || Cached.m_Pos != Pos || Cached.m_PrevPos != PrevPos || Cached.m_NextPos != NextPos)
 			{
-				Top = Pos + Tanget * Width;
-				Bot = Pos - Tanget * Width;
+				Cached.m_Tick = Part.m_Tick;
+				Cached.m_Pos = Pos;
+				Cached.m_PrevPos = PrevPos;
+				Cached.m_NextPos = NextPos;
+
+				vec2 NextDirection = normalize(NextPos - Pos);
+				vec2 PrevDirection = normalize(Pos - PrevPos);
+
+				vec2 Normal = vec2(-PrevDirection.y, PrevDirection.x);
+				Cached.m_Normal = Normal;
+				vec2 Tanget = normalize(NextDirection + PrevDirection);
+				if(Tanget == vec2(0.0f, 0.0f))
+					Tanget = Normal;
+
+				vec2 PerpVec = vec2(-Tanget.y, Tanget.x);
+				float ScaledWidth = 1.0f / dot(Normal, PerpVec);
+				float TopScaled = ScaledWidth;
+				float BotScaled = ScaledWidth;
+				if(dot(PrevDirection, Tanget) > 0.0f)
+					TopScaled = std::min(3.0f, TopScaled);
+				else
+					BotScaled = std::min(3.0f, BotScaled);
 
-				float Det = PrevDirection.x * NextDirection.y - PrevDirection.y * NextDirection.x;
-				if(Det >= 0.0f)
-				{
-					Part.m_Top = Top;
-					Part.m_Bot = Bot;
-					if(i > 0)
-						s_Trail.at(i).m_Flip = true;
-				}
-				else // <-Left Direction
+				Cached.m_TopDir = PerpVec * TopScaled;
+				Cached.m_BotDir = -PerpVec * BotScaled;
+
+				// Bevel Cap
+				Cached.m_Bevel = dot(PrevDirection, NextDirection) < -0.25f;
+				if(Cached.m_Bevel)
 				{
-					Part.m_Top = Bot;
-					Part.m_Bot = Top;
-					if(i > 0)
-						s_Trail.at(i).m_Flip = true;
+					float Det = PrevDirection.x * NextDirection.y - PrevDirection.y * NextDirection.x;
+					if(Det >= 0.0f)
+					{
+						Cached.m_TopDir = Tanget;
+						Cached.m_BotDir = -Tanget;
+					}
+					else // <-Left Direction
+					{
+						Cached.m_TopDir = -Tanget;
+						Cached.m_BotDir = Tanget;
+					}
 				}
 			}
-		}
 
-		if(LineMode)
-			Graphics()->LinesBegin();
-		else
-			Graphics()->QuadsBegin();
+			Part.m_Normal = Cached.m_Normal;
+			Part.m_Top = Pos + Cached.m_TopDir * Part.m_Width;
+			Part.m_Bot = Pos + Cached.m_BotDir * Part.m_Width;
+			if(Cached.m_Bevel && i > 0)
+				Part.m_Flip = true;
+		}
 
 		// Draw the trail
 		for(int i = 0; i < (int)s_Trail.size() - 1; i++)
@@ -346,9 +360,10 @@ void CTrails::OnRender()
 				Graphics()->QuadsDrawFreeform(&FreeformItem, 1);
 			}
 		}
-		if(LineMode)
-			Graphics()->LinesEnd();
-		else
-			Graphics()->QuadsEnd();
 	}
+
+	if(LineMode)
+		Graphics()->LinesEnd();
+	else
+		Graphics()->QuadsEnd();
 }
@@ -7,6 +7,8 @@
 
 #include <game/client/component.h>
 
+#include <vector>
+
 class CTrailPart
 {
 public:
@@ -53,6 +55,23 @@ private:
 	CInfo m_History[MAX_CLIENTS][200];
 	bool m_HistoryValid[MAX_CLIENTS] = {};
 
+	// The outline of a trail point only depends on its neighbours, so it
+	// is kept until one of them changes. Indexed by tick like the history.
+	class CCachedPart
+	{
+	public:
+		int m_Tick = -1;
+		vec2 m_Pos;
+		vec2 m_PrevPos;
+		vec2 m_NextPos;
+		vec2 m_Normal;
+		// the outline for a width of 1
+		vec2 m_TopDir;
+		vec2 m_BotDir;
+		bool m_Bevel;
+	};
+	std::vector<CCachedPart> m_avCache[MAX_CLIENTS];
+
 	void ClearAllHistory();
 	void ClearHistory(int ClientId);
 	bool ShouldPredictPlayer(int ClientId);
@@ -215,6 +215,7 @@ void CWarList::UpdateWarEntry(int Index, const char *pName, const char *pClan, c
 		str_copy(m_vWarEntries[Index].m_aClan, pClan);
 		str_copy(m_vWarEntries[Index].m_aReason, pReason);
 		m_vWarEntries[Index].m_pWarType = pType;
+		OnWarListChanged();
 	}
 }
 
@@ -227,6 +228,7 @@ void CWarList::UpsertWarType(int Index, const char *pType, ColorRGBA Color)
 	{
 		str_copy(m_WarTypes[Index]->m_aWarName, pType);
 		m_WarTypes[Index]->m_Color = Color;
+		OnWarListChanged();
 	}
 	else
 	{
@@ -257,6 +259,7 @@ void CWarList::AddWarEntry(const char *pName, const char *pClan, const char *pRe
 	if(!g_Config.m_TcWarListAllowDuplicates)
 		RemoveWarEntryDuplicates(pName, pClan);
 	m_vWarEntries.push_back(Entry);
+	OnWarListChanged();
 }
 
 void CWarList::RemoveWarEntryDuplicates(const char *pName, const char *pClan)
@@ -275,6 +278,7 @@ void CWarList::RemoveWarEntryDuplicates(const char *pName, const char *pClan)
 		else
 			++it;
 	}
+	OnWarListChanged();
 }
 
 void CWarList::AddWarType(const char *pType, ColorRGBA Color)
@@ -292,6 +296,7 @@ void CWarList::AddWarType(const char *pType, ColorRGBA Color)
 	{
 		Type->m_Color = Color;
 	}
+	OnWarListChanged();
 }
 
 void CWarList::RemoveWarEntry(const char *pName, const char *pClan, const char *pType)
@@ -301,6 +306,7 @@ void CWarList::RemoveWarEntry(const char *pName, const char *pClan, const char *
 	auto it = std::find(m_vWarEntries.begin(), m_vWarEntries.end(), Entry);
 	if(it != m_vWarEntries.end())
 		m_vWarEntries.erase(it);
+	OnWarListChanged();
 }
 
 void CWarList::RemoveWarEntry(CWarEntry *Entry)
@@ -309,6 +315,7 @@ void CWarList::RemoveWarEntry(CWarEntry *Entry)
 		[Entry](const CWarEntry &WarEntry) { return &WarEntry == Entry; });
 	if(it != m_vWarEntries.end())
 		m_vWarEntries.erase(it);
+	OnWarListChanged();
 }
 
 void CWarList::RemoveWarType(const char *pType)
@@ -332,6 +339,7 @@ void CWarList::RemoveWarType(const char *pType)
 			}
 		}
 		m_WarTypes.erase(it);
+		OnWarListChanged();
 	}
 }
 
@@ -411,44 +419,109 @@ void CWarList::SortWarEntries()
 	// TODO
 }
 
+void CWarList::RebuildIndex()
+{
+	m_NameIndex.clear();
+	m_ClanIndex.clear();
+	for(int i = 0; i < (int)m_vWarEntries.size(); ++i)
+	{
+		const CWarEntry &Entry = m_vWarEntries[i];
+		if(Entry.m_aName[0] != '\0')
+			m_NameIndex[Entry.m_aName].push_back(i);
+		if(Entry.m_aClan[0] != '\0')
+			m_ClanIndex[Entry.m_aClan].push_back(i);
+	}
+	m_IndexGeneration = m_Generation;
+}
+
+void CWarList::UpdateWarPlayer(int ClientId)
+{
+	const CGameClient::CClientData &Client = GameClient()->m_aClients[ClientId];
+	CWarDataCache &WarPlayer = m_WarPlayers[ClientId];
+	str_copy(WarPlayer.m_aName, Client.m_aName);
+	str_copy(WarPlayer.m_aClan, Client.m_aClan);
+	WarPlayer.m_Generation = m_Generation;
+
+	WarPlayer.m_WarName = false;
+	WarPlayer.m_WarClan = false;
+	memset(WarPlayer.m_aReason, 0, sizeof(WarPlayer.m_aReason));
+	WarPlayer.m_NameColor = ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f);
+	WarPlayer.m_ClanColor = ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f);
+	WarPlayer.m_WarGroupMatches.clear();
+	WarPlayer.m_WarGroupMatches.resize((int)m_WarTypes.size(), false);
+
+	static const std::vector<int> s_vNoEntries;
+	const std::vector<int> *pvNameEntries = &s_vNoEntries;
+	const std::vector<int> *pvClanEntries = &s_vNoEntries;
+	if(Client.m_aName[0] != '\0')
+	{
+		auto It = m_NameIndex.find(Client.m_aName);
+		if(It != m_NameIndex.end())
+			pvNameEntries = &It->second;
+	}
+	if(Client.m_aClan[0] != '\0')
+	{
+		auto It = m_ClanIndex.find(Client.m_aClan);
+		if(It != m_ClanIndex.end())
+			pvClanEntries = &It->second;
+	}
+
+	// go through the matching entries in list order, later entries override earlier ones
+	size_t NameIndex = 0;
+	size_t ClanIndex = 0;
+	while(NameIndex < pvNameEntries->size() || ClanIndex < pvClanEntries->size())
+	{
+		int Index;
+		if(ClanIndex >= pvClanEntries->size() || (NameIndex < pvNameEntries->size() && (*pvNameEntries)[NameIndex] <= (*pvClanEntries)[ClanIndex]))
+			Index = (*pvNameEntries)[NameIndex];
+		else
+			Index = (*pvClanEntries)[ClanIndex];
+		// an entry with both a name and a clan is in both lists
+		if(NameIndex < pvNameEntries->size() && (*pvNameEntries)[NameIndex] == Index)
+			NameIndex++;
+		if(ClanIndex < pvClanEntries->size() && (*pvClanEntries)[ClanIndex] == Index)
+			ClanIndex++;
+
+		const CWarEntry &Entry = m_vWarEntries[Index];
+		if(str_comp(Client.m_aName, Entry.m_aName) == 0 && str_comp(Entry.m_aName, "") != 0)
+		{
+			str_copy(WarPlayer.m_aReason, Entry.m_aReason);
+			WarPlayer.m_WarName = true;
+			WarPlayer.m_NameColor = Entry.m_pWarType->m_Color;
+			WarPlayer.m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
+		}
+		else
+		{
+			// Name war reason has priority over clan war reason
+			if(!WarPlayer.m_WarName)
+				str_copy(WarPlayer.m_aReason, Entry.m_aReason);
+
+			WarPlayer.m_WarClan = true;
+			WarPlayer.m_ClanColor = Entry.m_pWarType->m_Color;
+			WarPlayer.m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
+		}
+	}
+}
+
 void CWarList::UpdateWarPlayers()
 {
 	for(int i = 0; i < (int)m_WarTypes.size(); ++i)
 		m_WarTypes[i]->m_Index = i;
 
+	if(m_IndexGeneration != m_Generation)
+		RebuildIndex();
+
 	for(int i = 0; i < MAX_CLIENTS; ++i)
 	{
 		if(!GameClient()->m_aClients[i].m_Active)
 			continue;
 
-		m_WarPlayers[i].m_WarName = false;
-		m_WarPlayers[i].m_WarClan = false;
-		memset(m_WarPlayers[i].m_aReason, 0, sizeof(m_WarPlayers[i].m_aReason));
-		m_WarPlayers[i].m_NameColor = ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f);
-		m_WarPlayers[i].m_ClanColor = ColorRGBA(1.0f, 1.0f, 1.0f, 1.0f);
-		m_WarPlayers[i].m_WarGroupMatches.clear();
-		m_WarPlayers[i].m_WarGroupMatches.resize((int)m_WarTypes.size(), false);
-
-		for(CWarEntry &Entry : m_vWarEntries)
-		{
-			if(str_comp(GameClient()->m_aClients[i].m_aName, Entry.m_aName) == 0 && str_comp(Entry.m_aName, "") != 0)
-			{
-				str_copy(m_WarPlayers[i].m_aReason, Entry.m_aReason);
-				m_WarPlayers[i].m_WarName = true;
-				m_WarPlayers[i].m_NameColor = Entry.m_pWarType->m_Color;
-				m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
-			}
-			else if(str_comp(GameClient()->m_aClients[i].m_aClan, Entry.m_aClan) == 0 && str_comp(Entry.m_aClan, "") != 0)
-			{
-				// Name war reason has priority over clan war reason
-				if(!m_WarPlayers[i].m_WarName)
-					str_copy(m_WarPlayers[i].m_aReason, Entry.m_aReason);
+		// only match again if the list or the player changed since the last snapshot
+		const CWarDataCache &WarPlayer = m_WarPlayers[i];
+		if(WarPlayer.m_Generation == m_Generation && str_comp(WarPlayer.m_aName, GameClient()->m_aClients[i].m_aName) == 0 && str_comp(WarPlayer.m_aClan, GameClient()->m_aClients[i].m_aClan) == 0)
+			continue;
 
-				m_WarPlayers[i].m_WarClan = true;
-				m_WarPlayers[i].m_ClanColor = Entry.m_pWarType->m_Color;
-				m_WarPlayers[i].m_WarGroupMatches[Entry.m_pWarType->m_Index] = true;
-			}
-		}
+		UpdateWarPlayer(i);
 	}
 }
 
@@ -8,6 +8,10 @@
 
 #include <game/client/component.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 enum
 {
 	MAX_WARLIST_TYPE_LENGTH = 16,
@@ -84,6 +88,11 @@ public:
 	std::vector<char> m_WarGroupMatches = {false, false, false};
 
 	char m_aReason[MAX_WARLIST_REASON_LENGTH] = "";
+
+	// what the data was computed for, only updated if one of them changes
+	char m_aName[MAX_NAME_LENGTH] = "";
+	char m_aClan[MAX_CLAN_LENGTH] = "";
+	int m_Generation = -1;
 };
 
 class CWarList : public CComponent
@@ -135,6 +144,16 @@ class CWarList : public CComponent
 
 	static void ConfigSaveCallback(IConfigManager *pConfigManager, void *pUserData);
 
+	// Incremented whenever war entries or types change
+	int m_Generation = 0;
+	// Indices into m_vWarEntries by exact name and clan, in ascending order
+	int m_IndexGeneration = -1;
+	std::unordered_map<std::string, std::vector<int>> m_NameIndex;
+	std::unordered_map<std::string, std::vector<int>> m_ClanIndex;
+
+	void RebuildIndex();
+	void UpdateWarPlayer(int ClientId);
+
 public:
 	CWarList();
 	~CWarList();
@@ -150,9 +169,8 @@ public:
 	CWarType *m_pWarTypeNone = m_WarTypes[0];
 
 	// Duplicate war entries ARE allowed
+	// Call OnWarListChanged after modifying entries or war types directly
 	std::vector<CWarEntry> m_vWarEntries;
-	// TODO: create an unordered map for war clans and war names, to speed up updating the WarPlayers cache
-	// It should be updated when m_WarList changes
 
 	CWarDataCache m_WarPlayers[MAX_CLIENTS];
 
@@ -161,6 +179,7 @@ public:
 	void OnConsoleInit() override;
 
 	void UpdateWarPlayers();
+	void OnWarListChanged() { m_Generation++; }
 
 	void UpdateWarEntry(int Index, const char *pName, const char *pClan, const char *pReason, CWarType *pType);
 
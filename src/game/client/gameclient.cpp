@@ -204,6 +204,7 @@ void CGameClient::OnConsoleInit()
 	Console()->Register("team", "i[team-id]", CFGFLAG_CLIENT, ConTeam, this, "Switch team");
 	Console()->Register("kill", "", CFGFLAG_CLIENT, ConKill, this, "Kill yourself to restart");
 	Console()->Register("ready_change", "", CFGFLAG_CLIENT, ConReadyChange7, this, "Change ready state (0.7 only)");
+	Console()->Register("benchmark_world_copy", "?i[seconds]", CFGFLAG_CLIENT, ConBenchmarkWorldCopy, this, "Benchmark copying the prediction world filled up to 64 players");
 
 	// register game commands to allow the client prediction to load settings from the map
 	Console()->Register("tune", "s[tuning] ?f[value]", CFGFLAG_GAME, ConTuneParam, this, "Tune variable to value");
@@ -701,6 +702,9 @@ void CGameClient::OnReset()
 	m_GameWorld.m_WorldConfig.m_InfiniteAmmo = true;
 	m_PredictedWorld.CopyWorld(&m_GameWorld);
 	m_PrevPredictedWorld.CopyWorld(&m_PredictedWorld);
+	InvalidatePredictionCache();
+	m_PredictionCacheHits = 0;
+	m_PredictionCacheMisses = 0;
 
 	m_vSnapEntities.clear();
 
@@ -1153,6 +1157,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 			if(CCharacter *pChar = m_GameWorld.GetCharacterById(pMsg->m_Victim))
 				pChar->ResetPrediction();
 			m_GameWorld.ReleaseHooked(pMsg->m_Victim);
+			InvalidatePredictionCache();
 		}
 
 		// if we are spectating a static id set (team 0) and somebody killed, and its not a guy in solo, we remove him from the list
@@ -1185,6 +1190,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 		CNetMsg_Sv_KillMsgTeam *pMsg = (CNetMsg_Sv_KillMsgTeam *)pRawMsg;
 
 		// reset prediction
+		InvalidatePredictionCache();
 		std::vector<std::pair<int, int>> vStrongWeakSorted;
 		for(int i = 0; i < MAX_CLIENTS; i++)
 		{
@@ -1224,6 +1230,7 @@ void CGameClient::OnMessage(int MsgId, CUnpacker *pUnpacker, int Conn, bool Dumm
 	{
 		CNetMsg_Sv_PreInput *pMsg = (CNetMsg_Sv_PreInput *)pRawMsg;
 		m_aClients[pMsg->m_Owner].m_aPreInputs[pMsg->m_IntendedTick % 200] = *pMsg;
+		InvalidatePredictionCache(pMsg->m_IntendedTick);
 	}
 	else if(MsgId == NETMSGTYPE_SV_SAVECODE)
 	{
@@ -1633,6 +1640,8 @@ void CGameClient::InvalidateSnapshot()
 
 void CGameClient::OnNewSnapshot()
 {
+	InvalidatePredictionCache();
+
 	auto &&Evolve = [this](CNetObj_Character *pCharacter, int Tick) {
 		CWorldCore TempWorld;
 		CCharacterCore TempCore = CCharacterCore();
@@ -2413,30 +2422,57 @@ void CGameClient::OnPredict()
 
 	// init
 	bool Dummy = g_Config.m_ClDummy ^ m_IsDummySwapping;
-	m_PredictedWorld.CopyWorld(&m_GameWorld);
 
 	// don't predict inactive players, or entities from other teams
+	CPredictionCacheKey CacheKey;
+	CacheKey.m_GameTick = Client()->GameTick(g_Config.m_ClDummy);
+	CacheKey.m_LocalClientId = m_Snap.m_LocalClientId;
+	CacheKey.m_Dummy = Dummy;
+	CacheKey.m_IsDummySwapping = m_IsDummySwapping;
+	CacheKey.m_PreInput = g_Config.m_ClAntiPingPreInput;
 	for(int i = 0; i < MAX_CLIENTS; i++)
-		if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
-			if((!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || IsOtherTeam(i))
-				pChar->Destroy();
+	{
+		CacheKey.m_OtherTeam[i] = IsOtherTeam(i);
+		if(CCharacter *pChar = m_GameWorld.GetCharacterById(i))
+			CacheKey.m_RemovedCharacters[i] = (!m_Snap.m_aCharacters[i].m_Active && pChar->m_SnapTicks > 10) || CacheKey.m_OtherTeam[i];
+	}
+	if(PredictDummy() && m_GameWorld.GetCharacterById(m_PredictedDummyId) && !CacheKey.m_RemovedCharacters[m_PredictedDummyId])
+		CacheKey.m_DummyId = m_PredictedDummyId;
 
-	CProjectile *pProjNext = nullptr;
-	for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
+	// TClient
+	// continue from the last state that is still valid instead of predicting all ticks again
+	int FirstTick = RestorePredictionCache(CacheKey) + 1;
+	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterById(m_Snap.m_LocalClientId);
+	if(FirstTick > 0 && pLocalChar)
+		m_PredictionCacheHits++;
+	else
 	{
-		pProjNext = (CProjectile *)pProj->TypeNext();
-		if(IsOtherTeam(pProj->GetOwner()))
+		m_PredictionCacheMisses++;
+		FirstTick = CacheKey.m_GameTick + 1;
+		m_PredictedWorld.CopyWorld(&m_GameWorld);
+
+		for(int i = 0; i < MAX_CLIENTS; i++)
+			if(CCharacter *pChar = m_PredictedWorld.GetCharacterById(i))
+				if(CacheKey.m_RemovedCharacters[i])
+					pChar->Destroy();
+
+		CProjectile *pProjNext = nullptr;
+		for(CProjectile *pProj = (CProjectile *)m_PredictedWorld.FindFirst(CGameWorld::ENTTYPE_PROJECTILE); pProj; pProj = pProjNext)
 		{
-			pProj->Destroy();
+			pProjNext = (CProjectile *)pProj->TypeNext();
+			if(IsOtherTeam(pProj->GetOwner()))
+			{
+				pProj->Destroy();
+			}
 		}
-	}
 
-	CCharacter *pLocalChar = m_PredictedWorld.GetCharacterById(m_Snap.m_LocalClientId);
-	if(!pLocalChar)
-		return;
+		pLocalChar = m_PredictedWorld.GetCharacterById(m_Snap.m_LocalClientId);
+		if(!pLocalChar)
+			return;
+	}
 	CCharacter *pDummyChar = nullptr;
-	if(PredictDummy())
-		pDummyChar = m_PredictedWorld.GetCharacterById(m_PredictedDummyId);
+	if(CacheKey.m_DummyId >= 0)
+		pDummyChar = m_PredictedWorld.GetCharacterById(CacheKey.m_DummyId);
 
 	bool RealPredTick = false;
 	// predict
@@ -2448,8 +2484,11 @@ void CGameClient::OnPredict()
 	if(g_Config.m_TcFastInput && !g_Config.m_TcFastInputOthers)
 		FinalTickOthers = FinalTickSelf - g_Config.m_TcFastInput;
 
-	for(int Tick = Client()->GameTick(g_Config.m_ClDummy) + 1; Tick <= FinalTickSelf; Tick++)
+	m_PredictedTicksSimulated = 0;
+	for(int Tick = FirstTick; Tick <= FinalTickSelf; Tick++)
 	{
+		m_PredictedTicksSimulated++;
+
 		// fetch the previous characters
 		if(Tick == FinalTickSelf)
 		{
@@ -2560,6 +2599,11 @@ void CGameClient::OnPredict()
 
 		m_PredictedWorld.Tick();
 
+		// TClient
+		// copying the world is expensive, only the last state that can be reused is stored
+		if(Tick <= FinalTickRegular - PREDICTION_CACHE_MARGIN)
+			SavePredictionCache(Tick, pInputData, pDummyInputData, Tick == FinalTickRegular - PREDICTION_CACHE_MARGIN);
+
 		// fetch the current characters
 		if(Tick == FinalTickSelf)
 		{
@@ -2967,6 +3011,67 @@ void CGameClient::OnPredict()
 		m_Ghost.OnNewPredictedSnapshot();
 }
 
+void CGameClient::InvalidatePredictionCache(int FromTick)
+{
+	for(CPredictionCacheState &State : m_aPredictionCacheStates)
+	{
+		if(State.m_Tick >= FromTick)
+			State.m_Tick = -1;
+	}
+}
+
+int CGameClient::RestorePredictionCache(const CPredictionCacheKey &Key)
+{
+	if(!(Key == m_PredictionCacheKey))
+	{
+		InvalidatePredictionCache();
+		m_PredictionCacheKey = Key;
+		return -1;
+	}
+
+	// find the last stored state for which the inputs of all ticks up to it are unchanged
+	const auto &&SameInput = [](bool HasInput, const CNetObj_PlayerInput &Input, const int *pInput) {
+		if(!pInput)
+			return !HasInput;
+		return HasInput && mem_comp(&Input, pInput, sizeof(Input)) == 0;
+	};
+	int RestoreTick = -1;
+	const int LastTick = Client()->PredGameTick(g_Config.m_ClDummy) - PREDICTION_CACHE_MARGIN;
+	for(int Tick = Key.m_GameTick + 1; Tick <= LastTick; Tick++)
+	{
+		const CPredictionCacheInputs &Inputs = m_aPredictionCacheInputs[Tick % 200];
+		if(Inputs.m_Tick != Tick ||
+			!SameInput(Inputs.m_aHasInput[0], Inputs.m_aInputs[0], Client()->GetInput(Tick, m_IsDummySwapping)) ||
+			!SameInput(Inputs.m_aHasInput[1], Inputs.m_aInputs[1], Key.m_DummyId < 0 ? nullptr : Client()->GetInput(Tick, m_IsDummySwapping ^ 1)))
+			break;
+		if(m_aPredictionCacheStates[Tick % PREDICTION_CACHE_SIZE].m_Tick == Tick)
+			RestoreTick = Tick;
+	}
+
+	// the later states were built on inputs that changed
+	InvalidatePredictionCache(RestoreTick + 1);
+	if(RestoreTick < 0)
+		return -1;
+	m_PredictedWorld.RestoreWorld(&m_aPredictionCacheStates[RestoreTick % PREDICTION_CACHE_SIZE].m_World);
+	return RestoreTick;
+}
+
+void CGameClient::SavePredictionCache(int Tick, const CNetObj_PlayerInput *pInput, const CNetObj_PlayerInput *pDummyInput, bool SaveState)
+{
+	CPredictionCacheInputs &Inputs = m_aPredictionCacheInputs[Tick % 200];
+	Inputs.m_Tick = Tick;
+	Inputs.m_aHasInput[0] = pInput != nullptr;
+	Inputs.m_aHasInput[1] = pDummyInput != nullptr;
+	Inputs.m_aInputs[0] = pInput ? *pInput : CNetObj_PlayerInput{};
+	Inputs.m_aInputs[1] = pDummyInput ? *pDummyInput : CNetObj_PlayerInput{};
+
+	if(!SaveState)
+		return;
+	CPredictionCacheState &State = m_aPredictionCacheStates[Tick % PREDICTION_CACHE_SIZE];
+	State.m_World.SaveWorld(&m_PredictedWorld);
+	State.m_Tick = Tick;
+}
+
 void CGameClient::OnActivateEditor()
 {
 	OnRelease();
@@ -3427,6 +3532,51 @@ void CGameClient::ConReadyChange7(IConsole::IResult *pResult, void *pUserData)
 		pClient->SendReadyChange7();
 }
 
+void CGameClient::ConBenchmarkWorldCopy(IConsole::IResult *pResult, void *pUserData)
+{
+	CGameClient *pSelf = static_cast<CGameClient *>(pUserData);
+	if(pSelf->Client()->State() != IClient::STATE_ONLINE && pSelf->Client()->State() != IClient::STATE_DEMOPLAYBACK)
+	{
+		log_error("benchmark", "the world can only be copied while a map is loaded");
+		return;
+	}
+	const int Seconds = pResult->NumArguments() ? std::clamp(pResult->GetInteger(0), 1, 60) : 1;
+
+	// the current world, with a character at the local position for every missing player
+	CGameWorld World;
+	World.SaveWorld(&pSelf->m_GameWorld);
+	CNetObj_Character CharObj = {};
+	if(pSelf->m_Snap.m_pLocalCharacter)
+	{
+		CharObj.m_X = pSelf->m_Snap.m_pLocalCharacter->m_X;
+		CharObj.m_Y = pSelf->m_Snap.m_pLocalCharacter->m_Y;
+	}
+	for(int i = 0; i < SERVER_MAX_CLIENTS; i++)
+	{
+		if(!World.GetCharacterById(i))
+			World.InsertEntity(new CCharacter(&World, i, &CharObj));
+	}
+	int NumEntities = 0;
+	for(int Type = 0; Type < CGameWorld::NUM_ENTTYPES; Type++)
+	{
+		for(CEntity *pEnt = World.FindFirst(Type); pEnt; pEnt = pEnt->TypeNext())
+			NumEntities++;
+	}
+
+	CGameWorld Copy;
+	int Copies = 0;
+	const int64_t Start = time_get();
+	const int64_t End = Start + Seconds * time_freq();
+	int64_t Now;
+	do
+	{
+		Copy.CopyWorld(&World);
+		Copies++;
+		Now = time_get();
+	} while(Now < End);
+	log_info("benchmark", "%.0f copies/s of a world with %d entities", Copies * (double)time_freq() / (Now - Start), NumEntities);
+}
+
 void CGameClient::ConchainLanguageUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData)
 {
 	CGameClient *pThis = static_cast<CGameClient *>(pUserData);
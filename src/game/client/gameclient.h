@@ -85,6 +85,7 @@
 #include "components/touch_controls.h"
 #include "components/voting.h"
 
+#include <bitset>
 #include <vector>
 
 class CGameInfo
@@ -279,6 +280,7 @@ private:
 	static void ConTeam(IConsole::IResult *pResult, void *pUserData);
 	static void ConKill(IConsole::IResult *pResult, void *pUserData);
 	static void ConReadyChange7(IConsole::IResult *pResult, void *pUserData);
+	static void ConBenchmarkWorldCopy(IConsole::IResult *pResult, void *pUserData);
 
 	static void ConchainLanguageUpdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
 	static void ConchainSpecialInfoupdate(IConsole::IResult *pResult, void *pUserData, IConsole::FCommandCallback pfnCallback, void *pCallbackUserData);
@@ -347,6 +349,9 @@ public:
 	bool m_SuppressEvents;
 	bool m_NewTick;
 	bool m_NewPredictedTick;
+	int m_PredictedTicksSimulated = 0;
+	int m_PredictionCacheHits = 0;
+	int m_PredictionCacheMisses = 0;
 	int m_aFlagDropTick[2];
 
 	enum
@@ -943,6 +948,50 @@ private:
 	int m_aLastUpdateTick[MAX_CLIENTS] = {0};
 	void DetectStrongHook();
 
+	// TClient
+	// states of the predicted world after already predicted ticks, so OnPredict only has to simulate
+	// the ticks after the last state whose inputs did not change. They are only valid until m_GameWorld changes.
+	enum
+	{
+		// one state is stored per predicted tick, a few are kept for preinputs that invalidate the latest ones
+		PREDICTION_CACHE_SIZE = 4,
+		// the last ticks depend on the predicted tick and fast input, they are always simulated again
+		PREDICTION_CACHE_MARGIN = 3,
+	};
+	struct CPredictionCacheKey
+	{
+		int m_GameTick = -1;
+		int m_LocalClientId = -1;
+		int m_DummyId = -1;
+		bool m_Dummy = false;
+		int m_IsDummySwapping = 0;
+		bool m_PreInput = false;
+		std::bitset<MAX_CLIENTS> m_OtherTeam;
+		std::bitset<MAX_CLIENTS> m_RemovedCharacters;
+
+		bool operator==(const CPredictionCacheKey &Other) const = default;
+	};
+	struct CPredictionCacheInputs
+	{
+		int m_Tick = -1;
+		bool m_aHasInput[NUM_DUMMIES];
+		CNetObj_PlayerInput m_aInputs[NUM_DUMMIES];
+	};
+	struct CPredictionCacheState
+	{
+		int m_Tick = -1;
+		CGameWorld m_World;
+	};
+	CPredictionCacheKey m_PredictionCacheKey;
+	CPredictionCacheState m_aPredictionCacheStates[PREDICTION_CACHE_SIZE];
+	CPredictionCacheInputs m_aPredictionCacheInputs[200];
+	// forgets the states after FromTick-1, all of them by default
+	void InvalidatePredictionCache(int FromTick = 0);
+	// restores m_PredictedWorld to the last valid state and returns its tick, or -1 if there is none
+	int RestorePredictionCache(const CPredictionCacheKey &Key);
+	// the inputs are stored for every tick, the state only when SaveState is set
+	void SavePredictionCache(int Tick, const CNetObj_PlayerInput *pInput, const CNetObj_PlayerInput *pDummyInput, bool SaveState);
+
 	int m_PredictedDummyId;
 	int m_IsDummySwapping;
 	CCharOrder m_CharOrder;
@@ -142,7 +142,7 @@ void CPickup::Move()
 		{
 			m_IsCoreActive = true;
 		}
-		m_Pos += m_Core;
+		GameWorld()->MoveEntity(this, m_Pos + m_Core);
 	}
 }
 
@@ -5,6 +5,98 @@
 
 #include <game/collision.h>
 
+#include <cstddef>
+#include <vector>
+
+// Each prediction copies the whole world, so deleted entities are kept in a free list per entity size
+// for the next copy instead of going through the heap. The memory is allocated in chunks, which keeps
+// the entities of a world close together, and is never returned to the heap.
+class CEntityPool
+{
+public:
+	void *Allocate(size_t Size)
+	{
+		CSizePool &Pool = FindPool(Size);
+		if(!Pool.m_pFirstFree)
+			AllocateChunk(Pool);
+		CFreeEntity *pEntity = Pool.m_pFirstFree;
+		ASAN_UNPOISON_MEMORY_REGION(pEntity, Size);
+		Pool.m_pFirstFree = pEntity->m_pNext;
+		return pEntity;
+	}
+
+	void Free(void *pPtr, size_t Size)
+	{
+		AddFree(FindPool(Size), pPtr);
+	}
+
+private:
+	enum
+	{
+		CHUNK_ENTITIES = 64,
+	};
+
+	struct CFreeEntity
+	{
+		CFreeEntity *m_pNext;
+	};
+
+	struct CSizePool
+	{
+		size_t m_Size;
+		CFreeEntity *m_pFirstFree;
+	};
+
+	// one per entity class, few enough for a linear search
+	std::vector<CSizePool> m_vPools;
+
+	CSizePool &FindPool(size_t Size)
+	{
+		for(CSizePool &Pool : m_vPools)
+		{
+			if(Pool.m_Size == Size)
+				return Pool;
+		}
+		m_vPools.push_back({Size, nullptr});
+		return m_vPools.back();
+	}
+
+	static void AddFree(CSizePool &Pool, void *pPtr)
+	{
+		CFreeEntity *pEntity = static_cast<CFreeEntity *>(pPtr);
+		pEntity->m_pNext = Pool.m_pFirstFree;
+		Pool.m_pFirstFree = pEntity;
+		ASAN_POISON_MEMORY_REGION(pEntity + 1, Pool.m_Size - sizeof(CFreeEntity));
+	}
+
+	static void AllocateChunk(CSizePool &Pool)
+	{
+		const size_t Stride = (Pool.m_Size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+		char *pChunk = static_cast<char *>(malloc(Stride * CHUNK_ENTITIES));
+		for(int i = CHUNK_ENTITIES - 1; i >= 0; i--)
+			AddFree(Pool, pChunk + i * Stride);
+	}
+};
+
+// prediction worlds are only used by the thread that created them
+static CEntityPool &EntityPool()
+{
+	static thread_local CEntityPool *s_pPool = new CEntityPool();
+	return *s_pPool;
+}
+
+void *CEntity::operator new(size_t Size)
+{
+	void *pObj = EntityPool().Allocate(Size);
+	mem_zero(pObj, Size);
+	return pObj;
+}
+
+void CEntity::operator delete(void *pPtr, size_t Size)
+{
+	EntityPool().Free(pPtr, Size);
+}
+
 //////////////////////////////////////////////////
 // Entity
 //////////////////////////////////////////////////
@@ -21,11 +113,16 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 
 	m_pPrevTypeEntity = nullptr;
 	m_pNextTypeEntity = nullptr;
+	m_ListOrder = 0;
+	m_pPrevGridEntity = nullptr;
+	m_pNextGridEntity = nullptr;
+	m_GridCell = -1;
 	m_SnapTicks = -1;
 
 	// DDRace
 	m_pParent = nullptr;
 	m_pChild = nullptr;
+	m_pSavedParent = nullptr;
 	m_DestroyTick = -1;
 	m_LastRenderTick = -1;
 }
@@ -11,12 +11,23 @@
 
 class CEntity
 {
-	MACRO_ALLOC_HEAP()
+public:
+	// the entities of every prediction are copied, so they reuse the memory of deleted entities, see entity.cpp
+	void *operator new(size_t Size);
+	void operator delete(void *pPtr, size_t Size);
 
 private:
 	friend CGameWorld; // entity list handling
+	friend CEntityGrid<CEntity>;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	// higher is closer to the front of the entity list
+	int64_t m_ListOrder;
+
+	// position index, see CEntityGrid
+	CEntity *m_pPrevGridEntity;
+	CEntity *m_pNextGridEntity;
+	int m_GridCell;
 
 protected:
 	CGameWorld *m_pGameWorld;
@@ -58,6 +69,8 @@ public:
 	int m_LastRenderTick;
 	CEntity *m_pParent;
 	CEntity *m_pChild;
+	// the parent of the entity this one was copied from, see CGameWorld::SaveWorld
+	CEntity *m_pSavedParent;
 	CEntity *NextEntity() { return m_pNextTypeEntity; }
 	void Keep()
 	{
@@ -69,6 +82,10 @@ public:
 	{
 		m_Id = -1;
 		m_pGameWorld = nullptr;
+		m_ListOrder = 0;
+		m_pPrevGridEntity = nullptr;
+		m_pNextGridEntity = nullptr;
+		m_GridCell = -1;
 	}
 };
 
@@ -17,6 +17,7 @@
 #include <game/client/laser_data.h>
 #include <game/client/pickup_data.h>
 #include <game/client/projectile_data.h>
+#include <game/collision.h>
 #include <game/mapbugs.h>
 #include <game/mapitems.h>
 
@@ -36,6 +37,7 @@ CGameWorld::CGameWorld()
 	m_GameTick = 0;
 	m_pParent = nullptr;
 	m_pChild = nullptr;
+	m_pSavedParent = nullptr;
 }
 
 CGameWorld::~CGameWorld()
@@ -64,27 +66,67 @@ CEntity *CGameWorld::FindLast(int Type)
 	return pLast;
 }
 
-int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
+template<typename F>
+void CGameWorld::FindCandidates(int Type, vec2 Pos0, vec2 Pos1, float Radius, F &&Func)
 {
 	if(Type < 0 || Type >= NUM_ENTTYPES)
-		return 0;
+		return;
 
-	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+	const CEntityGrid<CEntity> &Grid = m_aEntityGrids[Type];
+	if(!Grid.IsInitialized())
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			if(Func(pEnt))
+				break;
+		}
+		return;
+	}
+
+	m_vpGridCandidates.clear();
+	Grid.ForEach(Pos0, Pos1, Radius, [&](CEntity *pEnt) {
+#ifdef CONF_DEBUG
+		dbg_assert(Grid.IsInCorrectCell(pEnt), "entity was moved without CGameWorld::MoveEntity");
+#endif
+		m_vpGridCandidates.push_back(pEnt);
+	});
+	// keep the order of the entity list, the prediction depends on it
+	std::sort(m_vpGridCandidates.begin(), m_vpGridCandidates.end(), [](const CEntity *pA, const CEntity *pB) {
+		return pA->m_ListOrder > pB->m_ListOrder;
+	});
+	for(CEntity *pEnt : m_vpGridCandidates)
 	{
+		if(Func(pEnt))
+			break;
+	}
+}
+
+int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
+{
+	int Num = 0;
+	FindCandidates(Type, Pos, Pos, Radius, [&](CEntity *pEnt) {
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
 			if(ppEnts)
 				ppEnts[Num] = pEnt;
 			Num++;
 			if(Num == Max)
-				break;
+				return true;
 		}
-	}
+		return false;
+	});
 
 	return Num;
 }
 
+void CGameWorld::InitEntityGrid(int Type)
+{
+	CEntityGrid<CEntity> &Grid = m_aEntityGrids[Type];
+	Grid.Init(m_pCollision->GetWidth(), m_pCollision->GetHeight());
+	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		Grid.Insert(pEnt);
+}
+
 void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 {
 	pEnt->m_pGameWorld = this;
@@ -115,6 +157,17 @@ void CGameWorld::InsertEntity(CEntity *pEnt, bool Last)
 		pEnt->m_pPrevTypeEntity = pLast;
 		pEnt->m_pNextTypeEntity = nullptr;
 	}
+	pEnt->m_ListOrder = Last ? m_NextBackOrder-- : m_NextFrontOrder++;
+
+	if(HasEntityGrid(pEnt->m_ObjType) && m_pCollision)
+	{
+		// the grid is sized lazily since the collision can change with the map
+		CEntityGrid<CEntity> &Grid = m_aEntityGrids[pEnt->m_ObjType];
+		if(Grid.IsSizedFor(m_pCollision->GetWidth(), m_pCollision->GetHeight()))
+			Grid.Insert(pEnt);
+		else
+			InitEntityGrid(pEnt->m_ObjType);
+	}
 
 	if(pEnt->m_ObjType == ENTTYPE_CHARACTER)
 	{
@@ -149,6 +202,7 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
+	m_aEntityGrids[pEnt->m_ObjType].Remove(pEnt);
 
 	if(pEnt->m_pParent)
 	{
@@ -164,6 +218,12 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 	}
 }
 
+void CGameWorld::MoveEntity(CEntity *pEnt, vec2 Pos)
+{
+	pEnt->m_Pos = Pos;
+	m_aEntityGrids[pEnt->m_ObjType].Move(pEnt);
+}
+
 void CGameWorld::RemoveCharacter(CCharacter *pChar)
 {
 	int Id = pChar->GetCid();
@@ -227,6 +287,17 @@ void CGameWorld::Tick()
 
 	RemoveEntities();
 
+#ifdef CONF_DEBUG
+	// positions written without MoveEntity would make the queries miss entities
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		if(!m_aEntityGrids[Type].IsInitialized())
+			continue;
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			dbg_assert(m_aEntityGrids[Type].IsInCorrectCell(pEnt), "entity was moved without CGameWorld::MoveEntity");
+	}
+#endif
+
 	// update switch state
 	for(auto &Switcher : Switchers())
 	{
@@ -260,17 +331,15 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	FindCandidates(Type, Pos0, Pos1, Radius, [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return false;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return false;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return false;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -287,7 +356,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+		return false;
+	});
 
 	return pClosest;
 }
@@ -295,11 +365,9 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
+	FindCandidates(CGameWorld::ENTTYPE_CHARACTER, Pos0, Pos1, Radius, [&](CEntity *pChr) {
 		if(pChr == pNotThis)
-			continue;
+			return false;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
@@ -307,10 +375,11 @@ std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1
 			float Len = distance(pChr->m_Pos, IntersectPos);
 			if(Len < pChr->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pChr);
 			}
 		}
-	}
+		return false;
+	});
 	return vpCharacters;
 }
 
@@ -490,7 +559,7 @@ void CGameWorld::NetObjAdd(int ObjId, int ObjType, const void *pObjData, const C
 		{
 			if(NetPickup.Match(pPickup))
 			{
-				pPickup->m_Pos = NetPickup.m_Pos;
+				MoveEntity(pPickup, NetPickup.m_Pos);
 				pPickup->Keep();
 				return;
 			}
@@ -592,7 +661,8 @@ void CGameWorld::NetObjEnd()
 				if(CCharacter *pHookedChar = GetCharacterById(pChar->m_Core.HookedPlayer()))
 					if(pHookedChar->m_MarkedForDestroy)
 					{
-						pHookedChar->m_Pos = pHookedChar->m_Core.m_Pos = pChar->m_Core.m_HookPos;
+						MoveEntity(pHookedChar, pChar->m_Core.m_HookPos);
+						pHookedChar->m_Core.m_Pos = pChar->m_Core.m_HookPos;
 						pHookedChar->ResetVelocity();
 						mem_zero(&pHookedChar->m_SavedInput, sizeof(pHookedChar->m_SavedInput));
 						pHookedChar->m_SavedInput.m_TargetY = -1;
@@ -667,16 +737,9 @@ void CGameWorld::CopyWorldClean(CGameWorld *pFrom)
 	}
 }
 
-void CGameWorld::CopyWorld(CGameWorld *pFrom)
+template<typename F>
+void CGameWorld::CopyEntities(CGameWorld *pFrom, F &&LinkCopy)
 {
-	if(pFrom == this || !pFrom)
-		return;
-	m_IsValidCopy = false;
-	m_pParent = pFrom;
-	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
-		m_pParent->m_pChild->m_IsValidCopy = false;
-	pFrom->m_pChild = this;
-
 	m_GameTick = pFrom->m_GameTick;
 	m_pCollision = pFrom->m_pCollision;
 	m_WorldConfig = pFrom->m_WorldConfig;
@@ -715,15 +778,70 @@ void CGameWorld::CopyWorld(CGameWorld *pFrom)
 				pCopy = new CPlasma(*((CPlasma *)pEnt));
 			if(pCopy)
 			{
-				pCopy->m_pParent = pEnt;
-				pEnt->m_pChild = pCopy;
+				LinkCopy(pCopy, pEnt);
 				this->InsertEntity(pCopy);
 			}
 		}
 	}
+}
+
+void CGameWorld::LinkParent(CGameWorld *pParent)
+{
+	m_pParent = pParent;
+	if(!m_pParent)
+		return;
+	if(m_pParent->m_pChild && m_pParent->m_pChild != this)
+		m_pParent->m_pChild->m_IsValidCopy = false;
+	m_pParent->m_pChild = this;
+}
+
+void CGameWorld::CopyWorld(CGameWorld *pFrom)
+{
+	if(pFrom == this || !pFrom)
+		return;
+	m_IsValidCopy = false;
+	LinkParent(pFrom);
+
+	CopyEntities(pFrom, [](CEntity *pCopy, CEntity *pEnt) {
+		pCopy->m_pParent = pEnt;
+		pEnt->m_pChild = pCopy;
+		pCopy->m_pSavedParent = nullptr;
+	});
 	m_IsValidCopy = true;
 }
 
+void CGameWorld::SaveWorld(CGameWorld *pFrom)
+{
+	if(pFrom == this || !pFrom)
+		return;
+	m_IsValidCopy = false;
+	m_pParent = nullptr;
+	m_pSavedParent = pFrom->m_pParent;
+
+	CopyEntities(pFrom, [](CEntity *pCopy, CEntity *pEnt) {
+		pCopy->m_pParent = nullptr;
+		pCopy->m_pChild = nullptr;
+		pCopy->m_pSavedParent = pEnt->m_pParent;
+	});
+}
+
+void CGameWorld::RestoreWorld(CGameWorld *pFrom)
+{
+	if(pFrom == this || !pFrom)
+		return;
+	m_IsValidCopy = false;
+	LinkParent(pFrom->m_pSavedParent);
+
+	CopyEntities(pFrom, [](CEntity *pCopy, CEntity *pEnt) {
+		pCopy->m_pParent = pEnt->m_pSavedParent;
+		pCopy->m_pChild = nullptr;
+		pCopy->m_pSavedParent = nullptr;
+		if(pCopy->m_pParent)
+			pCopy->m_pParent->m_pChild = pCopy;
+	});
+	m_IsValidCopy = m_pParent != nullptr;
+}
+
 CEntity *CGameWorld::FindMatch(int ObjId, int ObjType, const void *pObjData)
 {
 	switch(ObjType)
@@ -3,6 +3,7 @@
 #ifndef GAME_CLIENT_PREDICTION_GAMEWORLD_H
 #define GAME_CLIENT_PREDICTION_GAMEWORLD_H
 
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 #include <game/teamscore.h>
 
@@ -46,6 +47,8 @@ public:
 	void InsertEntity(CEntity *pEntity, bool Last = false);
 	void RemoveEntity(CEntity *pEntity);
 	void RemoveCharacter(CCharacter *pChar);
+	// sets the position and keeps the spatial index up to date, characters and pickups must be moved with it
+	void MoveEntity(CEntity *pEntity, vec2 Pos);
 	void Tick();
 
 	// DDRace
@@ -89,6 +92,7 @@ public:
 	bool m_IsValidCopy;
 	CGameWorld *m_pParent;
 	CGameWorld *m_pChild;
+	CGameWorld *m_pSavedParent;
 
 	int m_LocalClientId;
 
@@ -100,6 +104,11 @@ public:
 	void NetObjEnd();
 	void CopyWorld(CGameWorld *pFrom);
 	void CopyWorldClean(CGameWorld *pFrom); // TClient
+	// TClient
+	// copies the world without becoming a child of it, the parents of pFrom are remembered instead
+	void SaveWorld(CGameWorld *pFrom);
+	// copies a world stored with SaveWorld and links the copy to the remembered parents, which must not have changed since
+	void RestoreWorld(CGameWorld *pFrom);
 	CEntity *FindMatch(int ObjId, int ObjType, const void *pObjData);
 	void Clear();
 
@@ -115,8 +124,24 @@ public:
 private:
 	void RemoveEntities();
 
+	void LinkParent(CGameWorld *pParent);
+	// copies the state and entities of pFrom, LinkCopy is called with each copy and its source entity
+	template<typename F>
+	void CopyEntities(CGameWorld *pFrom, F &&LinkCopy);
+
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
+	int64_t m_NextFrontOrder = 0;
+	int64_t m_NextBackOrder = -1;
+
+	// spatial index of the entity types that are searched by position
+	CEntityGrid<CEntity> m_aEntityGrids[NUM_ENTTYPES];
+	std::vector<CEntity *> m_vpGridCandidates;
+	static bool HasEntityGrid(int Type) { return Type == ENTTYPE_CHARACTER || Type == ENTTYPE_PICKUP; }
+	void InitEntityGrid(int Type);
+	// calls Func in list order for the entities that can be closer than Radius to the box spanned by the positions, until it returns true
+	template<typename F>
+	void FindCandidates(int Type, vec2 Pos0, vec2 Pos1, float Radius, F &&Func);
 
 	CCharacter *m_apCharacters[MAX_CLIENTS];
 };
@@ -18,6 +18,7 @@
 #include <game/client/gameclient.h>
 #include <game/mapitems.h>
 
+#include <algorithm>
 #include <cmath>
 
 CSkinDescriptor::CSkinDescriptor()
@@ -128,6 +129,17 @@ void CRenderTools::Init(IGraphics *pGraphics, ITextRender *pTextRender, CGameCli
 	Graphics()->QuadsSetSubsetFree(1, 0, 0, 0, 0, 1, 1, 1);
 	Graphics()->QuadContainerAddSprite(m_TeeQuadContainerIndex, -32.f, -16.f, 64.f, 32.f);
 
+	// Mirrored Eyes and blinking eyes, batched tees can only be scaled uniformly
+	for(int i = 0; i < 5; i++)
+	{
+		Graphics()->QuadsSetSubsetFree(1, 0, 0, 0, 0, 1, 1, 1);
+		Graphics()->QuadContainerAddSprite(m_TeeQuadContainerIndex, 64.f * 0.4f);
+	}
+	Graphics()->QuadsSetSubset(0, 0, 1, 1);
+	Graphics()->QuadContainerAddSprite(m_TeeQuadContainerIndex, 64.f * 0.4f, 64.f * 0.15f);
+	Graphics()->QuadsSetSubsetFree(1, 0, 0, 0, 0, 1, 1, 1);
+	Graphics()->QuadContainerAddSprite(m_TeeQuadContainerIndex, 64.f * 0.4f, 64.f * 0.15f);
+
 	Graphics()->QuadContainerUpload(m_TeeQuadContainerIndex);
 }
 
@@ -255,12 +267,121 @@ void CRenderTools::GetRenderTeeOffsetToRenderedTee(const CAnimState *pAnim, cons
 	TeeOffsetToMid.y = -MidOfRendered;
 }
 
+void CRenderTools::RenderTeePart(int Layer, IGraphics::CTextureHandle Texture, const ColorRGBA &Color, int QuadOffset, vec2 Pos, float ScaleX, float ScaleY, float Rotation) const
+{
+	if(m_TeeBatchActive)
+	{
+		dbg_assert(ScaleX == ScaleY, "batched tee parts must be scaled uniformly");
+		CTeePart Part;
+		Part.m_Texture = Texture;
+		Part.m_Color = Color;
+		Part.m_QuadOffset = QuadOffset;
+		Part.m_Info.m_Pos = Pos;
+		Part.m_Info.m_Scale = ScaleX;
+		Part.m_Info.m_Rotation = Rotation;
+		m_avTeeBatch[Layer].push_back(Part);
+
+		// half size of the quad as added in Init: body, eyes, feet, mirrored eyes and blinking eyes
+		vec2 HalfSize = vec2(64.0f * 0.4f, 64.0f * 0.4f) / 2.0f;
+		if(QuadOffset < 2)
+			HalfSize = vec2(32.0f, 32.0f);
+		else if(QuadOffset >= 7 && QuadOffset < 11)
+			HalfSize = vec2(32.0f, 16.0f);
+		else if(QuadOffset >= 16)
+			HalfSize = vec2(64.0f * 0.4f, 64.0f * 0.15f) / 2.0f;
+		HalfSize *= ScaleX;
+		const float Cos = absolute(std::cos(Rotation));
+		const float Sin = absolute(std::sin(Rotation));
+		const vec2 Extent = vec2(Cos * HalfSize.x + Sin * HalfSize.y, Sin * HalfSize.x + Cos * HalfSize.y);
+		m_TeeBounds.x = std::min(m_TeeBounds.x, Pos.x - Extent.x);
+		m_TeeBounds.y = std::min(m_TeeBounds.y, Pos.y - Extent.y);
+		m_TeeBounds.z = std::max(m_TeeBounds.z, Pos.x + Extent.x);
+		m_TeeBounds.w = std::max(m_TeeBounds.w, Pos.y + Extent.y);
+		return;
+	}
+
+	Graphics()->QuadsSetRotation(Rotation);
+	Graphics()->SetColor(Color);
+	Graphics()->TextureSet(Texture);
+	Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset, Pos.x, Pos.y, ScaleX, ScaleY);
+}
+
+void CRenderTools::BeginTeeBatch() const
+{
+	dbg_assert(!m_TeeBatchActive, "tee batch already active");
+	// without buffering every instance would be drawn on its own anyway
+	m_TeeBatchActive = g_Config.m_TcTeeBatching && Graphics()->IsQuadContainerBufferingEnabled();
+}
+
+void CRenderTools::EndTeeBatch() const
+{
+	if(!m_TeeBatchActive)
+		return;
+	m_TeeBatchActive = false;
+	FlushTeeBatch();
+}
+
+void CRenderTools::FlushTeeBatch(const size_t *pNumParts) const
+{
+	for(int Layer = 0; Layer < NUM_TEE_LAYERS; Layer++)
+	{
+		std::vector<CTeePart> &vParts = m_avTeeBatch[Layer];
+		const size_t NumParts = pNumParts ? pNumParts[Layer] : vParts.size();
+
+		// only neighbouring tees are drawn together, so the order of the tees is kept
+		size_t Start = 0;
+		while(Start < NumParts)
+		{
+			const CTeePart &First = vParts[Start];
+			m_vTeeBatchInfos.clear();
+			size_t End = Start;
+			while(End < NumParts && vParts[End].m_Texture.Id() == First.m_Texture.Id() && vParts[End].m_QuadOffset == First.m_QuadOffset && vParts[End].m_Color == First.m_Color)
+			{
+				m_vTeeBatchInfos.push_back(vParts[End].m_Info);
+				End++;
+			}
+			Graphics()->TextureSet(First.m_Texture);
+			Graphics()->SetColor(First.m_Color);
+			Graphics()->RenderQuadContainerAsSpriteMultiple(m_TeeQuadContainerIndex, First.m_QuadOffset, m_vTeeBatchInfos.size(), m_vTeeBatchInfos.data());
+			Start = End;
+		}
+		vParts.erase(vParts.begin(), vParts.begin() + NumParts);
+	}
+	m_vTeeBatchBounds.clear();
+	Graphics()->SetColor(1.0f, 1.0f, 1.0f, 1.0f);
+	Graphics()->QuadsSetRotation(0);
+}
+
 void CRenderTools::RenderTee(const CAnimState *pAnim, const CTeeRenderInfo *pInfo, int Emote, vec2 Dir, vec2 Pos, float Alpha) const
 {
 	if(pInfo->m_aSixup[g_Config.m_ClDummy].PartTexture(protocol7::SKINPART_BODY).IsValid())
+	{
+		// 0.7 tees are not batched, draw the tees before them first
+		if(m_TeeBatchActive)
+			FlushTeeBatch();
 		RenderTee7(pAnim, pInfo, Emote, Dir, Pos, Alpha);
+	}
+	else if(m_TeeBatchActive)
+	{
+		size_t aNumParts[NUM_TEE_LAYERS];
+		for(int Layer = 0; Layer < NUM_TEE_LAYERS; Layer++)
+			aNumParts[Layer] = m_avTeeBatch[Layer].size();
+		m_TeeBounds = vec4(Pos.x, Pos.y, Pos.x, Pos.y);
+		RenderTee6(pAnim, pInfo, Emote, Dir, Pos, Alpha);
+
+		// drawing overlapping tees layer by layer would put parts of one tee over the other, draw the earlier tees first
+		const vec4 &Bounds = m_TeeBounds;
+		const bool Overlaps = std::any_of(m_vTeeBatchBounds.begin(), m_vTeeBatchBounds.end(), [&](const vec4 &Other) {
+			return Bounds.x < Other.z && Other.x < Bounds.z && Bounds.y < Other.w && Other.y < Bounds.w;
+		});
+		if(Overlaps)
+			FlushTeeBatch(aNumParts);
+		m_vTeeBatchBounds.push_back(Bounds);
+	}
 	else
+	{
 		RenderTee6(pAnim, pInfo, Emote, Dir, Pos, Alpha);
+	}
 
 	Graphics()->SetColor(1.f, 1.f, 1.f, 1.f);
 	Graphics()->QuadsSetRotation(0);
@@ -518,15 +639,14 @@ void CRenderTools::RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pIn
 
 			if(Filling == 1)
 			{
-				Graphics()->QuadsSetRotation(pAnim->GetBody()->m_Angle * pi * 2);
+				const float BodyRotation = pAnim->GetBody()->m_Angle * pi * 2;
 
 				// draw body
-				Graphics()->SetColor(pInfo->m_ColorBody.r, pInfo->m_ColorBody.g, pInfo->m_ColorBody.b, Alpha);
+				const ColorRGBA BodyColor(pInfo->m_ColorBody.r, pInfo->m_ColorBody.g, pInfo->m_ColorBody.b, Alpha);
 				vec2 BodyPos = Position + vec2(pAnim->GetBody()->m_X, pAnim->GetBody()->m_Y) * AnimScale;
 				float BodyScale;
 				GetRenderTeeBodyScale(BaseSize, BodyScale);
-				Graphics()->TextureSet(OutLine == 1 ? pSkinTextures->m_BodyOutline : pSkinTextures->m_Body);
-				Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, OutLine, BodyPos.x, BodyPos.y, BodyScale, BodyScale);
+				RenderTeePart(OutLine == 1 ? TEE_LAYER_BODY_OUTLINE : TEE_LAYER_BODY, OutLine == 1 ? pSkinTextures->m_BodyOutline : pSkinTextures->m_Body, BodyColor, OutLine, BodyPos, BodyScale, BodyScale, BodyRotation);
 
 				// draw eyes
 				if(Pass == 1)
@@ -563,9 +683,22 @@ void CRenderTools::RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pIn
 					float EyeSeparation = (0.075f - 0.010f * absolute(Direction.x)) * BaseSize;
 					vec2 Offset = vec2(Direction.x * 0.125f, -0.05f + Direction.y * 0.10f) * BaseSize;
 
-					Graphics()->TextureSet(pSkinTextures->m_aEyes[TeeEye]);
-					Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, BodyPos.x - EyeSeparation + Offset.x, BodyPos.y + Offset.y, EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
-					Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, BodyPos.x + EyeSeparation + Offset.x, BodyPos.y + Offset.y, -EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
+					const vec2 LeftEyePos = BodyPos + vec2(-EyeSeparation + Offset.x, Offset.y);
+					const vec2 RightEyePos = BodyPos + vec2(EyeSeparation + Offset.x, Offset.y);
+					if(m_TeeBatchActive)
+					{
+						// mirrored quads instead of negative scales, the mirror also turns the rotation around
+						const int EyeQuad = Emote == EMOTE_BLINK ? 16 : QuadOffset + EyeQuadOffset;
+						const int MirroredEyeQuad = Emote == EMOTE_BLINK ? 17 : 11 + EyeQuadOffset;
+						RenderTeePart(TEE_LAYER_EYES, pSkinTextures->m_aEyes[TeeEye], BodyColor, EyeQuad, LeftEyePos, EyeScale / (64.f * 0.4f), EyeScale / (64.f * 0.4f), BodyRotation);
+						RenderTeePart(TEE_LAYER_EYES, pSkinTextures->m_aEyes[TeeEye], BodyColor, MirroredEyeQuad, RightEyePos, EyeScale / (64.f * 0.4f), EyeScale / (64.f * 0.4f), -BodyRotation);
+					}
+					else
+					{
+						Graphics()->TextureSet(pSkinTextures->m_aEyes[TeeEye]);
+						Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, LeftEyePos.x, LeftEyePos.y, EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
+						Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset + EyeQuadOffset, RightEyePos.x, RightEyePos.y, -EyeScale / (64.f * 0.4f), h / (64.f * 0.4f));
+					}
 				}
 			}
 
@@ -593,8 +726,6 @@ void CRenderTools::RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pIn
 				QuadOffset += 2;
 			}
 
-			Graphics()->QuadsSetRotation(pFoot->m_Angle * pi * 2);
-
 			bool Indicate = !pInfo->m_GotAirJump && g_Config.m_ClAirjumpindicator;
 			float ColorScale = 1.0f;
 
@@ -605,8 +736,9 @@ void CRenderTools::RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pIn
 					ColorScale = 0.5f;
 			}
 
-			Graphics()->SetColor(pInfo->m_ColorFeet.r * ColorScale, pInfo->m_ColorFeet.g * ColorScale, pInfo->m_ColorFeet.b * ColorScale, Alpha);
+			const ColorRGBA FeetColor(pInfo->m_ColorFeet.r * ColorScale, pInfo->m_ColorFeet.g * ColorScale, pInfo->m_ColorFeet.b * ColorScale, Alpha);
 
+			IGraphics::CTextureHandle FeetTexture;
 			if(g_Config.m_TcWhiteFeet && pInfo->m_CustomColoredSkin)
 			{
 				CTeeRenderInfo WhiteFeetInfo;
@@ -614,14 +746,19 @@ void CRenderTools::RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pIn
 				WhiteFeetInfo.m_OriginalRenderSkin = pSkin->m_OriginalSkin;
 				WhiteFeetInfo.m_ColorFeet = ColorRGBA(1, 1, 1);
 				const CSkin::CSkinTextures *pWhiteFeetTextures = &WhiteFeetInfo.m_OriginalRenderSkin;
-				Graphics()->TextureSet(OutLine == 1 ? pWhiteFeetTextures->m_FeetOutline : pWhiteFeetTextures->m_Feet);
+				FeetTexture = OutLine == 1 ? pWhiteFeetTextures->m_FeetOutline : pWhiteFeetTextures->m_Feet;
 			}
 			else
 			{
-				Graphics()->TextureSet(OutLine == 1 ? pSkinTextures->m_FeetOutline : pSkinTextures->m_Feet);
+				FeetTexture = OutLine == 1 ? pSkinTextures->m_FeetOutline : pSkinTextures->m_Feet;
 			}
 
-			Graphics()->RenderQuadContainerAsSprite(m_TeeQuadContainerIndex, QuadOffset, Position.x + pFoot->m_X * AnimScale, Position.y + pFoot->m_Y * AnimScale, w / 64.f, h / 32.f);
+			int Layer;
+			if(OutLine == 1)
+				Layer = Filling ? TEE_LAYER_FRONT_FOOT_OUTLINE : TEE_LAYER_BACK_FOOT_OUTLINE;
+			else
+				Layer = Filling ? TEE_LAYER_FRONT_FOOT : TEE_LAYER_BACK_FOOT;
+			RenderTeePart(Layer, FeetTexture, FeetColor, QuadOffset, Position + vec2(pFoot->m_X, pFoot->m_Y) * AnimScale, w / 64.f, h / 32.f, pFoot->m_Angle * pi * 2);
 		}
 	}
 }
@@ -16,6 +16,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 class CAnimState;
 class CSpeedupTile;
@@ -215,11 +216,43 @@ class CRenderTools
 
 	int m_TeeQuadContainerIndex;
 
+	// the order the parts of six tees are rendered in
+	enum
+	{
+		TEE_LAYER_BACK_FOOT_OUTLINE = 0,
+		TEE_LAYER_BODY_OUTLINE,
+		TEE_LAYER_FRONT_FOOT_OUTLINE,
+		TEE_LAYER_BACK_FOOT,
+		TEE_LAYER_BODY,
+		TEE_LAYER_EYES,
+		TEE_LAYER_FRONT_FOOT,
+		NUM_TEE_LAYERS,
+	};
+
+	class CTeePart
+	{
+	public:
+		IGraphics::CTextureHandle m_Texture;
+		ColorRGBA m_Color;
+		int m_QuadOffset;
+		IGraphics::SRenderSpriteInfo m_Info;
+	};
+
+	mutable bool m_TeeBatchActive = false;
+	mutable std::vector<CTeePart> m_avTeeBatch[NUM_TEE_LAYERS];
+	mutable std::vector<IGraphics::SRenderSpriteInfo> m_vTeeBatchInfos;
+	// the area covered by each tee in the batch, and by the tee that is being added
+	mutable std::vector<vec4> m_vTeeBatchBounds;
+	mutable vec4 m_TeeBounds;
+
+	void RenderTeePart(int Layer, IGraphics::CTextureHandle Texture, const ColorRGBA &Color, int QuadOffset, vec2 Pos, float ScaleX, float ScaleY, float Rotation) const;
+
 	static void GetRenderTeeBodyScale(float BaseSize, float &BodyScale);
 	static void GetRenderTeeFeetScale(float BaseSize, float &FeetScaleWidth, float &FeetScaleHeight);
 
 	void RenderTee6(const CAnimState *pAnim, const CTeeRenderInfo *pInfo, int Emote, vec2 Dir, vec2 Pos, float Alpha = 1.0f) const;
 	void RenderTee7(const CAnimState *pAnim, const CTeeRenderInfo *pInfo, int Emote, vec2 Dir, vec2 Pos, float Alpha = 1.0f) const;
+	void FlushTeeBatch(const size_t *pNumParts = nullptr) const;
 
 public:
 	class IGraphics *Graphics() const { return m_pGraphics; }
@@ -242,6 +275,12 @@ public:
 	static void GetRenderTeeOffsetToRenderedTee(const CAnimState *pAnim, const CTeeRenderInfo *pInfo, vec2 &TeeOffsetToMid);
 	// object render methods
 	void RenderTee(const CAnimState *pAnim, const CTeeRenderInfo *pInfo, int Emote, vec2 Dir, vec2 Pos, float Alpha = 1.0f) const;
+
+	// Six tees rendered between these calls are drawn together, one instanced draw per part for neighbouring tees with the same skin.
+	// A tee that overlaps one in the batch draws the batch first, so tees still cover each other in order.
+	// Anything else drawn in between ends up behind the batched tees.
+	void BeginTeeBatch() const;
+	void EndTeeBatch() const;
 };
 
 #endif
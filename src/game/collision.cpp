@@ -36,6 +36,24 @@ vec2 ClampVel(int MoveRestriction, vec2 Vel)
 	return Vel;
 }
 
+enum
+{
+	// game layer tile if it is between TILE_SOLID and TILE_NOLASER, see GetTile
+	COLFLAG_GAME_MASK = 0x7,
+	// front layer tile if it is TILE_DEATH or TILE_NOLASER, see GetFrontTile
+	COLFLAG_FRONT_SHIFT = 3,
+	COLFLAG_FRONT_MASK = 0x7 << COLFLAG_FRONT_SHIFT,
+	// TILE_THROUGH in the game or front layer
+	COLFLAG_THROUGH = 1 << 6,
+	// TILE_THROUGH_ALL, TILE_THROUGH_CUT or TILE_THROUGH_DIR in the game or front layer
+	COLFLAG_THROUGH_SPECIAL = 1 << 7,
+	// CANTMOVE_* of the stoppers in the game and front layer for moving onto the tile
+	COLFLAG_STOPPERS_SHIFT = 8,
+	// CANTMOVE_* of the stoppers in the game and front layer for standing on the tile
+	COLFLAG_STOPPERS_HERE_SHIFT = 12,
+	COLFLAG_STOPPERS_MASK = 0xf,
+};
+
 CCollision::CCollision()
 {
 	m_pDoor = nullptr;
@@ -146,6 +164,10 @@ void CCollision::Init(class CLayers *pLayers)
 			}
 		}
 	}
+
+	m_vTileFlags.resize((size_t)m_Width * m_Height);
+	for(int i = 0; i < m_Width * m_Height; i++)
+		UpdateTileFlags(i);
 }
 
 void CCollision::Unload()
@@ -161,6 +183,7 @@ void CCollision::Unload()
 	m_TeleOuts.clear();
 	m_TeleCheckOuts.clear();
 	m_TeleOthers.clear();
+	m_vTileFlags.clear();
 
 	m_pTele = nullptr;
 	m_pSpeedup = nullptr;
@@ -263,6 +286,32 @@ static int GetMoveRestrictions(int Direction, int Tile, int Flags)
 	return Result & GetMoveRestrictionsMask(Direction);
 }
 
+void CCollision::UpdateTileFlags(int Index)
+{
+	const int aTiles[] = {m_pTiles[Index].m_Index, m_pFront ? m_pFront[Index].m_Index : (int)TILE_AIR};
+	const int aFlags[] = {m_pTiles[Index].m_Flags, m_pFront ? m_pFront[Index].m_Flags : 0};
+
+	int TileFlags = 0;
+	if(aTiles[0] >= TILE_SOLID && aTiles[0] <= TILE_NOLASER)
+		TileFlags |= aTiles[0];
+	if(aTiles[1] == TILE_DEATH || aTiles[1] == TILE_NOLASER)
+		TileFlags |= aTiles[1] << COLFLAG_FRONT_SHIFT;
+	for(int Layer = 0; Layer < 2; Layer++)
+	{
+		const int Tile = aTiles[Layer];
+		if(Tile == TILE_THROUGH)
+			TileFlags |= COLFLAG_THROUGH;
+		if(Tile == TILE_THROUGH_ALL || Tile == TILE_THROUGH_CUT || Tile == TILE_THROUGH_DIR)
+			TileFlags |= COLFLAG_THROUGH_SPECIAL;
+		const int Restrictions = GetMoveRestrictionsRaw(MR_DIR_HERE, Tile, aFlags[Layer]);
+		TileFlags |= Restrictions << COLFLAG_STOPPERS_SHIFT;
+		// one-way blockers also block moving away from them
+		if(Tile == TILE_STOP)
+			TileFlags |= Restrictions << COLFLAG_STOPPERS_HERE_SHIFT;
+	}
+	m_vTileFlags[Index] = TileFlags;
+}
+
 int CCollision::GetMoveRestrictions(CALLBACK_SWITCHACTIVE pfnSwitchActive, void *pUser, vec2 Pos, float Distance, int OverrideCenterTileIndex) const
 {
 	static const vec2 DIRECTIONS[NUM_MR_DIRS] =
@@ -282,22 +331,12 @@ int CCollision::GetMoveRestrictions(CALLBACK_SWITCHACTIVE pfnSwitchActive, void
 		{
 			ModMapIndex = OverrideCenterTileIndex;
 		}
-		for(int Front = 0; Front < 2; Front++)
-		{
-			int Tile;
-			int Flags;
-			if(!Front)
-			{
-				Tile = GetTileIndex(ModMapIndex);
-				Flags = GetTileFlags(ModMapIndex);
-			}
-			else
-			{
-				Tile = GetFrontTileIndex(ModMapIndex);
-				Flags = GetFrontTileFlags(ModMapIndex);
-			}
-			Restrictions |= ::GetMoveRestrictions(d, Tile, Flags);
-		}
+		// the stoppers of the game and front layer, see UpdateTileFlags
+		const int TileFlags = m_vTileFlags[ModMapIndex];
+		if(d == MR_DIR_HERE)
+			Restrictions |= (TileFlags >> COLFLAG_STOPPERS_HERE_SHIFT) & COLFLAG_STOPPERS_MASK;
+		else
+			Restrictions |= (TileFlags >> COLFLAG_STOPPERS_SHIFT) & GetMoveRestrictionsMask(d);
 		if(pfnSwitchActive)
 		{
 			CDoorTile DoorTile;
@@ -319,37 +358,104 @@ int CCollision::GetTile(int x, int y) const
 
 	int Nx = std::clamp(x / 32, 0, m_Width - 1);
 	int Ny = std::clamp(y / 32, 0, m_Height - 1);
-	const int Index = Ny * m_Width + Nx;
-
-	if(m_pTiles[Index].m_Index >= TILE_SOLID && m_pTiles[Index].m_Index <= TILE_NOLASER)
-		return m_pTiles[Index].m_Index;
-	return 0;
+	return m_vTileFlags[Ny * m_Width + Nx] & COLFLAG_GAME_MASK;
 }
 
-// TODO: rewrite this smarter!
-int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+// The cell of the 32x32 grid a sample of the intersection functions is
+// tested in. Floor division keeps the cells outside of the map apart, so
+// that the offset tiles of IsThrough are the same for the whole cell.
+static ivec2 SampleCell(vec2 Pos)
 {
-	float Distance = distance(Pos0, Pos1);
-	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
+	const int x = round_to_int(Pos.x);
+	const int y = round_to_int(Pos.y);
+	return ivec2(x >= 0 ? x / 32 : (x - 31) / 32, y >= 0 ? y / 32 : (y - 31) / 32);
+}
+
+/*
+	Finds the first of the samples mix(Pos0, Pos1, i / Divisor) with
+	0 <= i < NumSamples for which IsHit returns true. IsHit may only depend
+	on the cell of the sample.
+
+	Both coordinates of the samples are monotonic, so the samples of a cell
+	are consecutive and a cell is never entered twice. Only the first sample
+	of every crossed cell is tested, the last one is guessed from where the
+	segment leaves the cell and corrected with a search over the samples.
+	This returns the same sample as testing all of them in order.
+*/
+template<typename F>
+static bool FirstHitSample(vec2 Pos0, vec2 Pos1, int NumSamples, float Divisor, F &&IsHit, vec2 *pHitPos, vec2 *pBeforeHitPos)
+{
+	const vec2 Delta = Pos1 - Pos0;
+	auto Sample = [&](int i) { return mix(Pos0, Pos1, i / Divisor); };
+	int i = 0;
+	while(i < NumSamples)
 	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
+		const vec2 Pos = Sample(i);
+		if(IsHit(Pos))
+		{
+			*pHitPos = Pos;
+			*pBeforeHitPos = i > 0 ? Sample(i - 1) : Pos0;
+			return true;
+		}
 
-		if(CheckPoint(ix, iy))
+		const ivec2 Cell = SampleCell(Pos);
+		auto InCell = [&](int j) { return SampleCell(Sample(j)) == Cell; };
+		float Exit = 1.0f;
+		if(Delta.x != 0.0f)
+			Exit = minimum(Exit, ((Delta.x > 0.0f ? Cell.x * 32 + 31.5f : Cell.x * 32 - 0.5f) - Pos0.x) / Delta.x);
+		if(Delta.y != 0.0f)
+			Exit = minimum(Exit, ((Delta.y > 0.0f ? Cell.y * 32 + 31.5f : Cell.y * 32 - 0.5f) - Pos0.y) / Delta.y);
+		if(!(Exit > 0.0f)) // also catches NaN
+			Exit = 0.0f;
+		int Last = std::clamp((int)(Exit * Divisor), i, NumSamples - 1);
+		int Step = 1;
+		if(InCell(Last))
 		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			return GetCollisionAt(ix, iy);
+			while(Last + Step < NumSamples && InCell(Last + Step))
+			{
+				Last += Step;
+				Step *= 2;
+			}
+			while(Step > 1)
+			{
+				Step /= 2;
+				if(Last + Step < NumSamples && InCell(Last + Step))
+					Last += Step;
+			}
 		}
+		else
+		{
+			// Last is the first sample after the cell from here on
+			while(Last - Step > i && !InCell(Last - Step))
+			{
+				Last -= Step;
+				Step *= 2;
+			}
+			while(Step > 1)
+			{
+				Step /= 2;
+				if(Last - Step > i && !InCell(Last - Step))
+					Last -= Step;
+			}
+			Last--;
+		}
+		i = Last + 1;
+	}
+	return false;
+}
 
-		Last = Pos;
+int CCollision::IntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+{
+	float Distance = distance(Pos0, Pos1);
+	int End(Distance + 1);
+	vec2 Pos, Last;
+	if(FirstHitSample(Pos0, Pos1, End + 1, End, [&](vec2 Sample) { return CheckPoint(Sample); }, &Pos, &Last))
+	{
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		return GetCollisionAt(Pos.x, Pos.y);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -362,35 +468,25 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
 	int dx = 0, dy = 0; // Offset for checking the "through" tile
 	ThroughOffset(Pos0, Pos1, &dx, &dy);
-	for(int i = 0; i <= End; i++)
-	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
-
-		int Index = GetPureMapIndex(Pos);
+	int TeleNr = 0;
+	int Hit = 0;
+	auto IsHit = [&](vec2 Sample) {
+		int Index = GetPureMapIndex(Sample);
 		if(pTeleNr)
 		{
 			if(g_Config.m_SvOldTeleportHook)
-				*pTeleNr = IsTeleport(Index);
+				TeleNr = IsTeleport(Index);
 			else
-				*pTeleNr = IsTeleportHook(Index);
-		}
-		if(pTeleNr && *pTeleNr)
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			return TILE_TELEINHOOK;
+				TeleNr = IsTeleportHook(Index);
 		}
+		if(TeleNr)
+			return true;
 
-		int Hit = 0;
+		// Temporary position for checking collision
+		int ix = round_to_int(Sample.x);
+		int iy = round_to_int(Sample.y);
 		if(CheckPoint(ix, iy))
 		{
 			if(!IsThrough(ix, iy, dx, dy, Pos0, Pos1))
@@ -400,16 +496,19 @@ int CCollision::IntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision,
 		{
 			Hit = TILE_NOHOOK;
 		}
-		if(Hit)
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			return Hit;
-		}
-
-		Last = Pos;
+		return Hit != 0;
+	};
+	vec2 Pos, Last;
+	const bool Found = FirstHitSample(Pos0, Pos1, End + 1, End, IsHit, &Pos, &Last);
+	if(pTeleNr)
+		*pTeleNr = TeleNr;
+	if(Found)
+	{
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		return TeleNr ? (int)TILE_TELEINHOOK : Hit;
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -422,42 +521,29 @@ int CCollision::IntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 {
 	float Distance = distance(Pos0, Pos1);
 	int End(Distance + 1);
-	vec2 Last = Pos0;
-	for(int i = 0; i <= End; i++)
-	{
-		float a = i / (float)End;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		// Temporary position for checking collision
-		int ix = round_to_int(Pos.x);
-		int iy = round_to_int(Pos.y);
-
-		int Index = GetPureMapIndex(Pos);
+	int TeleNr = 0;
+	auto IsHit = [&](vec2 Sample) {
+		int Index = GetPureMapIndex(Sample);
 		if(pTeleNr)
 		{
 			if(g_Config.m_SvOldTeleportWeapons)
-				*pTeleNr = IsTeleport(Index);
+				TeleNr = IsTeleport(Index);
 			else
-				*pTeleNr = IsTeleportWeapon(Index);
-		}
-		if(pTeleNr && *pTeleNr)
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			return TILE_TELEINWEAPON;
-		}
-
-		if(CheckPoint(ix, iy))
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			return GetCollisionAt(ix, iy);
+				TeleNr = IsTeleportWeapon(Index);
 		}
-
-		Last = Pos;
+		return TeleNr || CheckPoint(Sample);
+	};
+	vec2 Pos, Last;
+	const bool Found = FirstHitSample(Pos0, Pos1, End + 1, End, IsHit, &Pos, &Last);
+	if(pTeleNr)
+		*pTeleNr = TeleNr;
+	if(Found)
+	{
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		return TeleNr ? (int)TILE_TELEINWEAPON : GetCollisionAt(Pos.x, Pos.y);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -605,17 +691,21 @@ int CCollision::IsSolid(int x, int y) const
 bool CCollision::IsThrough(int x, int y, int OffsetX, int OffsetY, vec2 Pos0, vec2 Pos1) const
 {
 	const int Index = GetPureMapIndex(x, y);
+	if(!(m_vTileFlags[Index] & COLFLAG_THROUGH_SPECIAL))
+		return m_vTileFlags[GetPureMapIndex(x + OffsetX, y + OffsetY)] & COLFLAG_THROUGH;
 	if(m_pFront && (m_pFront[Index].m_Index == TILE_THROUGH_ALL || m_pFront[Index].m_Index == TILE_THROUGH_CUT))
 		return true;
 	if(m_pFront && m_pFront[Index].m_Index == TILE_THROUGH_DIR && ((m_pFront[Index].m_Flags == ROTATION_0 && Pos0.y > Pos1.y) || (m_pFront[Index].m_Flags == ROTATION_90 && Pos0.x < Pos1.x) || (m_pFront[Index].m_Flags == ROTATION_180 && Pos0.y < Pos1.y) || (m_pFront[Index].m_Flags == ROTATION_270 && Pos0.x > Pos1.x)))
 		return true;
 	const int OffsetIndex = GetPureMapIndex(x + OffsetX, y + OffsetY);
-	return m_pTiles[OffsetIndex].m_Index == TILE_THROUGH || (m_pFront && m_pFront[OffsetIndex].m_Index == TILE_THROUGH);
+	return m_vTileFlags[OffsetIndex] & COLFLAG_THROUGH;
 }
 
 bool CCollision::IsHookBlocker(int x, int y, vec2 Pos0, vec2 Pos1) const
 {
 	const int Index = GetPureMapIndex(x, y);
+	if(!(m_vTileFlags[Index] & COLFLAG_THROUGH_SPECIAL))
+		return false;
 	if(m_pTiles[Index].m_Index == TILE_THROUGH_ALL || (m_pFront && m_pFront[Index].m_Index == TILE_THROUGH_ALL))
 		return true;
 	if(m_pTiles[Index].m_Index == TILE_THROUGH_DIR && ((m_pTiles[Index].m_Flags == ROTATION_0 && Pos0.y < Pos1.y) ||
@@ -1043,10 +1133,7 @@ int CCollision::GetFrontTile(int x, int y) const
 		return 0;
 	int Nx = std::clamp(x / 32, 0, m_Width - 1);
 	int Ny = std::clamp(y / 32, 0, m_Height - 1);
-	if(m_pFront[Ny * m_Width + Nx].m_Index == TILE_DEATH || m_pFront[Ny * m_Width + Nx].m_Index == TILE_NOLASER)
-		return m_pFront[Ny * m_Width + Nx].m_Index;
-	else
-		return 0;
+	return (m_vTileFlags[Ny * m_Width + Nx] & COLFLAG_FRONT_MASK) >> COLFLAG_FRONT_SHIFT;
 }
 
 int CCollision::Entity(int x, int y, int Layer) const
@@ -1081,6 +1168,7 @@ void CCollision::SetCollisionAt(float x, float y, int Index)
 	int Ny = std::clamp(round_to_int(y) / 32, 0, m_Height - 1);
 
 	m_pTiles[Ny * m_Width + Nx].m_Index = Index;
+	UpdateTileFlags(Ny * m_Width + Nx);
 }
 
 void CCollision::SetDoorCollisionAt(float x, float y, int Type, int Flags, int Number)
@@ -1142,27 +1230,28 @@ void ThroughOffset(vec2 Pos0, vec2 Pos1, int *pOffsetX, int *pOffsetY)
 int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	bool FrontNoLaser = false;
+	auto IsHit = [&](vec2 Sample) {
+		int Nx = std::clamp(round_to_int(Sample.x) / 32, 0, m_Width - 1);
+		int Ny = std::clamp(round_to_int(Sample.y) / 32, 0, m_Height - 1);
+		const int TileFlags = m_vTileFlags[Ny * m_Width + Nx];
+		const int Tile = TileFlags & COLFLAG_GAME_MASK;
+		FrontNoLaser = (TileFlags & COLFLAG_FRONT_MASK) == (TILE_NOLASER << COLFLAG_FRONT_SHIFT);
+		return Tile == TILE_SOLID || Tile == TILE_NOHOOK || Tile == TILE_NOLASER || FrontNoLaser;
+	};
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	vec2 Pos, Last;
+	if(FirstHitSample(Pos0, Pos1, DistanceRounded, Distance, IsHit, &Pos, &Last))
 	{
-		float a = i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, m_Width - 1);
-		int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, m_Height - 1);
-		if(GetIndex(Nx, Ny) == TILE_SOLID || GetIndex(Nx, Ny) == TILE_NOHOOK || GetIndex(Nx, Ny) == TILE_NOLASER || GetFrontIndex(Nx, Ny) == TILE_NOLASER)
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			if(GetFrontIndex(Nx, Ny) == TILE_NOLASER)
-				return GetFrontCollisionAt(Pos.x, Pos.y);
-			else
-				return GetCollisionAt(Pos.x, Pos.y);
-		}
-		Last = Pos;
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		if(FrontNoLaser)
+			return GetFrontCollisionAt(Pos.x, Pos.y);
+		else
+			return GetCollisionAt(Pos.x, Pos.y);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1174,25 +1263,22 @@ int CCollision::IntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2
 int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	auto IsHit = [&](vec2 Sample) {
+		return IsNoLaser(round_to_int(Sample.x), round_to_int(Sample.y)) || IsFrontNoLaser(round_to_int(Sample.x), round_to_int(Sample.y));
+	};
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	vec2 Pos, Last;
+	if(FirstHitSample(Pos0, Pos1, DistanceRounded, Distance, IsHit, &Pos, &Last))
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)) || IsFrontNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
-				return GetCollisionAt(Pos.x, Pos.y);
-			else
-				return GetFrontCollisionAt(Pos.x, Pos.y);
-		}
-		Last = Pos;
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		if(IsNoLaser(round_to_int(Pos.x), round_to_int(Pos.y)))
+			return GetCollisionAt(Pos.x, Pos.y);
+		else
+			return GetFrontCollisionAt(Pos.x, Pos.y);
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -1204,27 +1290,24 @@ int CCollision::IntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollisio
 int CCollision::IntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
 {
 	float Distance = distance(Pos0, Pos1);
-	vec2 Last = Pos0;
+	auto IsHit = [&](vec2 Sample) {
+		return IsSolid(round_to_int(Sample.x), round_to_int(Sample.y)) || (!GetTile(round_to_int(Sample.x), round_to_int(Sample.y)) && !GetFrontTile(round_to_int(Sample.x), round_to_int(Sample.y)));
+	};
 
 	const int DistanceRounded = std::ceil(Distance);
-	for(int i = 0; i < DistanceRounded; i++)
+	vec2 Pos, Last;
+	if(FirstHitSample(Pos0, Pos1, DistanceRounded, Distance, IsHit, &Pos, &Last))
 	{
-		float a = (float)i / Distance;
-		vec2 Pos = mix(Pos0, Pos1, a);
-		if(IsSolid(round_to_int(Pos.x), round_to_int(Pos.y)) || (!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y))))
-		{
-			if(pOutCollision)
-				*pOutCollision = Pos;
-			if(pOutBeforeCollision)
-				*pOutBeforeCollision = Last;
-			if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y)))
-				return -1;
-			else if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)))
-				return GetTile(round_to_int(Pos.x), round_to_int(Pos.y));
-			else
-				return GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y));
-		}
-		Last = Pos;
+		if(pOutCollision)
+			*pOutCollision = Pos;
+		if(pOutBeforeCollision)
+			*pOutBeforeCollision = Last;
+		if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)) && !GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y)))
+			return -1;
+		else if(!GetTile(round_to_int(Pos.x), round_to_int(Pos.y)))
+			return GetTile(round_to_int(Pos.x), round_to_int(Pos.y));
+		else
+			return GetFrontTile(round_to_int(Pos.x), round_to_int(Pos.y));
 	}
 	if(pOutCollision)
 		*pOutCollision = Pos1;
@@ -7,6 +7,7 @@
 
 #include <engine/shared/protocol.h>
 
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -158,6 +159,10 @@ private:
 	CTuneTile *m_pTune;
 	CDoorTile *m_pDoor;
 
+	// COLFLAG_* of every tile, summarizes the game and front layer for the hot queries
+	std::vector<uint16_t> m_vTileFlags;
+	void UpdateTileFlags(int Index);
+
 	// TILE_TELEIN
 	std::map<int, std::vector<vec2>> m_TeleIns;
 	// TILE_TELEOUT
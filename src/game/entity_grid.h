@@ -0,0 +1,155 @@
+#ifndef GAME_ENTITY_GRID_H
+#define GAME_ENTITY_GRID_H
+
+#include <base/math.h>
+#include <base/vmath.h>
+
+#include <vector>
+
+/*
+	Class: CEntityGrid
+		Uniform grid over the map that buckets the entities of one type by
+		their position, so range queries only visit the entities in the cells
+		around the queried area. Used by the server and the prediction world.
+
+		The entity class needs the members m_Pos, m_ProximityRadius,
+		m_GridCell, m_pPrevGridEntity and m_pNextGridEntity. The owner has to
+		call Move whenever m_Pos of an inserted entity changes.
+*/
+template<typename TEntity>
+class CEntityGrid
+{
+public:
+	enum
+	{
+		// in tiles, a few cells cover the range of draggers and plasma turrets
+		CELL_TILES = 8,
+		CELL_SIZE = CELL_TILES * 32,
+	};
+
+	/*
+		Function: Init
+			Sizes the grid for a map. Entities that are still inserted must
+			be inserted again.
+
+		Arguments:
+			Width - Width of the map in tiles.
+			Height - Height of the map in tiles.
+	*/
+	void Init(int Width, int Height)
+	{
+		m_MapWidth = Width;
+		m_MapHeight = Height;
+		m_Width = maximum((Width + CELL_TILES - 1) / CELL_TILES, 1);
+		m_Height = maximum((Height + CELL_TILES - 1) / CELL_TILES, 1);
+		m_vpCells.assign((size_t)m_Width * m_Height, nullptr);
+		m_MaxProximityRadius = 0.0f;
+	}
+
+	bool IsInitialized() const { return !m_vpCells.empty(); }
+	bool IsSizedFor(int Width, int Height) const { return IsInitialized() && m_MapWidth == Width && m_MapHeight == Height; }
+
+	void Insert(TEntity *pEnt)
+	{
+		m_MaxProximityRadius = maximum(m_MaxProximityRadius, (float)pEnt->m_ProximityRadius);
+		Link(pEnt, CellIndex(pEnt->m_Pos));
+	}
+
+	void Remove(TEntity *pEnt)
+	{
+		if(pEnt->m_GridCell < 0)
+			return;
+		Unlink(pEnt);
+	}
+
+	void Move(TEntity *pEnt)
+	{
+		if(pEnt->m_GridCell < 0)
+			return;
+		const int Cell = CellIndex(pEnt->m_Pos);
+		if(Cell == pEnt->m_GridCell)
+			return;
+		Unlink(pEnt);
+		Link(pEnt, Cell);
+	}
+
+	// whether the entity is in the cell of its current position
+	bool IsInCorrectCell(const TEntity *pEnt) const { return pEnt->m_GridCell == CellIndex(pEnt->m_Pos); }
+
+	/*
+		Function: ForEach
+			Calls a function for the entities in all cells that contain
+			entities which can be closer than Radius to the box spanned by
+			the two positions. The order of the entities is unspecified.
+	*/
+	template<typename F>
+	void ForEach(vec2 Pos0, vec2 Pos1, float Radius, F &&Func) const
+	{
+		// one extra unit against rounding differences to the exact distance checks
+		const float Margin = Radius + m_MaxProximityRadius + 1.0f;
+		const int MinX = CellCoord(minimum(Pos0.x, Pos1.x) - Margin, m_Width);
+		const int MaxX = CellCoord(maximum(Pos0.x, Pos1.x) + Margin, m_Width);
+		const int MinY = CellCoord(minimum(Pos0.y, Pos1.y) - Margin, m_Height);
+		const int MaxY = CellCoord(maximum(Pos0.y, Pos1.y) + Margin, m_Height);
+		for(int y = MinY; y <= MaxY; y++)
+		{
+			for(int x = MinX; x <= MaxX; x++)
+			{
+				for(TEntity *pEnt = m_vpCells[y * m_Width + x]; pEnt; pEnt = pEnt->m_pNextGridEntity)
+				{
+					Func(pEnt);
+				}
+			}
+		}
+	}
+
+private:
+	std::vector<TEntity *> m_vpCells;
+	int m_MapWidth = 0;
+	int m_MapHeight = 0;
+	int m_Width = 0;
+	int m_Height = 0;
+	float m_MaxProximityRadius = 0.0f;
+
+	// positions outside of the map end up in the border cells
+	static int CellCoord(float Pos, int Size)
+	{
+		const float Cell = Pos / CELL_SIZE;
+		if(!(Cell >= 0.0f)) // also catches NaN
+			return 0;
+		if(Cell >= Size - 1)
+			return Size - 1;
+		return (int)Cell;
+	}
+
+	int CellIndex(vec2 Pos) const
+	{
+		return CellCoord(Pos.y, m_Height) * m_Width + CellCoord(Pos.x, m_Width);
+	}
+
+	void Link(TEntity *pEnt, int Cell)
+	{
+		TEntity *&pFirst = m_vpCells[Cell];
+		pEnt->m_GridCell = Cell;
+		pEnt->m_pPrevGridEntity = nullptr;
+		pEnt->m_pNextGridEntity = pFirst;
+		if(pFirst)
+			pFirst->m_pPrevGridEntity = pEnt;
+		pFirst = pEnt;
+	}
+
+	void Unlink(TEntity *pEnt)
+	{
+		if(pEnt->m_pPrevGridEntity)
+			pEnt->m_pPrevGridEntity->m_pNextGridEntity = pEnt->m_pNextGridEntity;
+		else
+			m_vpCells[pEnt->m_GridCell] = pEnt->m_pNextGridEntity;
+		if(pEnt->m_pNextGridEntity)
+			pEnt->m_pNextGridEntity->m_pPrevGridEntity = pEnt->m_pPrevGridEntity;
+		pEnt->m_GridCell = -1;
+		pEnt->m_pPrevGridEntity = nullptr;
+		pEnt->m_pNextGridEntity = nullptr;
+	}
+};
+
+#endif
@@ -115,6 +115,23 @@ void CLayers::Init(IMap *pMap, bool GameOnly)
 		}
 	}
 
+	if(!GameOnly)
+	{
+		// the tiles of all tile layers are loaded with the map, load the data of the special entities layers in parallel
+		std::vector<int> vEntitiesData;
+		if(m_pTeleLayer)
+			vEntitiesData.push_back(m_pTeleLayer->m_Tele);
+		if(m_pSpeedupLayer)
+			vEntitiesData.push_back(m_pSpeedupLayer->m_Speedup);
+		if(m_pFrontLayer)
+			vEntitiesData.push_back(m_pFrontLayer->m_Front);
+		if(m_pSwitchLayer)
+			vEntitiesData.push_back(m_pSwitchLayer->m_Switch);
+		if(m_pTuneLayer)
+			vEntitiesData.push_back(m_pTuneLayer->m_Tune);
+		m_pMap->LoadData(vEntitiesData);
+	}
+
 	InitTilemapSkip();
 }
 
@@ -45,6 +45,11 @@ void CDoor::Reset()
 	m_MarkedForDestroy = true;
 }
 
+bool CDoor::SharedSnapClipped(int SnappingClient) const
+{
+	return NetworkClipped(SnappingClient, m_Pos) && NetworkClipped(SnappingClient, m_To);
+}
+
 void CDoor::Snap(int SnappingClient)
 {
 	if(NetworkClipped(SnappingClient, m_Pos) && NetworkClipped(SnappingClient, m_To))
@@ -19,6 +19,8 @@ public:
 
 	void Reset() override;
 	void Snap(int SnappingClient) override;
+	bool SnapShared() const override { return true; }
+	bool SharedSnapClipped(int SnappingClient) const override;
 };
 
 #endif // GAME_SERVER_ENTITIES_DOOR_H
@@ -193,6 +193,6 @@ void CPickup::Move()
 	if(Server()->Tick() % (int)(Server()->TickSpeed() * 0.15f) == 0)
 	{
 		GameServer()->Collision()->MoverSpeed(m_Pos.x, m_Pos.y, &m_Core);
-		m_Pos += m_Core;
+		GameWorld()->MoveEntity(this, m_Pos + m_Core);
 	}
 }
@@ -23,6 +23,11 @@ CEntity::CEntity(CGameWorld *pGameWorld, int ObjType, vec2 Pos, int ProximityRad
 
 	m_pPrevTypeEntity = nullptr;
 	m_pNextTypeEntity = nullptr;
+	m_ListOrder = 0;
+
+	m_pPrevGridEntity = nullptr;
+	m_pNextGridEntity = nullptr;
+	m_GridCell = -1;
 }
 
 CEntity::~CEntity()
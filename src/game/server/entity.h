@@ -23,8 +23,16 @@ class CEntity
 
 private:
 	friend CGameWorld; // entity list handling
+	friend CEntityGrid<CEntity>;
 	CEntity *m_pPrevTypeEntity;
 	CEntity *m_pNextTypeEntity;
+	// higher is closer to the front of the entity list
+	int64_t m_ListOrder;
+
+	// position index, see CEntityGrid
+	CEntity *m_pPrevGridEntity;
+	CEntity *m_pNextGridEntity;
+	int m_GridCell;
 
 	/* Identity */
 	CGameWorld *m_pGameWorld;
@@ -123,6 +131,33 @@ public: // TODO: Maybe make protected
 	*/
 	virtual void Snap(int SnappingClient) {}
 
+	/*
+		Function: SnapShared
+			Checks whether the snapshot items of the entity only depend on
+			the snapping client through network clipping, for clients which
+			support the DDNet entity netobjs. The items of these entities
+			are snapped once per tick and copied into the snapshots of
+			those clients.
+
+		Returns:
+			True if the entity can be snapped once for all clients.
+	*/
+	virtual bool SnapShared() const { return false; }
+
+	/*
+		Function: SharedSnapClipped
+			Performs the network clipping of an entity which is snapped
+			once for all clients.
+
+		Arguments:
+			SnappingClient - ID of the client which snapshot is
+				being generated.
+
+		Returns:
+			True if the entity doesn't have to be in the snapshot.
+	*/
+	virtual bool SharedSnapClipped(int SnappingClient) const { return NetworkClipped(SnappingClient); }
+
 	/*
 		Function: SwapClients
 			Called when two players have swapped their client ids.
@@ -24,6 +24,7 @@
 #include <engine/shared/json.h>
 #include <engine/shared/linereader.h>
 #include <engine/shared/memheap.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocolglue.h>
 #include <engine/storage.h>
 
@@ -199,6 +200,7 @@ void CGameContext::Clear()
 void CGameContext::TeeHistorianWrite(const void *pData, int DataSize, void *pUser)
 {
 	CGameContext *pSelf = (CGameContext *)pUser;
+	CProfileScope Profile(pSelf->Server()->TickProfiler(), CTickProfiler::SECTION_TEEHISTORIAN);
 	aio_write(pSelf->m_pTeeHistorianFile, pData, DataSize);
 }
 
@@ -1357,6 +1359,7 @@ void CGameContext::OnTick()
 
 	if(m_SqlRandomMapResult != nullptr && m_SqlRandomMapResult->m_Completed)
 	{
+		CProfileScope Profile(Server()->TickProfiler(), CTickProfiler::SECTION_SQL_RESULTS);
 		if(m_SqlRandomMapResult->m_Success)
 		{
 			if(m_SqlRandomMapResult->m_ClientId != -1 && m_apPlayers[m_SqlRandomMapResult->m_ClientId] && m_SqlRandomMapResult->m_aMessage[0] != '\0')
@@ -4092,6 +4095,7 @@ void CGameContext::OnInit(const void *pPersistentData)
 
 	m_Layers.Init(Kernel()->RequestInterface<IMap>(), false);
 	m_Collision.Init(&m_Layers);
+	m_World.InitEntityGrid(m_Collision.GetWidth(), m_Collision.GetHeight());
 	m_World.m_pTuningList = m_aTuningList;
 	m_World.m_Core.InitSwitchers(m_Collision.m_HighestSwitchNumber);
 
@@ -13,6 +13,7 @@
 #include "player.h"
 
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 #include <engine/shared/protocolglue.h>
 
 #include <generated/protocol.h>
@@ -388,7 +389,7 @@ bool IGameController::OnEntity(int Index, int x, int y, int Layer, int Flags, bo
 	{
 		int PickupFlags = TileFlagsToPickupFlags(Flags);
 		CPickup *pPickup = new CPickup(&GameServer()->m_World, Type, SubType, Layer, Number, PickupFlags);
-		pPickup->m_Pos = Pos;
+		GameServer()->m_World.MoveEntity(pPickup, Pos);
 		return true; // NOLINT(clang-analyzer-unix.Malloc)
 	}
 
@@ -547,6 +548,7 @@ void IGameController::Tick()
 
 	if(m_pLoadBestTimeResult != nullptr && m_pLoadBestTimeResult->m_Completed)
 	{
+		CProfileScope Profile(Server()->TickProfiler(), CTickProfiler::SECTION_SQL_RESULTS);
 		if(m_pLoadBestTimeResult->m_Success)
 		{
 			m_CurrentRecord = m_pLoadBestTimeResult->m_CurrentRecord;
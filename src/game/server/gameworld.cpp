@@ -9,10 +9,13 @@
 #include "gamecontroller.h"
 
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 
 #include <algorithm>
 #include <utility>
 
+static_assert(CTickProfiler::SECTION_ENTITY_CHARACTER - CTickProfiler::SECTION_ENTITY_PROJECTILE == CGameWorld::ENTTYPE_CHARACTER - CGameWorld::ENTTYPE_PROJECTILE, "the profiler sections must match the entity types");
+
 //////////////////////////////////////////////////
 // game world
 //////////////////////////////////////////////////
@@ -43,6 +46,53 @@ void CGameWorld::SetGameServer(CGameContext *pGameServer)
 	m_pServer = m_pGameServer->Server();
 }
 
+void CGameWorld::InitEntityGrid(int Width, int Height)
+{
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		if(!HasEntityGrid(Type))
+			continue;
+		m_aEntityGrids[Type].Init(Width, Height);
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			m_aEntityGrids[Type].Insert(pEnt);
+	}
+}
+
+template<typename F>
+void CGameWorld::FindCandidates(int Type, vec2 Pos0, vec2 Pos1, float Radius, F &&Func)
+{
+	if(Type < 0 || Type >= NUM_ENTTYPES)
+		return;
+
+	const CEntityGrid<CEntity> &Grid = m_aEntityGrids[Type];
+	if(!Grid.IsInitialized())
+	{
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			if(Func(pEnt))
+				break;
+		}
+		return;
+	}
+
+	m_vpGridCandidates.clear();
+	Grid.ForEach(Pos0, Pos1, Radius, [&](CEntity *pEnt) {
+#ifdef CONF_DEBUG
+		dbg_assert(Grid.IsInCorrectCell(pEnt), "entity was moved without CGameWorld::MoveEntity");
+#endif
+		m_vpGridCandidates.push_back(pEnt);
+	});
+	// keep the order of the entity list, the results of the queries depend on it
+	std::sort(m_vpGridCandidates.begin(), m_vpGridCandidates.end(), [](const CEntity *pA, const CEntity *pB) {
+		return pA->m_ListOrder > pB->m_ListOrder;
+	});
+	for(CEntity *pEnt : m_vpGridCandidates)
+	{
+		if(Func(pEnt))
+			break;
+	}
+}
+
 CEntity *CGameWorld::FindFirst(int Type)
 {
 	return Type < 0 || Type >= NUM_ENTTYPES ? nullptr : m_apFirstEntityTypes[Type];
@@ -50,21 +100,18 @@ CEntity *CGameWorld::FindFirst(int Type)
 
 int CGameWorld::FindEntities(vec2 Pos, float Radius, CEntity **ppEnts, int Max, int Type)
 {
-	if(Type < 0 || Type >= NUM_ENTTYPES)
-		return 0;
-
 	int Num = 0;
-	for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
-	{
+	FindCandidates(Type, Pos, Pos, Radius, [&](CEntity *pEnt) {
 		if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->m_ProximityRadius)
 		{
 			if(ppEnts)
 				ppEnts[Num] = pEnt;
 			Num++;
 			if(Num == Max)
-				break;
+				return true;
 		}
-	}
+		return false;
+	});
 
 	return Num;
 }
@@ -82,6 +129,10 @@ void CGameWorld::InsertEntity(CEntity *pEnt)
 	pEnt->m_pNextTypeEntity = m_apFirstEntityTypes[pEnt->m_ObjType];
 	pEnt->m_pPrevTypeEntity = nullptr;
 	m_apFirstEntityTypes[pEnt->m_ObjType] = pEnt;
+	pEnt->m_ListOrder = m_NextListOrder++;
+	if(m_aEntityGrids[pEnt->m_ObjType].IsInitialized())
+		m_aEntityGrids[pEnt->m_ObjType].Insert(pEnt);
+	m_SharedSnapTick = -1;
 }
 
 void CGameWorld::RemoveEntity(CEntity *pEnt)
@@ -104,11 +155,46 @@ void CGameWorld::RemoveEntity(CEntity *pEnt)
 
 	pEnt->m_pNextTypeEntity = nullptr;
 	pEnt->m_pPrevTypeEntity = nullptr;
+	m_aEntityGrids[pEnt->m_ObjType].Remove(pEnt);
+	m_SharedSnapTick = -1;
+}
+
+void CGameWorld::MoveEntity(CEntity *pEnt, vec2 Pos)
+{
+	pEnt->m_Pos = Pos;
+	m_aEntityGrids[pEnt->m_ObjType].Move(pEnt);
 }
 
 //
+void CGameWorld::SnapShared()
+{
+	m_SharedSnapTick = Server()->Tick();
+	m_vSharedSnapEntities.clear();
+
+	// the demo client is never clipped and sees the entities like the newest clients
+	Server()->SnapBeginShared();
+	for(CEntity *pEnt : m_apFirstEntityTypes)
+	{
+		for(; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+		{
+			if(!pEnt->SnapShared())
+				continue;
+
+			const int FirstItem = Server()->SnapNumShared();
+			pEnt->Snap(SERVER_DEMO_CLIENT);
+			m_vSharedSnapEntities.push_back({pEnt, FirstItem, Server()->SnapNumShared() - FirstItem});
+		}
+	}
+	Server()->SnapEndShared();
+}
+
 void CGameWorld::Snap(int SnappingClient)
 {
+	const bool SharedSnap = Config()->m_SvSharedSnapshot && SnappingClient != SERVER_DEMO_CLIENT &&
+				!Server()->IsSixup(SnappingClient) && GameServer()->GetClientVersion(SnappingClient) >= VERSION_DDNET_ENTITY_NETOBJS;
+	if(SharedSnap && m_SharedSnapTick != Server()->Tick())
+		SnapShared();
+
 	for(CEntity *pEnt = m_apFirstEntityTypes[ENTTYPE_CHARACTER]; pEnt;)
 	{
 		m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
@@ -124,10 +210,21 @@ void CGameWorld::Snap(int SnappingClient)
 		for(CEntity *pEnt = m_apFirstEntityTypes[i]; pEnt;)
 		{
 			m_pNextTraverseEntity = pEnt->m_pNextTypeEntity;
-			pEnt->Snap(SnappingClient);
+			if(!SharedSnap || !pEnt->SnapShared())
+				pEnt->Snap(SnappingClient);
 			pEnt = m_pNextTraverseEntity;
 		}
 	}
+
+	if(SharedSnap)
+	{
+		for(const CSharedSnapEntity &Entity : m_vSharedSnapEntities)
+		{
+			// like a failed SnapNewItem, stop adding items once the snapshot is full
+			if(!Entity.m_pEntity->SharedSnapClipped(SnappingClient) && !Server()->SnapCopyShared(Entity.m_FirstItem, Entity.m_NumItems))
+				break;
+		}
+	}
 }
 
 void CGameWorld::Reset()
@@ -202,6 +299,8 @@ void CGameWorld::Tick()
 		// update all objects
 		for(int i = 0; i < NUM_ENTTYPES; i++)
 		{
+			CProfileScope Profile(Server()->TickProfiler(), CTickProfiler::SECTION_ENTITY_PROJECTILE + i);
+
 			// It's important to call PreTick() and Tick() after each other.
 			// If we call PreTick() before, and Tick() after other entities have been processed, it causes physics changes such as a stronger shotgun or grenade.
 			if(g_Config.m_SvNoWeakHook && i == ENTTYPE_CHARACTER)
@@ -246,6 +345,17 @@ void CGameWorld::Tick()
 
 	RemoveEntities();
 
+#ifdef CONF_DEBUG
+	// positions written without MoveEntity would make the queries miss entities
+	for(int Type = 0; Type < NUM_ENTTYPES; Type++)
+	{
+		if(!m_aEntityGrids[Type].IsInitialized())
+			continue;
+		for(CEntity *pEnt = m_apFirstEntityTypes[Type]; pEnt; pEnt = pEnt->m_pNextTypeEntity)
+			dbg_assert(m_aEntityGrids[Type].IsInCorrectCell(pEnt), "entity was moved without CGameWorld::MoveEntity");
+	}
+#endif
+
 	// find the characters' strong/weak id
 	int StrongWeakId = 0;
 	for(CCharacter *pChar = (CCharacter *)FindFirst(ENTTYPE_CHARACTER); pChar; pChar = (CCharacter *)pChar->TypeNext())
@@ -292,17 +402,15 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 	float ClosestLen = distance(Pos0, Pos1) * 100.0f;
 	CEntity *pClosest = nullptr;
 
-	CEntity *pEntity = FindFirst(Type);
-	for(; pEntity; pEntity = pEntity->TypeNext())
-	{
+	FindCandidates(Type, Pos0, Pos1, Radius, [&](CEntity *pEntity) {
 		if(pEntity == pNotThis)
-			continue;
+			return false;
 
 		if(pThisOnly && pEntity != pThisOnly)
-			continue;
+			return false;
 
 		if(CollideWith != -1 && !pEntity->CanCollide(CollideWith))
-			continue;
+			return false;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pEntity->m_Pos, IntersectPos))
@@ -319,7 +427,8 @@ CEntity *CGameWorld::IntersectEntity(vec2 Pos0, vec2 Pos1, float Radius, int Typ
 				}
 			}
 		}
-	}
+		return false;
+	});
 
 	return pClosest;
 }
@@ -330,11 +439,9 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 	float ClosestRange = Radius * 2;
 	CCharacter *pClosest = nullptr;
 
-	CCharacter *p = (CCharacter *)FindFirst(ENTTYPE_CHARACTER);
-	for(; p; p = (CCharacter *)p->TypeNext())
-	{
+	FindCandidates(ENTTYPE_CHARACTER, Pos, Pos, Radius, [&](CEntity *p) {
 		if(p == pNotThis)
-			continue;
+			return false;
 
 		float Len = distance(Pos, p->m_Pos);
 		if(Len < p->m_ProximityRadius + Radius)
@@ -342,10 +449,11 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 			if(Len < ClosestRange)
 			{
 				ClosestRange = Len;
-				pClosest = p;
+				pClosest = (CCharacter *)p;
 			}
 		}
-	}
+		return false;
+	});
 
 	return pClosest;
 }
@@ -353,11 +461,9 @@ CCharacter *CGameWorld::ClosestCharacter(vec2 Pos, float Radius, const CEntity *
 std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1, float Radius, const CEntity *pNotThis)
 {
 	std::vector<CCharacter *> vpCharacters;
-	CCharacter *pChr = (CCharacter *)FindFirst(CGameWorld::ENTTYPE_CHARACTER);
-	for(; pChr; pChr = (CCharacter *)pChr->TypeNext())
-	{
+	FindCandidates(CGameWorld::ENTTYPE_CHARACTER, Pos0, Pos1, Radius, [&](CEntity *pChr) {
 		if(pChr == pNotThis)
-			continue;
+			return false;
 
 		vec2 IntersectPos;
 		if(closest_point_on_line(Pos0, Pos1, pChr->m_Pos, IntersectPos))
@@ -365,10 +471,11 @@ std::vector<CCharacter *> CGameWorld::IntersectedCharacters(vec2 Pos0, vec2 Pos1
 			float Len = distance(pChr->m_Pos, IntersectPos);
 			if(Len < pChr->m_ProximityRadius + Radius)
 			{
-				vpCharacters.push_back(pChr);
+				vpCharacters.push_back((CCharacter *)pChr);
 			}
 		}
-	}
+		return false;
+	});
 	return vpCharacters;
 }
 
@@ -5,6 +5,7 @@
 
 #include "save.h"
 
+#include <game/entity_grid.h>
 #include <game/gamecore.h>
 
 #include <vector>
@@ -36,6 +37,27 @@ private:
 
 	CEntity *m_pNextTraverseEntity = nullptr;
 	CEntity *m_apFirstEntityTypes[NUM_ENTTYPES];
+	int64_t m_NextListOrder = 0;
+
+	// spatial index of the entity types that are searched by position
+	CEntityGrid<CEntity> m_aEntityGrids[NUM_ENTTYPES];
+	std::vector<CEntity *> m_vpGridCandidates;
+	static bool HasEntityGrid(int Type) { return Type == ENTTYPE_CHARACTER || Type == ENTTYPE_PICKUP; }
+	// calls Func in list order for the entities that can be closer than Radius to the box spanned by the positions, until it returns true
+	template<typename F>
+	void FindCandidates(int Type, vec2 Pos0, vec2 Pos1, float Radius, F &&Func);
+
+	// entities snapped once for all clients, see CEntity::SnapShared
+	class CSharedSnapEntity
+	{
+	public:
+		CEntity *m_pEntity;
+		int m_FirstItem;
+		int m_NumItems;
+	};
+	std::vector<CSharedSnapEntity> m_vSharedSnapEntities;
+	int m_SharedSnapTick = -1;
+	void SnapShared();
 
 	class CGameContext *m_pGameServer;
 	class CConfig *m_pConfig;
@@ -55,6 +77,16 @@ public:
 
 	void SetGameServer(CGameContext *pGameServer);
 
+	/*
+		Function: InitEntityGrid
+			Sizes the spatial index for the map, see CEntityGrid.
+
+		Arguments:
+			Width - Width of the map in tiles.
+			Height - Height of the map in tiles.
+	*/
+	void InitEntityGrid(int Width, int Height);
+
 	CEntity *FindFirst(int Type);
 
 	/*
@@ -141,6 +173,17 @@ public:
 	*/
 	void RemoveEntity(CEntity *pEntity);
 
+	/*
+		Function: MoveEntity
+			Sets the position of an entity and keeps the spatial index
+			up to date. Characters and pickups must be moved with it.
+
+		Arguments:
+			pEntity - Entity to move
+			Pos - New position
+	*/
+	void MoveEntity(CEntity *pEntity, vec2 Pos);
+
 	void RemoveEntitiesFromPlayer(int PlayerId);
 	void RemoveEntitiesFromPlayers(int PlayerIds[], int NumPlayers);
 
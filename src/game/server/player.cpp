@@ -12,6 +12,7 @@
 #include <engine/antibot.h>
 #include <engine/server.h>
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 
 #include <game/gamecore.h>
 #include <game/teamscore.h>
@@ -931,6 +932,7 @@ void CPlayer::SetSpectatorId(int Id)
 
 void CPlayer::ProcessScoreResult(CScorePlayerResult &Result)
 {
+	CProfileScope Profile(Server()->TickProfiler(), CTickProfiler::SECTION_SQL_RESULTS);
 	if(Result.m_Success) // SQL request was successful
 	{
 		switch(Result.m_MessageKind)
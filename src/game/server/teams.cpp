@@ -9,6 +9,7 @@
 #include <base/system.h>
 
 #include <engine/shared/config.h>
+#include <engine/shared/profiler.h>
 
 #include <game/mapitems.h>
 #include <game/server/entities/character.h>
@@ -1013,6 +1014,7 @@ void CGameTeams::ProcessSaveTeam()
 	{
 		if(m_apSaveTeamResult[Team] == nullptr || !m_apSaveTeamResult[Team]->m_Completed)
 			continue;
+		CProfileScope Profile(Server()->TickProfiler(), CTickProfiler::SECTION_SQL_RESULTS);
 
 		int TeamSize = m_apSaveTeamResult[Team]->m_SavedTeam.GetMembersCount();
 		int State = -1;
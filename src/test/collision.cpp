@@ -0,0 +1,464 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/engine.h>
+#include <engine/kernel.h>
+#include <engine/map.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <game/collision.h>
+#include <game/layers.h>
+#include <game/mapitems.h>
+#include <game/version.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+static const char *const s_apMaps[] = {"coverage", "Tutorial", "Gold Mine"};
+
+class CCollisionMap
+{
+public:
+	CTestInfo m_TestInfo;
+	std::unique_ptr<IKernel> m_pKernel;
+	std::unique_ptr<IStorage> m_pStorage;
+	IEngineMap *m_pMap;
+	CLayers m_Layers;
+	CCollision m_Collision;
+
+	const CTile *m_pTiles = nullptr;
+	const CTile *m_pFront = nullptr;
+
+	CCollisionMap()
+	{
+		m_TestInfo.m_DeleteTestStorageFilesOnSuccess = true;
+	}
+
+	void Load(const char *pMap)
+	{
+		m_pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+		m_pStorage = m_TestInfo.CreateTestStorage();
+		ASSERT_NE(m_pStorage, nullptr);
+		m_pKernel->RegisterInterface(m_pStorage.get(), false);
+		m_pKernel->RegisterInterface(CreateTestEngine(GAME_NAME));
+		m_pMap = CreateEngineMap();
+		m_pKernel->RegisterInterface(m_pMap);
+
+		char aMap[IO_MAX_PATH_LENGTH];
+		str_format(aMap, sizeof(aMap), "maps/%s.map", pMap);
+		ASSERT_TRUE(m_pMap->Load(aMap));
+		m_Layers.Init(m_pMap, true);
+		m_Collision.Init(&m_Layers);
+		m_pTiles = m_Collision.GameLayer();
+		m_pFront = m_Collision.FrontLayer();
+	}
+
+	~CCollisionMap()
+	{
+		m_Collision.Unload();
+		m_pMap->Unload();
+	}
+
+	// the queries as they read the layers before the flags were precomputed
+	int RefTile(int Index) const
+	{
+		const int Tile = m_pTiles[Index].m_Index;
+		return Tile >= TILE_SOLID && Tile <= TILE_NOLASER ? Tile : 0;
+	}
+
+	int RefFrontTile(int Index) const
+	{
+		if(!m_pFront)
+			return 0;
+		const int Tile = m_pFront[Index].m_Index;
+		return Tile == TILE_DEATH || Tile == TILE_NOLASER ? Tile : 0;
+	}
+
+	static bool RefBlocksDir(const CTile &Tile, vec2 Pos0, vec2 Pos1)
+	{
+		return Tile.m_Index == TILE_THROUGH_DIR && ((Tile.m_Flags == ROTATION_0 && Pos0.y < Pos1.y) || (Tile.m_Flags == ROTATION_90 && Pos0.x > Pos1.x) || (Tile.m_Flags == ROTATION_180 && Pos0.y > Pos1.y) || (Tile.m_Flags == ROTATION_270 && Pos0.x < Pos1.x));
+	}
+
+	bool RefIsThrough(int x, int y, int OffsetX, int OffsetY, vec2 Pos0, vec2 Pos1) const
+	{
+		const int Index = m_Collision.GetPureMapIndex(x, y);
+		if(m_pFront && (m_pFront[Index].m_Index == TILE_THROUGH_ALL || m_pFront[Index].m_Index == TILE_THROUGH_CUT))
+			return true;
+		if(m_pFront && RefBlocksDir(m_pFront[Index], Pos1, Pos0))
+			return true;
+		const int OffsetIndex = m_Collision.GetPureMapIndex(x + OffsetX, y + OffsetY);
+		return m_pTiles[OffsetIndex].m_Index == TILE_THROUGH || (m_pFront && m_pFront[OffsetIndex].m_Index == TILE_THROUGH);
+	}
+
+	bool RefIsHookBlocker(int x, int y, vec2 Pos0, vec2 Pos1) const
+	{
+		const int Index = m_Collision.GetPureMapIndex(x, y);
+		if(m_pTiles[Index].m_Index == TILE_THROUGH_ALL || (m_pFront && m_pFront[Index].m_Index == TILE_THROUGH_ALL))
+			return true;
+		return RefBlocksDir(m_pTiles[Index], Pos0, Pos1) || (m_pFront && RefBlocksDir(m_pFront[Index], Pos0, Pos1));
+	}
+
+	static int RefStopper(bool Here, int Dir, const CTile &Tile)
+	{
+		const int Flags = Tile.m_Flags & (TILEFLAG_XFLIP | TILEFLAG_YFLIP | TILEFLAG_ROTATE);
+		int Result = 0;
+		if(Tile.m_Index == TILE_STOP)
+		{
+			if(Flags == ROTATION_0 || Flags == ((int)TILEFLAG_YFLIP ^ ROTATION_180))
+				Result = CANTMOVE_DOWN;
+			else if(Flags == ROTATION_90 || Flags == ((int)TILEFLAG_YFLIP ^ ROTATION_270))
+				Result = CANTMOVE_LEFT;
+			else if(Flags == ROTATION_180 || Flags == ((int)TILEFLAG_YFLIP ^ ROTATION_0))
+				Result = CANTMOVE_UP;
+			else if(Flags == ROTATION_270 || Flags == ((int)TILEFLAG_YFLIP ^ ROTATION_90))
+				Result = CANTMOVE_RIGHT;
+			if(Here)
+				return Result;
+		}
+		else if(Tile.m_Index == TILE_STOPS)
+			Result = Flags & TILEFLAG_ROTATE ? CANTMOVE_LEFT | CANTMOVE_RIGHT : CANTMOVE_DOWN | CANTMOVE_UP;
+		else if(Tile.m_Index == TILE_STOPA)
+			Result = CANTMOVE_LEFT | CANTMOVE_RIGHT | CANTMOVE_UP | CANTMOVE_DOWN;
+		return Here ? 0 : Result & Dir;
+	}
+
+	int RefMoveRestrictions(vec2 Pos, float Distance) const
+	{
+		const vec2 aDirections[] = {vec2(0, 0), vec2(1, 0), vec2(0, 1), vec2(-1, 0), vec2(0, -1)};
+		const int aMasks[] = {0, CANTMOVE_RIGHT, CANTMOVE_DOWN, CANTMOVE_LEFT, CANTMOVE_UP};
+		int Restrictions = 0;
+		for(int d = 0; d < 5; d++)
+		{
+			const int Index = m_Collision.GetPureMapIndex(Pos + aDirections[d] * Distance);
+			Restrictions |= RefStopper(d == 0, aMasks[d], m_pTiles[Index]);
+			if(m_pFront)
+				Restrictions |= RefStopper(d == 0, aMasks[d], m_pFront[Index]);
+		}
+		return Restrictions;
+	}
+
+	// the intersection functions as they sampled every unit of the line
+	int RefIntersectLine(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		int End(Distance + 1);
+		vec2 Last = Pos0;
+		for(int i = 0; i <= End; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, i / (float)End);
+			int ix = round_to_int(Pos.x);
+			int iy = round_to_int(Pos.y);
+			if(m_Collision.CheckPoint(ix, iy))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return m_Collision.GetCollisionAt(ix, iy);
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	int RefIntersectLineTeleHook(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		int End(Distance + 1);
+		vec2 Last = Pos0;
+		int dx = 0, dy = 0;
+		ThroughOffset(Pos0, Pos1, &dx, &dy);
+		for(int i = 0; i <= End; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, i / (float)End);
+			int ix = round_to_int(Pos.x);
+			int iy = round_to_int(Pos.y);
+			int Index = m_Collision.GetPureMapIndex(Pos);
+			*pTeleNr = g_Config.m_SvOldTeleportHook ? m_Collision.IsTeleport(Index) : m_Collision.IsTeleportHook(Index);
+			if(*pTeleNr)
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return TILE_TELEINHOOK;
+			}
+			int Hit = 0;
+			if(m_Collision.CheckPoint(ix, iy))
+			{
+				if(!m_Collision.IsThrough(ix, iy, dx, dy, Pos0, Pos1))
+					Hit = m_Collision.GetCollisionAt(ix, iy);
+			}
+			else if(m_Collision.IsHookBlocker(ix, iy, Pos0, Pos1))
+			{
+				Hit = TILE_NOHOOK;
+			}
+			if(Hit)
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return Hit;
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	int RefIntersectLineTeleWeapon(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision, int *pTeleNr) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		int End(Distance + 1);
+		vec2 Last = Pos0;
+		for(int i = 0; i <= End; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, i / (float)End);
+			int ix = round_to_int(Pos.x);
+			int iy = round_to_int(Pos.y);
+			int Index = m_Collision.GetPureMapIndex(Pos);
+			*pTeleNr = g_Config.m_SvOldTeleportWeapons ? m_Collision.IsTeleport(Index) : m_Collision.IsTeleportWeapon(Index);
+			if(*pTeleNr)
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return TILE_TELEINWEAPON;
+			}
+			if(m_Collision.CheckPoint(ix, iy))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				return m_Collision.GetCollisionAt(ix, iy);
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	int RefIntersectNoLaser(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		vec2 Last = Pos0;
+		const int DistanceRounded = std::ceil(Distance);
+		for(int i = 0; i < DistanceRounded; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, i / Distance);
+			int Nx = std::clamp(round_to_int(Pos.x) / 32, 0, m_Collision.GetWidth() - 1);
+			int Ny = std::clamp(round_to_int(Pos.y) / 32, 0, m_Collision.GetHeight() - 1);
+			const int Tile = m_Collision.GetIndex(Nx, Ny);
+			if(Tile == TILE_SOLID || Tile == TILE_NOHOOK || Tile == TILE_NOLASER || m_Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				if(m_Collision.GetFrontIndex(Nx, Ny) == TILE_NOLASER)
+					return m_Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+				return m_Collision.GetCollisionAt(Pos.x, Pos.y);
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	int RefIntersectNoLaserNoWalls(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		vec2 Last = Pos0;
+		const int DistanceRounded = std::ceil(Distance);
+		for(int i = 0; i < DistanceRounded; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, (float)i / Distance);
+			int ix = round_to_int(Pos.x);
+			int iy = round_to_int(Pos.y);
+			if(m_Collision.IsNoLaser(ix, iy) || m_Collision.IsFrontNoLaser(ix, iy))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				if(m_Collision.IsNoLaser(ix, iy))
+					return m_Collision.GetCollisionAt(Pos.x, Pos.y);
+				return m_Collision.GetFrontCollisionAt(Pos.x, Pos.y);
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	int RefIntersectAir(vec2 Pos0, vec2 Pos1, vec2 *pOutCollision, vec2 *pOutBeforeCollision) const
+	{
+		float Distance = distance(Pos0, Pos1);
+		vec2 Last = Pos0;
+		const int DistanceRounded = std::ceil(Distance);
+		for(int i = 0; i < DistanceRounded; i++)
+		{
+			vec2 Pos = mix(Pos0, Pos1, (float)i / Distance);
+			int ix = round_to_int(Pos.x);
+			int iy = round_to_int(Pos.y);
+			if(m_Collision.IsSolid(ix, iy) || (!m_Collision.GetTile(ix, iy) && !m_Collision.GetFrontTile(ix, iy)))
+			{
+				*pOutCollision = Pos;
+				*pOutBeforeCollision = Last;
+				if(!m_Collision.GetTile(ix, iy) && !m_Collision.GetFrontTile(ix, iy))
+					return -1;
+				else if(!m_Collision.GetTile(ix, iy))
+					return m_Collision.GetTile(ix, iy);
+				return m_Collision.GetFrontTile(ix, iy);
+			}
+			Last = Pos;
+		}
+		*pOutCollision = Pos1;
+		*pOutBeforeCollision = Pos1;
+		return 0;
+	}
+
+	// whether the queries near the tile read the same tile everywhere, the offsets and targets reach at most 3 tiles away
+	// and the edges of such areas are still checked
+	bool IsUniformArea(int x, int y) const
+	{
+		const int Index = y * m_Collision.GetWidth() + x;
+		for(int Ny = std::max(y - 3, 0); Ny <= std::min(y + 3, m_Collision.GetHeight() - 1); Ny++)
+		{
+			for(int Nx = std::max(x - 3, 0); Nx <= std::min(x + 3, m_Collision.GetWidth() - 1); Nx++)
+			{
+				const int Other = Ny * m_Collision.GetWidth() + Nx;
+				if(m_pTiles[Other].m_Index != m_pTiles[Index].m_Index || m_pTiles[Other].m_Flags != m_pTiles[Index].m_Flags)
+					return false;
+				if(m_pFront && (m_pFront[Other].m_Index != m_pFront[Index].m_Index || m_pFront[Other].m_Flags != m_pFront[Index].m_Flags))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void CheckTileQueries() const
+	{
+		const int Width = m_Collision.GetWidth();
+		const int Height = m_Collision.GetHeight();
+		const ivec2 aOffsets[] = {{0, 0}, {16, 16}, {31, 5}, {-40, 10}, {10, 1000000}};
+		for(int y = 0; y < Height; y++)
+		{
+			for(int x = 0; x < Width; x++)
+			{
+				if(IsUniformArea(x, y))
+					continue;
+				for(const ivec2 &Offset : aOffsets)
+				{
+					const int PosX = x * 32 + Offset.x;
+					const int PosY = y * 32 + Offset.y;
+					const int Index = m_Collision.GetPureMapIndex(PosX, PosY);
+					ASSERT_EQ(m_Collision.GetTile(PosX, PosY), RefTile(Index)) << PosX << " " << PosY;
+					ASSERT_EQ(m_Collision.GetFrontTile(PosX, PosY), RefFrontTile(Index)) << PosX << " " << PosY;
+					const vec2 Pos = vec2(PosX, PosY);
+					const vec2 aTargets[] = {Pos + vec2(100, 0), Pos + vec2(-100, 30), Pos + vec2(5, 100), Pos + vec2(-20, -100)};
+					for(const vec2 &Target : aTargets)
+					{
+						int dx, dy;
+						ThroughOffset(Pos, Target, &dx, &dy);
+						ASSERT_EQ(m_Collision.IsThrough(PosX, PosY, dx, dy, Pos, Target), RefIsThrough(PosX, PosY, dx, dy, Pos, Target)) << PosX << " " << PosY;
+						ASSERT_EQ(m_Collision.IsHookBlocker(PosX, PosY, Pos, Target), RefIsHookBlocker(PosX, PosY, Pos, Target)) << PosX << " " << PosY;
+					}
+					ASSERT_EQ(m_Collision.GetMoveRestrictions(Pos), RefMoveRestrictions(Pos, 18.0f)) << PosX << " " << PosY;
+					ASSERT_EQ(m_Collision.GetMoveRestrictions(Pos, 0.0f), RefMoveRestrictions(Pos, 0.0f)) << PosX << " " << PosY;
+				}
+			}
+		}
+	}
+};
+
+TEST(Collision, TileQueries)
+{
+	// every tile is checked, so leave out the large Tutorial map
+	for(const char *pMap : {"coverage", "Gold Mine"})
+	{
+		CCollisionMap Map;
+		Map.Load(pMap);
+		ASSERT_FALSE(::testing::Test::HasFatalFailure()) << pMap;
+		Map.CheckTileQueries();
+	}
+}
+
+TEST(Collision, IntersectLine)
+{
+	unsigned Seed = 1;
+	auto Random = [&Seed](float Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (Seed >> 8) % 100000 / 100000.0f * Max;
+	};
+
+	for(const char *pMap : s_apMaps)
+	{
+		CCollisionMap Map;
+		Map.Load(pMap);
+		ASSERT_FALSE(::testing::Test::HasFatalFailure()) << pMap;
+		const CCollision &Collision = Map.m_Collision;
+		const vec2 MapSize = vec2(Collision.GetWidth() * 32.0f, Collision.GetHeight() * 32.0f);
+
+		for(int i = 0; i < 2000; i++)
+		{
+			vec2 Pos0 = vec2(Random(MapSize.x + 400.0f) - 200.0f, Random(MapSize.y + 400.0f) - 200.0f);
+			vec2 Pos1 = Pos0 + vec2(Random(2000.0f) - 1000.0f, Random(2000.0f) - 1000.0f);
+			switch(i % 8)
+			{
+			case 0: Pos1.y = Pos0.y; break; // horizontal
+			case 1: Pos1.x = Pos0.x; break; // vertical
+			case 2: Pos1 = Pos0 + vec2(Pos1.x - Pos0.x, Pos1.x - Pos0.x); break; // diagonal through tile corners
+			case 3: Pos0 = vec2(round_to_int(Pos0.x / 32) * 32 - 0.5f, round_to_int(Pos0.y / 32) * 32 + 31.5f); break; // on the rounding border of a tile
+			case 4: Pos1 = Pos0 + vec2(Random(10.0f) - 5.0f, Random(10.0f) - 5.0f); break; // short
+			case 5: Pos1.y = Pos0.y + Random(2.0f) - 1.0f; break; // almost horizontal
+			}
+
+			vec2 Col, Before, RefCol, RefBefore;
+			int TeleNr, RefTeleNr;
+			ASSERT_EQ(Collision.IntersectLine(Pos0, Pos1, &Col, &Before), Map.RefIntersectLine(Pos0, Pos1, &RefCol, &RefBefore)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore) << pMap << " " << i;
+
+			g_Config.m_SvOldTeleportHook = i % 2;
+			g_Config.m_SvOldTeleportWeapons = i % 2;
+			ASSERT_EQ(Collision.IntersectLineTeleHook(Pos0, Pos1, &Col, &Before, &TeleNr), Map.RefIntersectLineTeleHook(Pos0, Pos1, &RefCol, &RefBefore, &RefTeleNr)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore && TeleNr == RefTeleNr) << pMap << " " << i;
+			ASSERT_EQ(Collision.IntersectLineTeleWeapon(Pos0, Pos1, &Col, &Before, &TeleNr), Map.RefIntersectLineTeleWeapon(Pos0, Pos1, &RefCol, &RefBefore, &RefTeleNr)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore && TeleNr == RefTeleNr) << pMap << " " << i;
+			ASSERT_EQ(Collision.IntersectNoLaser(Pos0, Pos1, &Col, &Before), Map.RefIntersectNoLaser(Pos0, Pos1, &RefCol, &RefBefore)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore) << pMap << " " << i;
+			ASSERT_EQ(Collision.IntersectNoLaserNoWalls(Pos0, Pos1, &Col, &Before), Map.RefIntersectNoLaserNoWalls(Pos0, Pos1, &RefCol, &RefBefore)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore) << pMap << " " << i;
+			ASSERT_EQ(Collision.IntersectAir(Pos0, Pos1, &Col, &Before), Map.RefIntersectAir(Pos0, Pos1, &RefCol, &RefBefore)) << pMap << " " << i;
+			ASSERT_TRUE(Col == RefCol && Before == RefBefore) << pMap << " " << i;
+		}
+	}
+	g_Config.m_SvOldTeleportHook = 0;
+	g_Config.m_SvOldTeleportWeapons = 0;
+}
+
+TEST(Collision, SetCollisionAt)
+{
+	CCollisionMap Map;
+	Map.Load("coverage");
+	ASSERT_FALSE(::testing::Test::HasFatalFailure());
+	CCollision &Collision = Map.m_Collision;
+
+	const vec2 Pos = vec2(Collision.GetWidth() / 2 * 32 + 16, Collision.GetHeight() / 2 * 32 + 16);
+	Collision.SetCollisionAt(Pos.x, Pos.y, TILE_SOLID);
+	EXPECT_TRUE(Collision.CheckPoint(Pos));
+	EXPECT_EQ(Collision.GetCollisionAt(Pos.x, Pos.y), TILE_SOLID);
+	Collision.SetCollisionAt(Pos.x, Pos.y, TILE_NOLASER);
+	EXPECT_FALSE(Collision.CheckPoint(Pos));
+	EXPECT_EQ(Collision.GetCollisionAt(Pos.x, Pos.y), TILE_NOLASER);
+	Collision.SetCollisionAt(Pos.x, Pos.y, TILE_AIR);
+	EXPECT_FALSE(Collision.CheckPoint(Pos));
+	EXPECT_EQ(Collision.GetCollisionAt(Pos.x, Pos.y), TILE_AIR);
+
+	const vec2 Below = Pos + vec2(0, 32);
+	Collision.SetCollisionAt(Pos.x, Pos.y, TILE_THROUGH_ALL);
+	EXPECT_TRUE(Collision.IsHookBlocker(Pos.x, Pos.y, Below, Pos));
+	Collision.SetCollisionAt(Pos.x, Pos.y, TILE_THROUGH);
+	EXPECT_FALSE(Collision.IsHookBlocker(Pos.x, Pos.y, Below, Pos));
+	EXPECT_TRUE(Collision.IsThrough(Below.x, Below.y, 0, -32, Pos, Below));
+}
@@ -0,0 +1,263 @@
+#include <base/system.h>
+
+#include <game/client/components/tclient/conditional_parser.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+class CTestResult : public IConsole::IResult
+{
+public:
+	char m_aaArgs[4][8];
+
+	CTestResult() :
+		IResult(-1)
+	{
+		m_NumArgs = std::size(m_aaArgs);
+		for(int i = 0; i < (int)std::size(m_aaArgs); i++)
+			str_format(m_aaArgs[i], sizeof(m_aaArgs[i]), "arg%d", i);
+	}
+	int GetInteger(unsigned Index) const override { return 0; }
+	float GetFloat(unsigned Index) const override { return 0.0f; }
+	const char *GetString(unsigned Index) const override { return Index < m_NumArgs ? m_aaArgs[Index] : ""; }
+	std::optional<ColorHSLA> GetColor(unsigned Index, float DarkestLighting) const override { return std::nullopt; }
+	void RemoveArgument(unsigned Index) override {}
+	int GetVictim() const override { return -1; }
+};
+
+class CTestParser : public CConditionalParser
+{
+public:
+	// set when the reference wrote past the buffer, its result is undefined then
+	bool m_RefOverflow = false;
+
+	CTestParser()
+	{
+		m_vVariables.emplace_back("a", [](char *pOut, int Length) {
+			return str_copy(pOut, "x", Length);
+		});
+		m_vVariables.emplace_back("empty", [](char *pOut, int Length) {
+			return str_copy(pOut, "", Length);
+		});
+		m_vVariables.emplace_back("brackets", [](char *pOut, int Length) {
+			return str_copy(pOut, "{a}\\", Length);
+		});
+		m_vVariables.emplace_back("long", [](char *pOut, int Length) {
+			return str_copy(pOut, "0123456789012345678901234567890123456789", Length);
+		});
+		m_vFunctions.emplace_back("echo", [](const char *pParam, char *pOut, int Length) {
+			return str_copy(pOut, pParam, Length);
+		});
+		m_vFunctions.emplace_back("len", [](const char *pParam, char *pOut, int Length) {
+			return str_format(pOut, Length, "%d", str_length(pParam));
+		});
+		m_vFunctions.emplace_back("wrap", [](const char *pParam, char *pOut, int Length) {
+			return str_format(pOut, Length, "{%s}", pParam);
+		});
+		ClearPrograms();
+	}
+
+	// ParseValue and ParseString as they substituted the innermost expression in place
+	int RefParseValue(char *pBuf, int Length)
+	{
+		const char *pFirstSpace = nullptr;
+		for(const char *p = pBuf; *p != '\0'; ++p)
+		{
+			if(*p == ' ')
+			{
+				pFirstSpace = p;
+				break;
+			}
+		}
+		if(pFirstSpace && *(pFirstSpace + 1) != '\0')
+		{
+			const int FuncLength = pFirstSpace - pBuf;
+			char aParam[256];
+			str_copy(aParam, pFirstSpace + 1);
+			RefParseString(aParam, sizeof(aParam));
+			for(const auto &[Key, FFunc] : m_vFunctions)
+				if(str_comp_nocase_num(pBuf, Key.c_str(), FuncLength) == 0)
+					return FFunc(aParam, pBuf, Length);
+		}
+		else
+		{
+			if(m_pResult)
+			{
+				int Index;
+				if(str_toint(pBuf, &Index))
+				{
+					if(Index >= 0)
+						return str_copy(pBuf, m_pResult->GetString(Index), Length);
+					else
+						return str_copy(pBuf, "", Length);
+				}
+			}
+			for(const auto &[Key, FFunc] : m_vVariables)
+				if(str_comp_nocase(pBuf, Key.c_str()) == 0)
+					return FFunc(pBuf, Length);
+		}
+		return -1;
+	}
+
+	void RefParseString(char *pBuf, int Length)
+	{
+		if(!pBuf || Length <= 0)
+			return;
+		bool HasBrackets = false;
+		for(const char *p = pBuf; *p != '\0'; ++p)
+			if(*p == '{' || *p == '}')
+				HasBrackets = true;
+		if(!HasBrackets)
+			return;
+
+		int Len = strnlen(pBuf, Length);
+		while(true)
+		{
+			int LastOpen = -1;
+			int ClosePos = -1;
+			for(int i = 0; i < Len; ++i)
+			{
+				if(pBuf[i] != '{' && pBuf[i] != '}')
+					continue;
+				int BackslashCount = 0;
+				for(int j = i - 1; j >= 0 && pBuf[j] == '\\'; --j)
+					BackslashCount++;
+				if(BackslashCount % 2 != 0)
+					continue;
+				if(pBuf[i] == '{')
+				{
+					LastOpen = i;
+				}
+				else if(pBuf[i] == '}' && LastOpen != -1)
+				{
+					ClosePos = i;
+					break;
+				}
+			}
+
+			if(LastOpen == -1 || ClosePos <= LastOpen)
+				break;
+
+			int ExprLen = ClosePos - LastOpen - 1;
+
+			char aTemp[512];
+			int CopyLen = std::min(ExprLen, (int)sizeof(aTemp) - 1);
+			mem_copy(aTemp, pBuf + LastOpen + 1, CopyLen);
+			aTemp[CopyLen] = '\0';
+
+			int ResultLen = RefParseValue(aTemp, sizeof(aTemp));
+			if(ResultLen == -1)
+			{
+				if(Len + 2 >= Length)
+					break;
+				mem_move(pBuf + ClosePos + 1, pBuf + ClosePos, Len - ClosePos + 1);
+				pBuf[ClosePos] = '\\';
+				Len++;
+				mem_move(pBuf + LastOpen + 1, pBuf + LastOpen, Len - LastOpen + 1);
+				pBuf[LastOpen] = '\\';
+				Len++;
+			}
+			else
+			{
+				for(const char *p = aTemp; *p != '\0'; ++p)
+					if(*p == '{' || *p == '}' || *p == '\\')
+						ResultLen++;
+				if(Len - (ClosePos - LastOpen + 1) + ResultLen >= Length)
+				{
+					m_RefOverflow = true;
+					return;
+				}
+				mem_move(pBuf + LastOpen + ResultLen, pBuf + ClosePos + 1, Len - ClosePos);
+				EscapeString(aTemp, pBuf + LastOpen, Length - LastOpen);
+				Len -= ClosePos - LastOpen + 1;
+				Len += ResultLen;
+				pBuf[Len] = '\0';
+			}
+		}
+		UnescapeString(pBuf, Length);
+	}
+};
+
+static void ExpectSameAsReference(CTestParser &Parser, const char *pInput, int Length)
+{
+	char aBuf[1024];
+	char aRef[1024];
+	ASSERT_LE(Length, (int)sizeof(aBuf));
+	str_copy(aBuf, pInput, Length);
+	str_copy(aRef, pInput, Length);
+	Parser.m_RefOverflow = false;
+	Parser.RefParseString(aRef, Length);
+	if(Parser.m_RefOverflow)
+		return;
+	Parser.ParseString(aBuf, Length);
+	EXPECT_STREQ(aBuf, aRef) << "input '" << pInput << "' length " << Length;
+}
+
+TEST(Conditional, Substitute)
+{
+	CTestParser Parser;
+	char aBuf[256];
+
+	str_copy(aBuf, "{a} {A} {empty}|{echo hello} {len abc} {unknown}");
+	Parser.ParseString(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "x x |hello 3 {unknown}");
+
+	str_copy(aBuf, "{echo {a}{a}} {len {long}} \\{a\\} {brackets}");
+	Parser.ParseString(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "xx 40 {a} {a}\\");
+
+	CTestResult Result;
+	Parser.m_pResult = &Result;
+	str_copy(aBuf, "{0} {3} {-1} {a}");
+	Parser.ParseString(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "arg0 arg3  x");
+	Parser.m_pResult = nullptr;
+	str_copy(aBuf, "{0} {a}");
+	Parser.ParseString(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "{0} x");
+}
+
+TEST(Conditional, DeepNesting)
+{
+	CTestParser Parser;
+	std::string Input;
+	for(int i = 0; i < 40; i++)
+		Input += "{echo ";
+	Input += "{a}";
+	for(int i = 0; i < 40; i++)
+		Input += "}";
+	ExpectSameAsReference(Parser, Input.c_str(), 1024);
+
+	char aBuf[1024];
+	str_copy(aBuf, Input.c_str());
+	Parser.ParseString(aBuf, sizeof(aBuf));
+	EXPECT_STREQ(aBuf, "x");
+}
+
+TEST(Conditional, CompareReference)
+{
+	static const char *const s_apParts[] = {"{", "{", "{", "}", "}", "}", "\\", "\\{", "\\}", " ", "a", "A", "x", "empty", "brackets", "long", "echo ", "len ", "wrap ", "ECHO ", "unknown", "0", "2", "-1", "{a}", "{echo ", "{len "};
+	static const int s_aLengths[] = {8, 16, 24, 32, 64, 256, 1024};
+
+	CTestParser Parser;
+	CTestResult Result;
+	unsigned Seed = 1;
+	auto Random = [&Seed](int Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (int)((Seed >> 8) % Max);
+	};
+	// more distinct strings than the program cache holds, so it is dropped in between
+	for(int i = 0; i < 20000; i++)
+	{
+		std::string Input;
+		const int NumParts = 1 + Random(16);
+		for(int Part = 0; Part < NumParts; Part++)
+			Input += s_apParts[Random(std::size(s_apParts))];
+		Parser.m_pResult = i % 2 ? &Result : nullptr;
+		ExpectSameAsReference(Parser, Input.c_str(), s_aLengths[Random(std::size(s_aLengths))]);
+		if(::testing::Test::HasFailure())
+			break;
+	}
+}
@@ -0,0 +1,122 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/console.h>
+#include <engine/kernel.h>
+#include <engine/shared/config.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+static void CountCallback(IConsole::IResult *pResult, void *pUserData)
+{
+	(*static_cast<int *>(pUserData))++;
+}
+
+TEST(Console, FindCommand)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	int Lower = 0, Client = 0;
+	pConsole->Register("find_me", "", CFGFLAG_SERVER, CountCallback, &Lower, "");
+	pConsole->Register("client_only", "", CFGFLAG_CLIENT, CountCallback, &Client, "");
+
+	pConsole->ExecuteLine("find_me");
+	pConsole->ExecuteLine("FIND_ME; Find_Me");
+	pConsole->ExecuteLine("client_only");
+	EXPECT_EQ(Lower, 3);
+	EXPECT_EQ(Client, 0);
+	pConsole->ExecuteLineFlag("client_only", CFGFLAG_CLIENT);
+	EXPECT_EQ(Client, 1);
+
+	// registering again replaces the callback
+	int Replaced = 0;
+	pConsole->Register("find_me", "", CFGFLAG_SERVER, CountCallback, &Replaced, "");
+	pConsole->ExecuteLine("find_me");
+	EXPECT_EQ(Lower, 3);
+	EXPECT_EQ(Replaced, 1);
+
+	EXPECT_NE(pConsole->GetCommandInfo("FIND_ME", CFGFLAG_SERVER, false), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("find_me", CFGFLAG_CLIENT, false), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("find_me", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("find_m", CFGFLAG_SERVER, false), nullptr);
+}
+
+TEST(Console, TempCommands)
+{
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	pConsole->RegisterTemp("temp_a", "", CFGFLAG_SERVER, "first");
+	pConsole->RegisterTemp("temp_b", "", CFGFLAG_SERVER, "second");
+	ASSERT_NE(pConsole->GetCommandInfo("TEMP_A", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true)->Help(), "second");
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, false), nullptr);
+
+	pConsole->DeregisterTemp("temp_a");
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+
+	// reuses the removed command
+	pConsole->RegisterTemp("temp_c", "", CFGFLAG_SERVER, "third");
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_STREQ(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true)->Help(), "third");
+
+	pConsole->DeregisterTempAll();
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_b", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_EQ(pConsole->GetCommandInfo("temp_c", CFGFLAG_SERVER, true), nullptr);
+	EXPECT_NE(pConsole->GetCommandInfo("echo", CFGFLAG_SERVER, false), nullptr);
+
+	pConsole->RegisterTemp("temp_a", "", CFGFLAG_SERVER, "again");
+	EXPECT_STREQ(pConsole->GetCommandInfo("temp_a", CFGFLAG_SERVER, true)->Help(), "again");
+}
+
+TEST(Console, ExecuteLargeFile)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	std::unique_ptr<IKernel> pKernel = std::unique_ptr<IKernel>(IKernel::Create());
+	pKernel->RegisterInterface(pStorage.get(), false);
+	std::unique_ptr<IConsole> pConsole = CreateConsole(CFGFLAG_SERVER);
+	pKernel->RegisterInterface(pConsole.get(), false);
+	pConsole->Init();
+
+	// about as many commands and lines as a big settings file with binds
+	static const int NUM_COMMANDS = 2000;
+	static const int NUM_LINES = 50000;
+	static char s_aaNames[NUM_COMMANDS][32];
+	int aCalls[NUM_COMMANDS] = {0};
+	for(int i = 0; i < NUM_COMMANDS; i++)
+	{
+		str_format(s_aaNames[i], sizeof(s_aaNames[i]), "tc_setting_%d", i);
+		pConsole->Register(s_aaNames[i], "?i[value]", CFGFLAG_SERVER, CountCallback, &aCalls[i], "");
+	}
+
+	IOHANDLE File = pStorage->OpenFile("large.cfg", IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	for(int i = 0; i < NUM_LINES; i++)
+	{
+		char aLine[64];
+		str_format(aLine, sizeof(aLine), "%s %d", s_aaNames[i * 7 % NUM_COMMANDS], i);
+		if(i % 3 == 0)
+		{
+			for(char *pChar = aLine; *pChar; pChar++)
+				*pChar = str_uppercase(*pChar);
+		}
+		io_write(File, aLine, str_length(aLine));
+		io_write_newline(File);
+	}
+	io_close(File);
+
+	EXPECT_TRUE(pConsole->ExecuteFile("large.cfg", IConsole::CLIENT_ID_UNSPECIFIED, true, IStorage::TYPE_SAVE));
+
+	int Total = 0;
+	for(int Calls : aCalls)
+		Total += Calls;
+	EXPECT_EQ(Total, NUM_LINES);
+	EXPECT_EQ(aCalls[0], NUM_LINES / NUM_COMMANDS);
+
+	pStorage->RemoveFile("large.cfg", IStorage::TYPE_SAVE);
+}
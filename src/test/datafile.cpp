@@ -1,9 +1,13 @@
 #include "test.h"
 
+#include <base/system.h>
+
+#include <engine/engine.h>
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
 #include <game/mapitems_ex.h>
+#include <game/version.h>
 
 #include <gtest/gtest.h>
 
@@ -112,3 +116,122 @@ TEST(Datafile, StringData)
 		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
 	}
 }
+
+TEST(Datafile, Mapped)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+
+	CTestInfo Info;
+
+	int aData[4096];
+	for(int i = 0; i < (int)std::size(aData); i++)
+	{
+		aData[i] = i * i;
+	}
+
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+
+		EXPECT_EQ(Writer.AddDataString("Abc"), 0);
+		EXPECT_EQ(Writer.AddDataSwapped(sizeof(aData), aData), 1);
+		EXPECT_EQ(Writer.AddData(sizeof(aData), aData, CDataFileWriter::COMPRESSION_BEST), 2);
+
+		Writer.Finish();
+	}
+
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL));
+		CDataFileReader MappedReader;
+		ASSERT_TRUE(MappedReader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, true));
+
+		EXPECT_EQ(MappedReader.Sha256(), Reader.Sha256());
+		EXPECT_EQ(MappedReader.Crc(), Reader.Crc());
+		EXPECT_EQ(MappedReader.MapSize(), Reader.MapSize());
+		ASSERT_EQ(MappedReader.NumData(), 3);
+
+		EXPECT_STREQ(MappedReader.GetDataString(0), "Abc");
+		for(int Index = 1; Index < MappedReader.NumData(); Index++)
+		{
+			ASSERT_EQ(MappedReader.GetDataSize(Index), (int)sizeof(aData));
+			const void *pData = Index == 1 ? MappedReader.GetDataSwapped(Index) : MappedReader.GetData(Index);
+			ASSERT_NE(pData, nullptr);
+			EXPECT_EQ(mem_comp(pData, aData, sizeof(aData)), 0);
+		}
+
+		// unloaded data is inflated from the mapping again
+		MappedReader.UnloadData(2);
+		const void *pData = MappedReader.GetData(2);
+		ASSERT_NE(pData, nullptr);
+		EXPECT_EQ(mem_comp(pData, aData, sizeof(aData)), 0);
+
+		MappedReader.Close();
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
+
+TEST(Datafile, LoadData)
+{
+	std::unique_ptr<IStorage> pStorage = CreateLocalStorage();
+	ASSERT_NE(pStorage, nullptr) << "Error creating local storage";
+	std::unique_ptr<IEngine> pEngine = std::unique_ptr<IEngine>(CreateTestEngine(GAME_NAME));
+
+	CTestInfo Info;
+
+	int aaData[32][1024];
+	{
+		CDataFileWriter Writer;
+		ASSERT_TRUE(Writer.Open(pStorage.get(), Info.m_aFilename));
+		for(int Index = 0; Index < (int)std::size(aaData); Index++)
+		{
+			for(int i = 0; i < (int)std::size(aaData[Index]); i++)
+			{
+				aaData[Index][i] = Index * i;
+			}
+			EXPECT_EQ(Writer.AddData(sizeof(aaData[Index]), aaData[Index]), Index);
+		}
+		Writer.Finish();
+	}
+
+	for(bool Mapped : {false, true})
+	{
+		CDataFileReader Reader;
+		ASSERT_TRUE(Reader.Open(pStorage.get(), Info.m_aFilename, IStorage::TYPE_ALL, Mapped));
+
+		// invalid and duplicate indices are ignored
+		std::vector<int> vIndices = {-1, 1000};
+		for(int Index = 0; Index < Reader.NumData(); Index++)
+		{
+			vIndices.push_back(Index);
+			vIndices.push_back(Index);
+		}
+		Reader.LoadData(pEngine.get(), vIndices);
+
+		for(int Index = 0; Index < Reader.NumData(); Index++)
+		{
+			ASSERT_EQ(Reader.GetDataSize(Index), (int)sizeof(aaData[Index]));
+			const void *pData = Reader.GetData(Index);
+			ASSERT_NE(pData, nullptr);
+			EXPECT_EQ(mem_comp(pData, aaData[Index], sizeof(aaData[Index])), 0);
+		}
+
+		// already loaded data is kept
+		const void *pData = Reader.GetData(0);
+		Reader.LoadData(pEngine.get(), {0});
+		EXPECT_EQ(Reader.GetData(0), pData);
+
+		Reader.Close();
+	}
+
+	if(!HasFailure())
+	{
+		pStorage->RemoveFile(Info.m_aFilename, IStorage::TYPE_SAVE);
+	}
+}
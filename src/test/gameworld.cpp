@@ -241,7 +241,7 @@ TEST_F(CTestGameWorld, IntersectEntity)
 
 	vec2 CloserToFromButTooFarFromLine = vec2(11, 11 + Radius + pChrLeft->GetProximityRadius());
 	pChrLeft->SetPosition(CloserToFromButTooFarFromLine);
-	pChrLeft->m_Pos = CloserToFromButTooFarFromLine;
+	GameServer()->m_World.MoveEntity(pChrLeft, CloserToFromButTooFarFromLine);
 
 	pIntersectedChar = (CCharacter *)GameServer()->m_World.IntersectEntity(
 		vec2(10, 10), // intersect from
@@ -255,6 +255,81 @@ TEST_F(CTestGameWorld, IntersectEntity)
 	EXPECT_EQ(pIntersectedChar, pChrRight);
 }
 
+TEST_F(CTestGameWorld, EntityGrid)
+{
+	CGameWorld &World = GameServer()->m_World;
+	const vec2 MapSize = vec2(GameServer()->Collision()->GetWidth(), GameServer()->Collision()->GetHeight()) * 32.0f;
+	unsigned Seed = 1;
+	auto Random = [&Seed](float Max) {
+		Seed = Seed * 1103515245 + 12345;
+		return (Seed >> 8) % 100000 / 100000.0f * Max;
+	};
+	// also place some characters outside of the map and several in the same spot
+	auto RandomPos = [&]() {
+		return vec2(Random(MapSize.x + 2000.0f) - 1000.0f, Random(MapSize.y + 2000.0f) - 1000.0f);
+	};
+
+	CNetObj_PlayerInput Input = {};
+	std::vector<CCharacter *> vpCharacters;
+	for(int i = 0; i < MAX_CLIENTS; i++)
+	{
+		CCharacter *pChr = new(i) CCharacter(&World, Input);
+		pChr->m_Pos = i % 16 == 0 ? vec2(500.0f, 500.0f) : RandomPos();
+		World.InsertEntity(pChr);
+		vpCharacters.push_back(pChr);
+	}
+
+	for(int Round = 0; Round < 4; Round++)
+	{
+		for(int Query = 0; Query < 200; Query++)
+		{
+			const vec2 Pos = RandomPos();
+			const float Radius = Random(1000.0f);
+
+			// same as a scan over the entity list, including the order
+			std::vector<CEntity *> vpExpected;
+			for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+				if(distance(pEnt->m_Pos, Pos) < Radius + pEnt->GetProximityRadius())
+					vpExpected.push_back(pEnt);
+			CEntity *apEnts[MAX_CLIENTS];
+			const int Num = World.FindEntities(Pos, Radius, apEnts, std::size(apEnts), CGameWorld::ENTTYPE_CHARACTER);
+			ASSERT_EQ(Num, (int)vpExpected.size());
+			for(int i = 0; i < Num; i++)
+				EXPECT_EQ(apEnts[i], vpExpected[i]);
+
+			const vec2 To = Pos + vec2(Random(1600.0f) - 800.0f, Random(1600.0f) - 800.0f);
+			CCharacter *pExpected = nullptr;
+			float ClosestLen = distance(Pos, To) * 100.0f;
+			for(CEntity *pEnt = World.FindFirst(CGameWorld::ENTTYPE_CHARACTER); pEnt; pEnt = pEnt->TypeNext())
+			{
+				vec2 IntersectPos;
+				if(closest_point_on_line(Pos, To, pEnt->m_Pos, IntersectPos) && distance(pEnt->m_Pos, IntersectPos) < pEnt->GetProximityRadius() + 6.0f && distance(Pos, IntersectPos) < ClosestLen)
+				{
+					ClosestLen = distance(Pos, IntersectPos);
+					pExpected = (CCharacter *)pEnt;
+				}
+			}
+			vec2 NewPos;
+			EXPECT_EQ(World.IntersectCharacter(Pos, To, 6.0f, NewPos), pExpected);
+		}
+
+		// move some characters around, remove and insert others again
+		for(int i = 0; i < MAX_CLIENTS; i++)
+		{
+			if(i % 3 == Round % 3)
+				World.MoveEntity(vpCharacters[i], RandomPos());
+			else if(i % 5 == Round)
+			{
+				World.RemoveEntity(vpCharacters[i]);
+				World.InsertEntity(vpCharacters[i]);
+			}
+		}
+	}
+
+	for(CCharacter *pChr : vpCharacters)
+		delete pChr;
+}
+
 TEST_F(CTestGameWorld, BasicTick)
 {
 	int ClientId = 0;
@@ -47,3 +47,59 @@ TEST(Huffman, CompressionCompatible)
 	EXPECT_EQ(match, 0) << "The compression is not compatible with older/other implementations anymore";
 	EXPECT_EQ(Size, 15);
 }
+
+TEST(Huffman, DecompressKnownData)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	const unsigned char aCompressed[] = {0x51, 0x58, 0x78, 0x76, 0x1B, 0xB7, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F, 0xc5, 0x0D};
+	unsigned char aExpected[64] = {0};
+	for(int i = 0; i < 8; i++)
+		aExpected[i] = i;
+
+	unsigned char aDecompressed[2048];
+	int Size = Huffman.Decompress(aCompressed, sizeof(aCompressed), aDecompressed, sizeof(aDecompressed));
+	ASSERT_EQ(Size, (int)sizeof(aExpected));
+	EXPECT_EQ(mem_comp(aDecompressed, aExpected, sizeof(aExpected)), 0);
+}
+
+TEST(Huffman, RoundTrip)
+{
+	CHuffman Huffman;
+	Huffman.Init();
+
+	unsigned char aInput[1400];
+	unsigned char aCompressed[4096];
+	unsigned char aDecompressed[2048];
+
+	// mostly zeros like snapshot deltas, small values and all byte values,
+	// at sizes hitting both the word wise and the byte wise paths
+	unsigned Seed = 1;
+	for(int Mode = 0; Mode < 3; Mode++)
+	{
+		for(int InputSize : {0, 1, 7, 8, 9, 63, 64, 65, 500, 1400})
+		{
+			for(int i = 0; i < InputSize; i++)
+			{
+				Seed = Seed * 1103515245 + 12345;
+				const unsigned char Random = Seed >> 16;
+				aInput[i] = Mode == 0 ? (Random % 8 == 0 ? Random : 0) : Mode == 1 ? Random % 16 : Random;
+			}
+
+			const int Size = Huffman.Compress(aInput, InputSize, aCompressed, sizeof(aCompressed));
+			ASSERT_GT(Size, 0);
+			EXPECT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, sizeof(aDecompressed)), InputSize);
+			EXPECT_EQ(mem_comp(aDecompressed, aInput, InputSize), 0);
+
+			// the output buffers have to fit exactly
+			EXPECT_EQ(Huffman.Compress(aInput, InputSize, aCompressed, Size), Size);
+			EXPECT_EQ(Huffman.Compress(aInput, InputSize, aCompressed, Size - 1), -1);
+			EXPECT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, InputSize), InputSize);
+			if(InputSize > 0)
+			{
+				EXPECT_EQ(Huffman.Decompress(aCompressed, Size, aDecompressed, InputSize - 1), -1);
+			}
+		}
+	}
+}
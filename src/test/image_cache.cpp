@@ -0,0 +1,77 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/gfx/image_cache.h>
+#include <engine/storage.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+static CImageInfo CreateImage(size_t Width, size_t Height, CImageInfo::EImageFormat Format, uint8_t Seed)
+{
+	CImageInfo Image;
+	Image.m_Width = Width;
+	Image.m_Height = Height;
+	Image.m_Format = Format;
+	Image.m_pData = static_cast<uint8_t *>(malloc(Image.DataSize()));
+	for(size_t i = 0; i < Image.DataSize(); i++)
+		Image.m_pData[i] = Seed + i;
+	return Image;
+}
+
+TEST(ImageCache, RoundTrip)
+{
+	CTestInfo Info;
+	Info.m_DeleteTestStorageFilesOnSuccess = true;
+	std::unique_ptr<IStorage> pStorage = Info.CreateTestStorage();
+	ASSERT_NE(pStorage, nullptr);
+	ASSERT_TRUE(pStorage->CreateFolder("cache", IStorage::TYPE_SAVE));
+
+	const SHA256_DIGEST Sha256 = sha256("skin", 4);
+	CImageInfo aImages[2] = {CreateImage(3, 2, CImageInfo::FORMAT_RGBA, 1), CreateImage(5, 1, CImageInfo::FORMAT_R, 7)};
+	const int Extra = 1234;
+
+	CImageCache Cache(pStorage.get(), "cache", 1);
+	CImageInfo aLoaded[2];
+	int LoadedExtra = 0;
+	EXPECT_FALSE(Cache.Load(Sha256, aLoaded, std::size(aLoaded), &LoadedExtra, sizeof(LoadedExtra)));
+	ASSERT_TRUE(Cache.Save(Sha256, aImages, std::size(aImages), &Extra, sizeof(Extra)));
+
+	ASSERT_TRUE(Cache.Load(Sha256, aLoaded, std::size(aLoaded), &LoadedExtra, sizeof(LoadedExtra)));
+	EXPECT_EQ(LoadedExtra, Extra);
+	for(size_t i = 0; i < std::size(aImages); i++)
+	{
+		EXPECT_EQ(aLoaded[i].m_Width, aImages[i].m_Width);
+		EXPECT_EQ(aLoaded[i].m_Height, aImages[i].m_Height);
+		EXPECT_EQ(aLoaded[i].m_Format, aImages[i].m_Format);
+		ASSERT_EQ(aLoaded[i].DataSize(), aImages[i].DataSize());
+		EXPECT_EQ(mem_comp(aLoaded[i].m_pData, aImages[i].m_pData, aImages[i].DataSize()), 0);
+		aLoaded[i].Free();
+	}
+
+	// other processing versions and layouts do not match
+	CImageCache OtherVersion(pStorage.get(), "cache", 2);
+	EXPECT_FALSE(OtherVersion.Load(Sha256, aLoaded, std::size(aLoaded), &LoadedExtra, sizeof(LoadedExtra)));
+	EXPECT_FALSE(Cache.Load(Sha256, aLoaded, 1, &LoadedExtra, sizeof(LoadedExtra)));
+	EXPECT_FALSE(Cache.Load(Sha256, aLoaded, std::size(aLoaded), nullptr, 0));
+
+	// truncated entries are rejected
+	char aSha256[SHA256_MAXSTRSIZE];
+	sha256_str(Sha256, aSha256, sizeof(aSha256));
+	char aPath[IO_MAX_PATH_LENGTH];
+	str_format(aPath, sizeof(aPath), "cache/%s_1.raw", aSha256);
+	void *pData;
+	unsigned Size;
+	ASSERT_TRUE(pStorage->ReadFile(aPath, IStorage::TYPE_SAVE, &pData, &Size));
+	IOHANDLE File = pStorage->OpenFile(aPath, IOFLAG_WRITE, IStorage::TYPE_SAVE);
+	ASSERT_TRUE(File);
+	io_write(File, pData, Size - 1);
+	io_close(File);
+	free(pData);
+	EXPECT_FALSE(Cache.Load(Sha256, aLoaded, std::size(aLoaded), &LoadedExtra, sizeof(LoadedExtra)));
+
+	for(CImageInfo &Image : aImages)
+		Image.Free();
+}
@@ -41,6 +41,27 @@ TEST(Io, Read4)
 	TestFileRead("\xef\xbb\xbfxyz");
 }
 
+TEST(Io, Map)
+{
+	CTestInfo Info;
+	const char aWritten[] = "mapped file contents";
+
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_write(File, aWritten, sizeof(aWritten)), sizeof(aWritten));
+	EXPECT_FALSE(io_close(File));
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	EXPECT_EQ(io_map(File, 0), nullptr);
+	const void *pData = io_map(File, sizeof(aWritten));
+	ASSERT_NE(pData, nullptr);
+	EXPECT_EQ(mem_comp(pData, aWritten, sizeof(aWritten)), 0);
+	io_unmap(pData, sizeof(aWritten));
+	EXPECT_FALSE(io_close(File));
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
+
 static void TestFileLength(const char *pWritten)
 {
 	const int WrittenLength = str_length(pWritten);
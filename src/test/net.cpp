@@ -1,8 +1,11 @@
 #include <base/system.h>
 
+#include <engine/shared/network.h>
+
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <memory>
 
 using namespace std::chrono_literals;
 
@@ -52,3 +55,85 @@ TEST(Net, Ipv4AndIpv6Work)
 	net_udp_close(Socket1);
 	net_udp_close(Socket2);
 }
+
+TEST(Net, BatchedSend)
+{
+	NETADDR Bindaddr = {};
+	NETSOCKET Socket1;
+	NETSOCKET Socket2;
+
+	Bindaddr.type = NETTYPE_IPV4;
+	Socket2 = net_udp_create(Bindaddr);
+	do
+	{
+		Bindaddr.port = secure_rand() % 64511 + 1024;
+	} while(!(Socket1 = net_udp_create(Bindaddr)));
+
+	NETADDR Target;
+	ASSERT_FALSE(net_addr_from_str(&Target, "127.0.0.1"));
+	Target.port = Bindaddr.port;
+
+	// more packets than fit into a single system call
+	const int NumPackets = 200;
+	NETSTATS StatsBefore;
+	net_stats(&StatsBefore);
+	net_udp_begin_batch(Socket2);
+	for(int i = 0; i < NumPackets; i++)
+	{
+		EXPECT_EQ(net_udp_send(Socket2, &Target, &i, sizeof(i)), (int)sizeof(i));
+	}
+	net_udp_end_batch(Socket2);
+#if defined(CONF_PLATFORM_LINUX)
+	NETSTATS StatsAfter;
+	net_stats(&StatsAfter);
+	EXPECT_LT(StatsAfter.send_calls - StatsBefore.send_calls, (uint64_t)NumPackets);
+#endif
+
+	for(int i = 0; i < NumPackets; i++)
+	{
+		NETADDR Addr;
+		unsigned char *pData;
+		int Bytes = net_udp_recv(Socket1, &Addr, &pData);
+		if(Bytes <= 0)
+		{
+			// received packets may already be buffered, only wait when there are none
+			ASSERT_EQ(net_socket_read_wait(Socket1, 10s), 1);
+			Bytes = net_udp_recv(Socket1, &Addr, &pData);
+		}
+		ASSERT_EQ(Bytes, (int)sizeof(i));
+		EXPECT_EQ(mem_comp(pData, &i, sizeof(i)), 0);
+	}
+
+	net_udp_close(Socket1);
+	net_udp_close(Socket2);
+}
+
+TEST(Net, RecvQueue)
+{
+	std::unique_ptr<CNetRecvQueue> pQueue = std::make_unique<CNetRecvQueue>();
+	EXPECT_EQ(pQueue->Front(), nullptr);
+
+	// wrap around the ring a few times
+	for(int Round = 0; Round < 3; Round++)
+	{
+		for(int i = 0; i < CNetRecvQueue::SIZE; i++)
+		{
+			CNetRecvQueue::CPacket *pPacket = pQueue->BeginPush();
+			ASSERT_TRUE(pPacket);
+			pPacket->m_DataSize = i;
+			pQueue->EndPush();
+		}
+		EXPECT_EQ(pQueue->BeginPush(), nullptr);
+		EXPECT_EQ(pQueue->Num(), (int)CNetRecvQueue::SIZE);
+
+		for(int i = 0; i < CNetRecvQueue::SIZE; i++)
+		{
+			const CNetRecvQueue::CPacket *pPacket = pQueue->Front();
+			ASSERT_TRUE(pPacket);
+			EXPECT_EQ(pPacket->m_DataSize, i);
+			pQueue->Pop();
+		}
+		EXPECT_EQ(pQueue->Front(), nullptr);
+		EXPECT_EQ(pQueue->Num(), 0);
+	}
+}
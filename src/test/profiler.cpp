@@ -0,0 +1,92 @@
+#include "test.h"
+
+#include <base/system.h>
+
+#include <engine/shared/profiler.h>
+
+#include <gtest/gtest.h>
+
+TEST(Profiler, Disabled)
+{
+	CTickProfiler Profiler;
+	{
+		CProfileScope Profile(&Profiler, CTickProfiler::SECTION_SNAP);
+	}
+	Profiler.EndTick(1);
+	EXPECT_EQ(Profiler.Stats(CTickProfiler::SECTION_SNAP).m_NumSamples, 0);
+}
+
+TEST(Profiler, Percentiles)
+{
+	CTickProfiler Profiler;
+	Profiler.SetEnabled(true);
+	for(int i = 1; i <= 100; i++)
+	{
+		Profiler.Add(CTickProfiler::SECTION_SNAP, i * 1000);
+		Profiler.Add(CTickProfiler::SECTION_SNAP, i * 1000);
+		Profiler.EndTick(i);
+	}
+
+	CTickProfiler::CStats Stats = Profiler.Stats(CTickProfiler::SECTION_SNAP);
+	EXPECT_EQ(Stats.m_NumSamples, 100);
+	EXPECT_EQ(Stats.m_MedianNs, 100000);
+	EXPECT_EQ(Stats.m_P99Ns, 198000);
+	EXPECT_EQ(Stats.m_MaxNs, 200000);
+
+	Stats = Profiler.Stats(CTickProfiler::SECTION_NET_SEND);
+	EXPECT_EQ(Stats.m_NumSamples, 100);
+	EXPECT_EQ(Stats.m_MaxNs, 0);
+
+	Profiler.Reset();
+	EXPECT_EQ(Profiler.Stats(CTickProfiler::SECTION_SNAP).m_NumSamples, 0);
+}
+
+TEST(Profiler, History)
+{
+	CTickProfiler Profiler;
+	Profiler.SetEnabled(true);
+	for(int i = 0; i < CTickProfiler::HISTORY + 10; i++)
+	{
+		Profiler.Add(CTickProfiler::SECTION_GAME_TICK, i < 10 ? 1000000 : 1);
+		Profiler.EndTick(i);
+	}
+
+	// the oldest samples have been overwritten
+	CTickProfiler::CStats Stats = Profiler.Stats(CTickProfiler::SECTION_GAME_TICK);
+	EXPECT_EQ(Stats.m_NumSamples, CTickProfiler::HISTORY);
+	EXPECT_EQ(Stats.m_MaxNs, 1);
+}
+
+TEST(Profiler, Csv)
+{
+	CTestInfo Info;
+	IOHANDLE File = io_open(Info.m_aFilename, IOFLAG_WRITE);
+	ASSERT_TRUE(File);
+
+	CTickProfiler Profiler;
+	Profiler.SetEnabled(true);
+	Profiler.SetCsvFile(File);
+	EXPECT_TRUE(Profiler.HasCsvFile());
+	for(int i = 1; i <= 3; i++)
+	{
+		Profiler.Add(CTickProfiler::SECTION_SNAP, i * 1000);
+		Profiler.EndTick(i);
+	}
+	// closing waits until all rows are written
+	Profiler.SetCsvFile(nullptr);
+	EXPECT_FALSE(Profiler.HasCsvFile());
+
+	File = io_open(Info.m_aFilename, IOFLAG_READ);
+	ASSERT_TRUE(File);
+	char *pContents = io_read_all_str(File);
+	io_close(File);
+	ASSERT_TRUE(pContents);
+	EXPECT_TRUE(str_startswith(pContents, "tick,game_tick,"));
+	EXPECT_TRUE(str_find(pContents, "\n3,0.000,0.000,0.000,0.000,0.000,0.000,3.000,"));
+	int NumLines = 0;
+	for(const char *pChar = pContents; *pChar; pChar++)
+		NumLines += *pChar == '\n';
+	EXPECT_EQ(NumLines, 4);
+	free(pContents);
+	EXPECT_FALSE(fs_remove(Info.m_aFilename));
+}
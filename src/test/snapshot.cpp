@@ -1,11 +1,14 @@
 #include <base/system.h>
 
+#include <engine/shared/compression.h>
 #include <engine/shared/snapshot.h>
 
 #include <generated/protocol.h>
 
 #include <gtest/gtest.h>
 
+#include <limits>
+
 TEST(Snapshot, CrcOneInt)
 {
 	CSnapshotBuilder Builder;
@@ -85,3 +88,199 @@ TEST(Snapshot, CrcOverflow)
 
 	ASSERT_EQ(pSnapshot->Crc(), 1);
 }
+
+TEST(Snapshot, CopyItems)
+{
+	CSnapshotBuilder Shared;
+	Shared.Init();
+
+	CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Shared.NewItem(CNetObj_Flag::ms_MsgId, 1, sizeof(CNetObj_Flag)));
+	ASSERT_TRUE(pFlag);
+	pFlag->m_X = 1;
+	pFlag->m_Y = 2;
+	pFlag->m_Team = 3;
+	CNetObj_DDNetLaser *pLaser = static_cast<CNetObj_DDNetLaser *>(Shared.NewItem(CNetObj_DDNetLaser::ms_MsgId, 2, sizeof(CNetObj_DDNetLaser)));
+	ASSERT_TRUE(pLaser);
+	pLaser->m_ToX = 4;
+	pLaser->m_Type = 5;
+	// the extended item type is registered in front of the laser
+	ASSERT_EQ(Shared.NumItems(), 3);
+
+	CSnapshotBuilder Builder;
+	Builder.Init();
+	CNetObj_DDNetPickup *pPickup = static_cast<CNetObj_DDNetPickup *>(Builder.NewItem(CNetObj_DDNetPickup::ms_MsgId, 3, sizeof(CNetObj_DDNetPickup)));
+	ASSERT_TRUE(pPickup);
+	pPickup->m_X = 6;
+	ASSERT_TRUE(Builder.CopyItems(&Shared, 0, Shared.NumItems()));
+
+	char aData[CSnapshot::MAX_SIZE];
+	CSnapshot *pSnapshot = (CSnapshot *)aData;
+	Builder.Finish(pSnapshot);
+
+	// pickup type, pickup, flag, laser type and laser
+	ASSERT_EQ(pSnapshot->NumItems(), 5);
+	const CNetObj_Flag *pCopiedFlag = static_cast<const CNetObj_Flag *>(pSnapshot->FindItem(CNetObj_Flag::ms_MsgId, 1));
+	ASSERT_TRUE(pCopiedFlag);
+	EXPECT_EQ(pCopiedFlag->m_X, 1);
+	EXPECT_EQ(pCopiedFlag->m_Y, 2);
+	EXPECT_EQ(pCopiedFlag->m_Team, 3);
+	const CNetObj_DDNetLaser *pCopiedLaser = static_cast<const CNetObj_DDNetLaser *>(pSnapshot->FindItem(CNetObj_DDNetLaser::ms_MsgId, 2));
+	ASSERT_TRUE(pCopiedLaser);
+	EXPECT_EQ(pCopiedLaser->m_ToX, 4);
+	EXPECT_EQ(pCopiedLaser->m_Type, 5);
+	const CNetObj_DDNetPickup *pKeptPickup = static_cast<const CNetObj_DDNetPickup *>(pSnapshot->FindItem(CNetObj_DDNetPickup::ms_MsgId, 3));
+	ASSERT_TRUE(pKeptPickup);
+	EXPECT_EQ(pKeptPickup->m_X, 6);
+}
+
+TEST(Snapshot, DiffItem)
+{
+	// cover the vectorized part and the remainder of different sizes
+	int aPast[35];
+	int aCurrent[35];
+	for(int i = 0; i < 35; i++)
+	{
+		aPast[i] = (int)(i * 0x12345679u);
+		aCurrent[i] = i % 3 == 0 ? aPast[i] : (int)(i * 0x9abcdef1u);
+	}
+	aPast[0] = std::numeric_limits<int>::min();
+	aCurrent[0] = std::numeric_limits<int>::max();
+
+	for(int Size = 0; Size <= 35; Size++)
+	{
+		int aOut[35];
+		int Needed = CSnapshotDelta::DiffItem(aPast, aCurrent, aOut, Size);
+		int ExpectedNeeded = 0;
+		for(int i = 0; i < Size; i++)
+		{
+			const int Expected = (unsigned)aCurrent[i] - (unsigned)aPast[i];
+			EXPECT_EQ(aOut[i], Expected);
+			ExpectedNeeded |= Expected;
+		}
+		EXPECT_EQ(Needed, ExpectedNeeded);
+		EXPECT_EQ(CSnapshotDelta::DiffItem(aPast, aPast, aOut, Size), 0);
+	}
+}
+
+TEST(Snapshot, UnpackDelta)
+{
+	CSnapshotBuilder Builder;
+	char aFrom[CSnapshot::MAX_SIZE];
+	char aTo[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)aFrom;
+	CSnapshot *pTo = (CSnapshot *)aTo;
+
+	Builder.Init();
+	CNetObj_Character *pFromChar = static_cast<CNetObj_Character *>(Builder.NewItem(CNetObj_Character::ms_MsgId, 0, sizeof(CNetObj_Character)));
+	ASSERT_TRUE(pFromChar);
+	pFromChar->m_X = 100;
+	pFromChar->m_Y = -100;
+	pFromChar->m_Tick = 50;
+	Builder.Finish(pFrom);
+
+	Builder.Init();
+	CNetObj_Character *pToChar = static_cast<CNetObj_Character *>(Builder.NewItem(CNetObj_Character::ms_MsgId, 0, sizeof(CNetObj_Character)));
+	ASSERT_TRUE(pToChar);
+	pToChar->m_X = 164;
+	pToChar->m_Y = -100000;
+	pToChar->m_Tick = 50;
+	pToChar->m_Weapon = 3;
+	Builder.Finish(pTo);
+
+	CSnapshotDelta Delta;
+	char aDelta[CSnapshot::MAX_SIZE];
+	const int DeltaSize = Delta.CreateDelta(pFrom, pTo, aDelta);
+	ASSERT_GT(DeltaSize, 0);
+
+	char aUnpacked[CSnapshot::MAX_SIZE];
+	CSnapshot *pUnpacked = (CSnapshot *)aUnpacked;
+	const int UnpackedSize = Delta.UnpackDelta(pFrom, pUnpacked, aDelta, DeltaSize, false);
+	ASSERT_GT(UnpackedSize, 0);
+	ASSERT_EQ(pUnpacked->NumItems(), 1);
+	ASSERT_EQ(pUnpacked->GetItemSize(0), (int)sizeof(CNetObj_Character));
+	EXPECT_EQ(mem_comp(pUnpacked->GetItem(0)->Data(), pTo->GetItem(0)->Data(), sizeof(CNetObj_Character)), 0);
+
+	// unchanged ints count as one bit, changed ones as their packed size
+	uint64_t ExpectedDataRate = 0;
+	const int *pFromData = pFrom->GetItem(0)->Data();
+	const int *pToData = pTo->GetItem(0)->Data();
+	for(size_t i = 0; i < sizeof(CNetObj_Character) / sizeof(int); i++)
+	{
+		const int Diff = (unsigned)pToData[i] - (unsigned)pFromData[i];
+		if(Diff == 0)
+		{
+			ExpectedDataRate += 1;
+			continue;
+		}
+		unsigned char aBuf[CVariableInt::MAX_BYTES_PACKED];
+		ExpectedDataRate += (CVariableInt::Pack(aBuf, Diff, sizeof(aBuf)) - aBuf) * 8;
+	}
+	EXPECT_EQ(Delta.GetDataRate(CNetObj_Character::ms_MsgId), ExpectedDataRate);
+	EXPECT_EQ(Delta.GetDataUpdates(CNetObj_Character::ms_MsgId), 1u);
+}
+
+TEST(Snapshot, DeltaRoundTripManyItems)
+{
+	CSnapshotBuilder Builder;
+	char aFrom[CSnapshot::MAX_SIZE];
+	char aTo[CSnapshot::MAX_SIZE];
+	CSnapshot *pFrom = (CSnapshot *)aFrom;
+	CSnapshot *pTo = (CSnapshot *)aTo;
+
+	// ids 0..299 in the old snapshot, 100..399 in the new one, every third one changed
+	Builder.Init();
+	for(int i = 0; i < 300; i++)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, i, sizeof(CNetObj_Flag)));
+		ASSERT_TRUE(pFlag);
+		pFlag->m_X = i;
+		pFlag->m_Y = -i;
+		pFlag->m_Team = 0;
+	}
+	const int FromSize = Builder.Finish(pFrom);
+
+	Builder.Init();
+	for(int i = 399; i >= 100; i--)
+	{
+		CNetObj_Flag *pFlag = static_cast<CNetObj_Flag *>(Builder.NewItem(CNetObj_Flag::ms_MsgId, i, sizeof(CNetObj_Flag)));
+		ASSERT_TRUE(pFlag);
+		pFlag->m_X = i % 3 == 0 ? i * 7 : i;
+		pFlag->m_Y = -i;
+		pFlag->m_Team = 1;
+	}
+	Builder.Finish(pTo);
+
+	CSnapshotStorage Storage;
+	Storage.Init();
+	Storage.Add(1, 0, FromSize, pFrom, 0, nullptr);
+	const CSnapshot *pStored;
+	const CSnapshotItemTable *pTable = nullptr;
+	ASSERT_GE(Storage.Get(1, nullptr, &pStored, nullptr, &pTable), 0);
+	ASSERT_TRUE(pTable);
+	for(int i = 0; i < pFrom->NumItems(); i++)
+		EXPECT_EQ(pTable->Find(pFrom->GetItem(i)->Key()), pFrom->GetItemIndex(pFrom->GetItem(i)->Key()));
+	EXPECT_EQ(pTable->Find((CNetObj_Flag::ms_MsgId << 16) | 350), -1);
+
+	CSnapshotDelta Delta;
+	for(const CSnapshotItemTable *pFromTable : {(const CSnapshotItemTable *)nullptr, pTable})
+	{
+		char aDelta[CSnapshot::MAX_SIZE];
+		const int DeltaSize = Delta.CreateDelta(pStored, pTo, aDelta, pFromTable);
+		ASSERT_GT(DeltaSize, 0);
+		EXPECT_EQ(((CSnapshotDelta::CData *)aDelta)->m_NumDeletedItems, 100);
+
+		char aUnpacked[CSnapshot::MAX_SIZE];
+		CSnapshot *pUnpacked = (CSnapshot *)aUnpacked;
+		ASSERT_GT(Delta.UnpackDelta(pStored, pUnpacked, aDelta, DeltaSize, false, pFromTable), 0);
+		ASSERT_EQ(pUnpacked->NumItems(), pTo->NumItems());
+		for(int i = 0; i < pTo->NumItems(); i++)
+		{
+			const int Key = pTo->GetItem(i)->Key();
+			const int Index = pUnpacked->GetItemIndex(Key);
+			ASSERT_NE(Index, -1);
+			EXPECT_EQ(mem_comp(pUnpacked->GetItem(Index)->Data(), pTo->GetItem(i)->Data(), sizeof(CNetObj_Flag)), 0);
+		}
+	}
+
+	Storage.PurgeAll();
+}
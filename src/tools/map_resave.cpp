@@ -7,12 +7,15 @@
 #include <engine/shared/datafile.h>
 #include <engine/storage.h>
 
+#include <numeric>
+#include <vector>
+
 static const char *TOOL_NAME = "map_resave";
 
-static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStorage *pStorage)
+static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, CDataFileWriter::ECompressionLevel CompressionLevel, IStorage *pStorage)
 {
 	CDataFileReader Reader;
-	if(!Reader.Open(pStorage, pSourceMap, IStorage::TYPE_ABSOLUTE))
+	if(!Reader.Open(pStorage, pSourceMap, IStorage::TYPE_ABSOLUTE, true))
 	{
 		log_error(TOOL_NAME, "Failed to open source map '%s' for reading", pSourceMap);
 		return -1;
@@ -43,17 +46,35 @@ static int ResaveMap(const char *pSourceMap, const char *pDestinationMap, IStora
 		Writer.AddItem(Type, Id, Size, pPtr, &Uuid);
 	}
 
-	// add all data
+	// add all data, decompressing it serially up front so the decompression time is measured on its own
+	const int64_t DecompressStart = time_get();
+	std::vector<int> vIndices(Reader.NumData());
+	std::iota(vIndices.begin(), vIndices.end(), 0);
+	Reader.LoadData(nullptr, vIndices);
+	const int64_t DecompressEnd = time_get();
 	for(int Index = 0; Index < Reader.NumData(); Index++)
 	{
 		const void *pPtr = Reader.GetData(Index);
 		int Size = Reader.GetDataSize(Index);
-		Writer.AddData(Size, pPtr);
+		Writer.AddData(Size, pPtr, CompressionLevel);
 	}
 
+	const int SourceSize = Reader.MapSize();
 	Reader.Close();
+	const int64_t CompressStart = time_get();
 	Writer.Finish();
-	log_info(TOOL_NAME, "Resaved '%s' to '%s'", pSourceMap, pDestinationMap);
+	const int64_t CompressEnd = time_get();
+
+	int64_t DestinationSize = -1;
+	IOHANDLE File = pStorage->OpenFile(pDestinationMap, IOFLAG_READ, IStorage::TYPE_SAVE);
+	if(File)
+	{
+		DestinationSize = io_length(File);
+		io_close(File);
+	}
+	log_info(TOOL_NAME, "Resaved '%s' (%d bytes, decompressed in %.2fms) to '%s' (%" PRId64 " bytes, written in %.2fms)",
+		pSourceMap, SourceSize, (DecompressEnd - DecompressStart) * 1000.0 / time_freq(),
+		pDestinationMap, DestinationSize, (CompressEnd - CompressStart) * 1000.0 / time_freq());
 	return 0;
 }
 
@@ -62,9 +83,24 @@ int main(int argc, const char **argv)
 	CCmdlineFix CmdlineFix(&argc, &argv);
 	log_set_global_logger_default();
 
-	if(argc != 3)
+	const char *pSourceMap;
+	const char *pDestinationMap;
+	CDataFileWriter::ECompressionLevel CompressionLevel;
+	if(argc == 3)
+	{
+		pSourceMap = argv[1];
+		pDestinationMap = argv[2];
+		CompressionLevel = CDataFileWriter::COMPRESSION_DEFAULT;
+	}
+	else if(argc == 4 && str_comp(argv[1], "--best") == 0)
+	{
+		pSourceMap = argv[2];
+		pDestinationMap = argv[3];
+		CompressionLevel = CDataFileWriter::COMPRESSION_BEST;
+	}
+	else
 	{
-		log_error(TOOL_NAME, "Usage: %s <source map> <destination map>", TOOL_NAME);
+		log_error(TOOL_NAME, "Usage: %s [--best] <source map> <destination map>", TOOL_NAME);
 		return -1;
 	}
 
@@ -75,5 +111,5 @@ int main(int argc, const char **argv)
 		return -1;
 	}
 
-	return ResaveMap(argv[1], argv[2], pStorage.get());
+	return ResaveMap(pSourceMap, pDestinationMap, CompressionLevel, pStorage.get());
 }